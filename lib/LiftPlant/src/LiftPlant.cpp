@@ -0,0 +1,287 @@
+#include "LiftPlant.h"
+#include <Arduino.h>
+#include <random>
+
+#define NANOS_PER_SECOND 1000000000.0
+#define BOUNCE_EDGES_MAXIMAL 16
+
+// PLANT VALUES START
+namespace {
+
+struct switch_model {
+  const plant_switch *config;
+  bool triggered;       // mechanical state
+  uint64_t changed_at;  // [ns]
+  uint8_t  bounce_count; // even, so the chatter ends in the mechanical state
+  uint64_t bounce_at[BOUNCE_EDGES_MAXIMAL]; // [ns] sorted
+  uint64_t glitch_from; // [ns]
+  uint64_t glitch_until; // [ns]
+};
+
+plant_config config;
+plant_state  state;
+std::mt19937 random_numbers;
+
+switch_model end_stop;
+switch_model tool_length;
+float tool_length_trigger_height; // [mm] drawn again for every approach
+
+// the carriage sits anywhere between the nut and backlash below it, going up drags it from below
+float nut_height; // [mm]
+
+uint8_t  direction_level = LOW;
+uint8_t  step_level = LOW;
+uint64_t step_last_at = 0;   // [ns]
+int      step_last_direction = 0;
+float    step_last_speed = 0.0; // [steps per second]
+uint64_t resonance_entered_at = 0; // [ns] first of the steps in the resonance band
+plant_step_listener step_listener = nullptr;
+plant_switch_listener switch_listener = nullptr;
+
+} // namespace
+// PLANT VALUES END
+
+// SWITCHES START
+namespace {
+
+float uniform(float low, float high) {
+  return std::uniform_real_distribution<float>(low, high)(random_numbers);
+}
+
+void schedule_glitch(switch_model &model, uint64_t after) {
+  if (model.config->glitch_rate <= 0.0) {
+    model.glitch_from = model.glitch_until = UINT64_MAX;
+    return;
+  }
+  double pause = std::exponential_distribution<double>(model.config->glitch_rate)(random_numbers);
+  model.glitch_from  = after + (uint64_t)(pause * NANOS_PER_SECOND);
+  model.glitch_until = model.glitch_from + (uint64_t)(model.config->glitch_duration * 1000.0);
+}
+
+void change_switch(switch_model &model, bool triggered, uint64_t at) {
+  if (model.triggered == triggered) {
+    return;
+  }
+  model.triggered  = triggered;
+  model.changed_at = at;
+  if (switch_listener) {
+    switch_listener(model.config->pin, triggered, at);
+  }
+  uint8_t edges = model.config->bounce_edges / 2 * 2;
+  model.bounce_count = edges ? 2 * std::uniform_int_distribution<int>(0, edges / 2)(random_numbers) : 0;
+  for (uint8_t edge = 0; edge < model.bounce_count; edge++) {
+    model.bounce_at[edge] = at + (uint64_t)(uniform(0.0, model.config->bounce_duration) * 1000000.0);
+  }
+  std::sort(model.bounce_at, model.bounce_at + model.bounce_count);
+  if (model.bounce_count) {
+    state.bounces++;
+  }
+}
+
+// what the firmware reads at the given time, bounce and glitches included
+uint8_t switch_level(switch_model &model, uint64_t at) {
+  bool triggered = model.triggered;
+  if (at >= model.changed_at) {
+    uint8_t toggles = 0;
+    while (toggles < model.bounce_count && model.bounce_at[toggles] <= at) {
+      toggles++;
+    }
+    if (toggles % 2) {
+      triggered = !triggered;
+    }
+  }
+  while (model.glitch_until <= at) {
+    schedule_glitch(model, model.glitch_until);
+  }
+  if (model.glitch_from <= at) {
+    triggered = !triggered;
+  }
+  // a normally closed switch opens on trigger and the pull up wins
+  return triggered == model.config->normally_closed ? HIGH : LOW;
+}
+
+uint8_t read_end_stop(uint8_t pin, uint64_t at) {
+  return switch_level(end_stop, at);
+}
+
+uint8_t read_tool_length(uint8_t pin, uint64_t at) {
+  return switch_level(tool_length, at);
+}
+
+void update_switches(uint64_t at) {
+  if (state.height >= config.end_stop_height) {
+    change_switch(end_stop, true, at);
+  } else if (state.height < config.end_stop_height - config.end_stop_hysteresis) {
+    change_switch(end_stop, false, at);
+  }
+
+  if (config.tool_length_placed && state.height >= tool_length_trigger_height) {
+    if (!tool_length.triggered) {
+      state.tool_length_triggered_at = state.height;
+    }
+    change_switch(tool_length, true, at);
+  } else if (!config.tool_length_placed || state.height < config.tool_length_height - config.tool_length_repeatability) {
+    if (tool_length.triggered) {
+      // next approach triggers somewhere else
+      tool_length_trigger_height = config.tool_length_height
+                                   + uniform(-config.tool_length_repeatability, config.tool_length_repeatability) / 2;
+    }
+    change_switch(tool_length, false, at);
+  }
+  state.end_stop_triggered    = end_stop.triggered;
+  state.tool_length_triggered = tool_length.triggered;
+}
+
+} // namespace
+// SWITCHES END
+
+// MOTOR START
+namespace {
+
+// returns false when the motor cannot follow this step
+bool follows_step(uint64_t at, int direction) {
+  double interval = (at - step_last_at) / NANOS_PER_SECOND;
+  bool from_standstill = step_last_at == 0 || direction != step_last_direction
+                         || interval * 1000.0 >= config.resync_pause;
+  float speed = from_standstill ? 0.0 : 1.0 / interval;
+
+  bool resonating = !from_standstill && speed > config.resonance_lower && speed < config.resonance_upper;
+  if (!resonating) {
+    resonance_entered_at = at;
+  }
+
+  if (state.stalled && from_standstill) {
+    state.stalled = false;
+  }
+  if (!state.stalled && !from_standstill) {
+    bool too_fast  = speed > config.pull_out_speed;
+    bool too_steep = speed > config.pull_in_speed && (speed - step_last_speed) / interval > config.acceleration_maximal;
+    bool resonated = resonating && (at - resonance_entered_at) / NANOS_PER_SECOND * 1000.0 >= config.resonance_dwell;
+    if (too_fast || too_steep || resonated) {
+      state.stalled = true;
+      state.stalls++;
+    }
+  }
+
+  step_last_at        = at;
+  step_last_direction = direction;
+  step_last_speed     = speed;
+  state.speed         = speed * direction;
+  state.speed_maximal = max(state.speed_maximal, speed);
+  return !state.stalled;
+}
+
+void on_pin_write(uint8_t pin, uint8_t level, uint64_t at) {
+  if (pin == config.pin_direction) {
+    direction_level = level;
+    return;
+  }
+  if (pin != config.pin_step) {
+    return;
+  }
+  bool rising = level == HIGH && step_level == LOW;
+  step_level = level;
+  if (!rising) {
+    return;
+  }
+
+  state.steps++;
+  int direction = direction_level == HIGH ? config.direction : -config.direction;
+  float nut    = nut_height + direction * config.mm_per_step * (1 + config.pitch_error);
+  float height = constrain(state.height, nut - config.backlash, nut);
+  bool followed = follows_step(at, direction) && height >= config.height_minimal && height <= config.height_maximal;
+  if (step_listener) {
+    step_listener(at, direction, followed);
+  }
+  if (!followed) {
+    state.steps_lost++;
+    return;
+  }
+  nut_height   = nut;
+  state.height = height;
+  update_switches(at);
+}
+
+} // namespace
+// MOTOR END
+
+plant_config plant_default_config() {
+  plant_config defaults = {};
+  defaults.mm_per_step     = 8.0 / 400; // 8 mm thread pitch, 400 steps per revolution
+  defaults.direction       = -1;
+  defaults.height          = 20.0;
+  defaults.height_minimal  = -60.0;
+  defaults.height_maximal  = 85.0;
+  defaults.backlash        = 0.0;
+  defaults.pitch_error     = 0.0;
+
+  defaults.pull_in_speed        = 800;
+  defaults.pull_out_speed       = 4000;
+  defaults.acceleration_maximal = 20000;
+  defaults.resync_pause         = 50;
+  defaults.resonance_lower      = 0;
+  defaults.resonance_upper      = 0;
+  defaults.resonance_dwell      = 100;
+
+  defaults.end_stop        = { 0, true, 2.0, 6, 0.0, 20.0 };
+  defaults.end_stop_height = 80.0;
+  defaults.end_stop_hysteresis = 0.1;
+
+  defaults.tool_length = { 0, false, 1.0, 4, 0.0, 20.0 };
+  defaults.tool_length_enabled_normally_closed = false;
+  defaults.tool_length_placed        = false;
+  defaults.tool_length_height        = 30.0;
+  defaults.tool_length_repeatability = 0.02;
+
+  defaults.seed = 1;
+  return defaults;
+}
+
+void plant_begin(const plant_config &plant) {
+  config = plant;
+  state = {};
+  state.height = config.height;
+  nut_height   = config.height;
+  random_numbers.seed(config.seed);
+
+  end_stop    = { &config.end_stop, false, 0, 0, {}, 0, 0 };
+  tool_length = { &config.tool_length, false, 0, 0, {}, 0, 0 };
+  schedule_glitch(end_stop, 0);
+  schedule_glitch(tool_length, 0);
+  tool_length_trigger_height = config.tool_length_height;
+  update_switches(0);
+  // starting inside a switch does not chatter
+  end_stop.bounce_count = tool_length.bounce_count = 0;
+
+  hal_on_pin_write(on_pin_write);
+  hal_drive_input(config.end_stop.pin, read_end_stop);
+  hal_drive_input(config.tool_length.pin, read_tool_length);
+  plant_place_tool_length_sensor(config.tool_length_placed);
+}
+
+void plant_place_tool_length_sensor(bool placed) {
+  config.tool_length_placed = placed;
+  hal_set_input(config.pin_tool_length_enabled, placed != config.tool_length_enabled_normally_closed ? LOW : HIGH);
+  update_switches(hal_now_nano());
+}
+
+void plant_change_tool(float length_change) {
+  state.height           -= length_change;
+  nut_height             -= length_change;
+  config.end_stop_height -= length_change;
+  config.height_minimal  -= length_change;
+  config.height_maximal  -= length_change;
+  update_switches(hal_now_nano());
+}
+
+const plant_state &plant_status() {
+  return state;
+}
+
+void plant_on_step(plant_step_listener listener) {
+  step_listener = listener;
+}
+
+void plant_on_switch(plant_switch_listener listener) {
+  switch_listener = listener;
+}
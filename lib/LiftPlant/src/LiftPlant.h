@@ -0,0 +1,92 @@
+#ifndef LIFT_PLANT_H
+#define LIFT_PLANT_H
+
+#include <stdint.h>
+
+// Model of the router lift around the firmware running on the NativeHal:
+// STEP/DIR move the carriage along the lead screw, the carriage drives the
+// end stop and the tool length sensor inputs back. Heights are measured
+// upwards from the table top to the tip of the bit.
+
+// PLANT CONFIG START
+struct plant_switch {
+  uint8_t pin;
+  bool  normally_closed;
+  float bounce_duration; // [ms] contact chatters this long after every change
+  uint8_t bounce_edges;  // at most this many extra edges while chattering
+  float glitch_rate;     // [per second] spikes of the wiring picking up noise
+  float glitch_duration; // [us]
+};
+
+struct plant_config {
+  uint8_t pin_step;
+  uint8_t pin_direction;
+  uint8_t pin_tool_length_enabled;
+
+  float mm_per_step;     // [mm]
+  int   direction;       // [-1 or 1] carriage movement per step with DIR high
+  float height;          // [mm] where the carriage starts
+  float height_minimal;  // [mm] mechanical limits, steps beyond are lost
+  float height_maximal;  // [mm]
+  float backlash;        // [mm] the nut turns this far after a reversal before the carriage follows
+  float pitch_error;     // [mm per mm] the lead screw travels this much further than its nominal pitch
+
+  float pull_in_speed;         // [steps per second] starts from standstill without ramp
+  float pull_out_speed;        // [steps per second] faster steps are lost
+  float acceleration_maximal;  // [steps per second per second] above pull in speed
+  float resync_pause;          // [ms] a stalled motor catches steps again after this long without steps
+  float resonance_lower;       // [steps per second] stepping between the two speeds for resonance_dwell stalls the motor
+  float resonance_upper;       // [steps per second]
+  float resonance_dwell;       // [ms]
+
+  plant_switch end_stop;
+  float end_stop_height;     // [mm] triggers at and above
+  float end_stop_hysteresis; // [mm]
+
+  plant_switch tool_length;
+  bool  tool_length_enabled_normally_closed;
+  bool  tool_length_placed;      // sensor lies on the table
+  float tool_length_height;      // [mm] top of the sensor
+  float tool_length_repeatability; // [mm] trigger height spreads this much per approach
+
+  uint32_t seed;
+};
+// PLANT CONFIG END
+
+// PLANT STATE START
+struct plant_state {
+  float height;      // [mm] tip of the bit
+  long  steps;       // STEP pulses seen
+  long  steps_lost;  // pulses the carriage did not follow
+  long  stalls;      // times the motor stalled
+  bool  stalled;
+  float speed;       // [steps per second] of the last step, signed by direction
+  float speed_maximal; // [steps per second]
+  bool  end_stop_triggered;   // mechanical state without bounce and glitches
+  bool  tool_length_triggered;
+  float tool_length_triggered_at; // [mm] height of the last trigger
+  long  bounces;              // changes that chattered
+};
+// PLANT STATE END
+
+plant_config plant_default_config();
+
+// attaches to the pins, call before hal_begin()
+void plant_begin(const plant_config &config);
+
+// sensor presence and the like may change between hal_run_for() calls
+void plant_place_tool_length_sensor(bool placed);
+// a longer bit reaches further down: the tip drops, the end stop and the limits seen from the tip with it
+void plant_change_tool(float length_change); // [mm] longer is positive
+
+const plant_state &plant_status();
+
+// called on every rising STEP edge with its virtual time in [ns], direction in carriage movement
+typedef void (*plant_step_listener)(uint64_t at, int direction, bool followed);
+void plant_on_step(plant_step_listener listener);
+
+// called on every mechanical change of a switch, before its bounce, with the pin of the switch
+typedef void (*plant_switch_listener)(uint8_t pin, bool triggered, uint64_t at);
+void plant_on_switch(plant_switch_listener listener);
+
+#endif // LIFT_PLANT_H
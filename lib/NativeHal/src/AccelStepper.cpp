@@ -0,0 +1,236 @@
+#include "AccelStepper.h"
+
+AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, bool enable) {
+  _direction = DIRECTION_CCW;
+  _pin[0] = pin1;
+  _pin[1] = pin2;
+  _pinInverted[0] = false;
+  _pinInverted[1] = false;
+  _enablePin = 0xff;
+  _enableInverted = false;
+  _currentPos = 0;
+  _targetPos = 0;
+  _speed = 0.0;
+  _maxSpeed = 0.0;
+  _acceleration = 0.0;
+  _stepInterval = 0;
+  _lastStepTime = 0;
+  _minPulseWidth = 1;
+  _n = 0;
+  _c0 = 0.0;
+  _cn = 0.0;
+  _cmin = 1.0;
+  if (enable) {
+    enableOutputs();
+  }
+  setAcceleration(1);
+  setMaxSpeed(1);
+}
+
+void AccelStepper::moveTo(long absolute) {
+  if (_targetPos != absolute) {
+    _targetPos = absolute;
+    computeNewSpeed();
+  }
+}
+
+void AccelStepper::move(long relative) {
+  moveTo(_currentPos + relative);
+}
+
+bool AccelStepper::runSpeed() {
+  if (!_stepInterval) {
+    return false;
+  }
+  unsigned long time = micros();
+  if (time - _lastStepTime >= _stepInterval) {
+    _currentPos += _direction == DIRECTION_CW ? 1 : -1;
+    step(_currentPos);
+    _lastStepTime = time;
+    return true;
+  }
+  return false;
+}
+
+void AccelStepper::computeNewSpeed() {
+  long distanceTo = distanceToGo();
+  long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration));
+
+  if (distanceTo == 0 && stepsToStop <= 1) {
+    // at the target and slow enough to stop
+    _stepInterval = 0;
+    _speed = 0.0;
+    _n = 0;
+    return;
+  }
+
+  if (distanceTo > 0) {
+    if (_n > 0) {
+      // accelerating, start slowing down when the target comes close or it runs the wrong way
+      if (stepsToStop >= distanceTo || _direction == DIRECTION_CCW) {
+        _n = -stepsToStop;
+      }
+    } else if (_n < 0) {
+      // slowing down, accelerate again when the target moved away
+      if (stepsToStop < distanceTo && _direction == DIRECTION_CW) {
+        _n = -_n;
+      }
+    }
+  } else if (distanceTo < 0) {
+    if (_n > 0) {
+      if (stepsToStop >= -distanceTo || _direction == DIRECTION_CW) {
+        _n = -stepsToStop;
+      }
+    } else if (_n < 0) {
+      if (stepsToStop < -distanceTo && _direction == DIRECTION_CCW) {
+        _n = -_n;
+      }
+    }
+  }
+
+  if (_n == 0) {
+    // first step from standstill
+    _cn = _c0;
+    _direction = distanceTo > 0 ? DIRECTION_CW : DIRECTION_CCW;
+  } else {
+    _cn = _cn - ((2.0 * _cn) / ((4.0 * _n) + 1));
+    _cn = max(_cn, _cmin);
+  }
+  _n++;
+  _stepInterval = _cn;
+  _speed = 1000000.0 / _cn;
+  if (_direction == DIRECTION_CCW) {
+    _speed = -_speed;
+  }
+}
+
+bool AccelStepper::run() {
+  if (runSpeed()) {
+    computeNewSpeed();
+  }
+  return _speed != 0.0 || distanceToGo() != 0;
+}
+
+void AccelStepper::setMaxSpeed(float speed) {
+  if (speed < 0.0) {
+    speed = -speed;
+  }
+  if (_maxSpeed != speed) {
+    _maxSpeed = speed;
+    _cmin = 1000000.0 / speed;
+    if (_n > 0) {
+      // recompute where slowing down starts
+      _n = (long)((_speed * _speed) / (2.0 * _acceleration));
+      computeNewSpeed();
+    }
+  }
+}
+
+void AccelStepper::setAcceleration(float acceleration) {
+  if (acceleration == 0.0) {
+    return;
+  }
+  if (acceleration < 0.0) {
+    acceleration = -acceleration;
+  }
+  if (_acceleration != acceleration) {
+    _n = _n * (_acceleration / acceleration);
+    // equation 15 with the 0.676 correction of equation 7
+    _c0 = 0.676 * sqrt(2.0 / acceleration) * 1000000.0;
+    _acceleration = acceleration;
+    computeNewSpeed();
+  }
+}
+
+void AccelStepper::setSpeed(float speed) {
+  if (speed == _speed) {
+    return;
+  }
+  speed = constrain(speed, -_maxSpeed, _maxSpeed);
+  if (speed == 0.0) {
+    _stepInterval = 0;
+  } else {
+    _stepInterval = fabs(1000000.0 / speed);
+    _direction = speed > 0.0 ? DIRECTION_CW : DIRECTION_CCW;
+  }
+  _speed = speed;
+}
+
+void AccelStepper::setCurrentPosition(long position) {
+  _targetPos = _currentPos = position;
+  _n = 0;
+  _stepInterval = 0;
+  _speed = 0.0;
+}
+
+void AccelStepper::runToPosition() {
+  while (run()) {
+    taskYIELD();
+  }
+}
+
+bool AccelStepper::runSpeedToPosition() {
+  if (_targetPos == _currentPos) {
+    return false;
+  }
+  _direction = _targetPos > _currentPos ? DIRECTION_CW : DIRECTION_CCW;
+  return runSpeed();
+}
+
+void AccelStepper::runToNewPosition(long position) {
+  moveTo(position);
+  runToPosition();
+}
+
+void AccelStepper::stop() {
+  if (_speed != 0.0) {
+    long stepsToStop = (long)((_speed * _speed) / (2.0 * _acceleration)) + 1;
+    move(_speed > 0 ? stepsToStop : -stepsToStop);
+  }
+}
+
+void AccelStepper::setEnablePin(uint8_t enable_pin) {
+  _enablePin = enable_pin;
+  if (_enablePin != 0xff) {
+    pinMode(_enablePin, OUTPUT);
+    digitalWrite(_enablePin, HIGH ^ _enableInverted);
+  }
+}
+
+void AccelStepper::setPinsInverted(bool direction_invert, bool step_invert, bool enable_invert) {
+  _pinInverted[0] = step_invert;
+  _pinInverted[1] = direction_invert;
+  _enableInverted = enable_invert;
+}
+
+void AccelStepper::disableOutputs() {
+  setOutputPins(0);
+  if (_enablePin != 0xff) {
+    pinMode(_enablePin, OUTPUT);
+    digitalWrite(_enablePin, LOW ^ _enableInverted);
+  }
+}
+
+void AccelStepper::enableOutputs() {
+  pinMode(_pin[0], OUTPUT);
+  pinMode(_pin[1], OUTPUT);
+  if (_enablePin != 0xff) {
+    pinMode(_enablePin, OUTPUT);
+    digitalWrite(_enablePin, HIGH ^ _enableInverted);
+  }
+}
+
+// bit 0 is STEP, bit 1 is DIR
+void AccelStepper::setOutputPins(uint8_t mask) {
+  for (uint8_t pin = 0; pin < 2; pin++) {
+    digitalWrite(_pin[pin], (mask & (1 << pin)) ? (HIGH ^ _pinInverted[pin]) : (LOW ^ _pinInverted[pin]));
+  }
+}
+
+void AccelStepper::step(long step) {
+  // DIR first, then a STEP pulse of at least _minPulseWidth
+  setOutputPins(_direction ? 0b10 : 0b00);
+  setOutputPins(_direction ? 0b11 : 0b01);
+  delayMicroseconds(_minPulseWidth);
+  setOutputPins(_direction ? 0b10 : 0b00);
+}
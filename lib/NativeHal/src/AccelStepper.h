@@ -0,0 +1,78 @@
+#ifndef ACCELSTEPPER_H
+#define ACCELSTEPPER_H
+
+#include <Arduino.h>
+
+// DRIVER interface of AccelStepper with the same speed profile (D. Austin,
+// "Generate stepper-motor speed profiles in real time"), so step timing on
+// the host matches the firmware on the board
+class AccelStepper {
+  public:
+    typedef enum {
+      FUNCTION  = 0,
+      DRIVER    = 1,
+      FULL2WIRE = 2
+    } MotorInterfaceType;
+
+    typedef enum {
+      DIRECTION_CCW = 0,
+      DIRECTION_CW  = 1
+    } Direction;
+
+    AccelStepper(uint8_t interface = DRIVER, uint8_t pin1 = 2, uint8_t pin2 = 3, uint8_t pin3 = 4, uint8_t pin4 = 5, bool enable = true);
+    virtual ~AccelStepper() {}
+
+    void moveTo(long absolute);
+    void move(long relative);
+    bool run();
+    bool runSpeed();
+    void setMaxSpeed(float speed);
+    float maxSpeed() { return _maxSpeed; }
+    void setAcceleration(float acceleration);
+    float acceleration() { return _acceleration; }
+    void setSpeed(float speed);
+    float speed() { return _speed; }
+    long distanceToGo() { return _targetPos - _currentPos; }
+    long targetPosition() { return _targetPos; }
+    long currentPosition() { return _currentPos; }
+    void setCurrentPosition(long position);
+    void runToPosition();
+    bool runSpeedToPosition();
+    void runToNewPosition(long position);
+    void stop();
+    bool isRunning() { return !(_speed == 0.0 && _targetPos == _currentPos); }
+
+    void setMinPulseWidth(unsigned int minimal_width) { _minPulseWidth = minimal_width; }
+    void setEnablePin(uint8_t enable_pin = 0xff);
+    void setPinsInverted(bool direction_invert = false, bool step_invert = false, bool enable_invert = false);
+    void disableOutputs();
+    void enableOutputs();
+
+  protected:
+    void computeNewSpeed();
+    // virtual like in the library, so a driver may write the pins its own way
+    virtual void setOutputPins(uint8_t mask);
+    virtual void step(long step);
+
+    Direction _direction;
+
+  private:
+    uint8_t _pin[2];
+    bool _pinInverted[2];
+    uint8_t _enablePin;
+    bool _enableInverted;
+    long _currentPos;
+    long _targetPos;
+    float _speed;        // [steps per second], negative is counter clockwise
+    float _maxSpeed;
+    float _acceleration;
+    unsigned long _stepInterval; // [us]
+    unsigned long _lastStepTime; // [us]
+    unsigned int _minPulseWidth; // [us]
+    long _n;     // step number of the profile, negative while slowing down
+    float _c0;   // [us] initial step interval
+    float _cn;   // [us] last step interval
+    float _cmin; // [us] step interval at maximal speed
+};
+
+#endif // ACCELSTEPPER_H
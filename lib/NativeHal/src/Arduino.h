@@ -0,0 +1,124 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Host stand-in for the parts of the ESP32 Arduino core and FreeRTOS the
+// firmware uses. Time is virtual, see hal.h.
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Print.h"
+#include "hal.h"
+
+using std::min;
+using std::max;
+
+// ARDUINO CORE START
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define PULLUP         0x04
+#define INPUT_PULLUP   0x05
+#define PULLDOWN       0x08
+#define INPUT_PULLDOWN 0x09
+
+#define IRAM_ATTR
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+template <typename T, typename L, typename H>
+auto constrain(T value, L low, H high) -> decltype(value + low + high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int  digitalRead(uint8_t pin);
+
+unsigned long micros();
+unsigned long millis();
+void delay(uint32_t duration);             // [ms] sleeps like vTaskDelay
+void delayMicroseconds(uint32_t duration); // [us] busy waits
+
+// entry points of the sketch
+void setup();
+void loop();
+
+class HardwareSerial : public Print {
+  public:
+    void begin(unsigned long baud) {}
+    int available();
+    int read();
+    size_t write(uint8_t character) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+// ARDUINO CORE END
+
+// FREERTOS START
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+
+#define configMAX_PRIORITIES 25
+#define configTICK_RATE_HZ   1000
+#define portTICK_PERIOD_MS   (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY        0xffffffffUL
+#define pdMS_TO_TICKS(ms)    ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define tskNO_AFFINITY       0x7fffffff
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+void taskYIELD();
+TickType_t xTaskGetTickCount();
+BaseType_t xPortGetCoreID();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task); // [bytes] the stack size, host stacks are not measured
+
+// nothing else runs on the core of the caller until the section ends, like interrupts being off;
+// the other core keeps running, the firmware only shares the locked values within one core
+struct portMUX_TYPE {
+  uint32_t nesting;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)      vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)  vPortExitCritical(mux)
+// FREERTOS END
+
+// HARDWARE TIMER START
+// timer of the ESP32 core, counting the 80 MHz APB clock through the divider; the interrupt
+// runs on the core that attached it, above every task, once the running task reaches a yield point
+#define HAL_APB_CLOCK 80000000 // [Hz]
+
+struct hw_timer_t;
+
+hw_timer_t *timerBegin(uint8_t number, uint16_t divider, bool count_up);
+void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm, bool autoreload); // [counts]
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+bool timerAlarmEnabled(hw_timer_t *timer);
+void timerWrite(hw_timer_t *timer, uint64_t count);
+// HARDWARE TIMER END
+
+#endif // ARDUINO_H
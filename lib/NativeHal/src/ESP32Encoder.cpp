@@ -0,0 +1,33 @@
+#include "ESP32Encoder.h"
+#include "hal.h"
+
+puType ESP32Encoder::useInternalWeakPullResistors = DOWN;
+ESP32Encoder *ESP32Encoder::encoders[ESP32ENCODER_COUNT] = {};
+
+void ESP32Encoder::attach() {
+  if (attached) {
+    return;
+  }
+  for (ESP32Encoder *&slot : encoders) {
+    if (!slot) {
+      slot = this;
+      attached = true;
+      return;
+    }
+  }
+}
+
+void ESP32Encoder::detach() {
+  for (ESP32Encoder *&slot : encoders) {
+    if (slot == this) {
+      slot = nullptr;
+    }
+  }
+  attached = false;
+}
+
+void hal_encoder_turn(uint8_t index, long counts) {
+  if (index < ESP32ENCODER_COUNT && ESP32Encoder::encoders[index]) {
+    ESP32Encoder::encoders[index]->turn(counts);
+  }
+}
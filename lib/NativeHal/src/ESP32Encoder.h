@@ -0,0 +1,46 @@
+#ifndef ESP32ENCODER_H
+#define ESP32ENCODER_H
+
+#include <atomic>
+#include <stdint.h>
+
+#define ESP32ENCODER_COUNT 8
+
+enum puType {
+  UP,
+  DOWN,
+  NONE
+};
+
+// counts what hal_encoder_turn() reports instead of the PCNT unit
+class ESP32Encoder {
+  public:
+    static puType useInternalWeakPullResistors;
+    static ESP32Encoder *encoders[ESP32ENCODER_COUNT];
+
+    void attachHalfQuad(int a, int b)   { attach(); }
+    void attachFullQuad(int a, int b)   { attach(); }
+    void attachSingleEdge(int a, int b) { attach(); }
+    void detach();
+
+    int64_t getCount() { return paused ? paused_at : count.load(); }
+    int64_t clearCount() { count = 0; return 0; }
+    int64_t setCount(int64_t value) { count = value; return value; }
+    int64_t pauseCount() { paused_at = count.load(); paused = true; return paused_at; }
+    int64_t resumeCount() { paused = false; return count.load(); }
+
+    bool isAttached() { return attached; }
+
+    // called by hal_encoder_turn()
+    void turn(long counts) { if (!paused) count += counts; }
+
+  private:
+    void attach();
+
+    std::atomic<int64_t> count{0};
+    int64_t paused_at = 0;
+    bool paused = false;
+    bool attached = false;
+};
+
+#endif // ESP32ENCODER_H
@@ -0,0 +1,91 @@
+#include "Preferences.h"
+#include "Arduino.h"
+#include "hal.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::map<std::string, std::vector<uint8_t>> preference_namespace;
+
+std::map<std::string, preference_namespace> &storage() {
+  static std::map<std::string, preference_namespace> namespaces;
+  return namespaces;
+}
+
+uint32_t write_cost = 0; // [us]
+
+} // namespace
+
+bool Preferences::begin(const char *name, bool read_only, const char *partition) {
+  if (opened || !name) {
+    return false;
+  }
+  opened = name;
+  this->read_only = read_only;
+  return true;
+}
+
+void Preferences::end() {
+  opened = NULL;
+}
+
+bool Preferences::clear() {
+  if (!opened || read_only) {
+    return false;
+  }
+  storage()[opened].clear();
+  delayMicroseconds(write_cost);
+  return true;
+}
+
+bool Preferences::remove(const char *key) {
+  if (!opened || read_only) {
+    return false;
+  }
+  delayMicroseconds(write_cost);
+  return storage()[opened].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char *key) {
+  return opened && storage()[opened].count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length) {
+  if (!opened || read_only || !key) {
+    return 0;
+  }
+  const uint8_t *bytes = (const uint8_t *)value;
+  storage()[opened][key].assign(bytes, bytes + length);
+  delayMicroseconds(write_cost);
+  return length;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  if (!opened || !key) {
+    return 0;
+  }
+  preference_namespace &values = storage()[opened];
+  auto found = values.find(key);
+  return found == values.end() ? 0 : found->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t length) {
+  size_t stored = getBytesLength(key);
+  if (!stored || stored > length) {
+    return 0;
+  }
+  const std::vector<uint8_t> &bytes = storage()[opened][key];
+  std::copy(bytes.begin(), bytes.end(), (uint8_t *)buffer);
+  return stored;
+}
+
+void hal_preferences_reset() {
+  storage().clear();
+}
+
+void hal_set_preferences_write_cost(uint32_t cost) {
+  write_cost = cost;
+}
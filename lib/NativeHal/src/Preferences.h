@@ -0,0 +1,52 @@
+#ifndef PREFERENCES_H
+#define PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// keeps the namespaces in memory for the lifetime of the process, values are stored as raw bytes like NVS blobs
+class Preferences {
+  public:
+    bool begin(const char *name, bool read_only = false, const char *partition = NULL);
+    void end();
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putBool(const char *key, bool value)                { return putBytes(key, &value, sizeof(value)); }
+    size_t putInt(const char *key, int32_t value)              { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char *key, uint32_t value)            { return putBytes(key, &value, sizeof(value)); }
+    size_t putLong(const char *key, int32_t value)             { return putBytes(key, &value, sizeof(value)); }
+    size_t putULong(const char *key, uint32_t value)           { return putBytes(key, &value, sizeof(value)); }
+    size_t putLong64(const char *key, int64_t value)           { return putBytes(key, &value, sizeof(value)); }
+    size_t putULong64(const char *key, uint64_t value)         { return putBytes(key, &value, sizeof(value)); }
+    size_t putFloat(const char *key, float value)              { return putBytes(key, &value, sizeof(value)); }
+    size_t putDouble(const char *key, double value)            { return putBytes(key, &value, sizeof(value)); }
+    size_t putBytes(const char *key, const void *value, size_t length);
+
+    bool     getBool(const char *key, bool fallback = false)            { return get(key, fallback); }
+    int32_t  getInt(const char *key, int32_t fallback = 0)              { return get(key, fallback); }
+    uint32_t getUInt(const char *key, uint32_t fallback = 0)            { return get(key, fallback); }
+    int32_t  getLong(const char *key, int32_t fallback = 0)             { return get(key, fallback); }
+    uint32_t getULong(const char *key, uint32_t fallback = 0)           { return get(key, fallback); }
+    int64_t  getLong64(const char *key, int64_t fallback = 0)           { return get(key, fallback); }
+    uint64_t getULong64(const char *key, uint64_t fallback = 0)         { return get(key, fallback); }
+    float    getFloat(const char *key, float fallback = NAN_FALLBACK)   { return get(key, fallback); }
+    double   getDouble(const char *key, double fallback = NAN_FALLBACK) { return get(key, fallback); }
+    size_t   getBytesLength(const char *key);
+    size_t   getBytes(const char *key, void *buffer, size_t length);
+
+  private:
+    static constexpr float NAN_FALLBACK = __builtin_nanf("");
+
+    template <typename T>
+    T get(const char *key, T fallback) {
+      T value;
+      return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : fallback;
+    }
+
+    const char *opened = NULL;
+    bool read_only = false;
+};
+
+#endif // PREFERENCES_H
@@ -0,0 +1,57 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+// same formatting as the Arduino core for the overloads the firmware uses
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t character) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      size_t written = 0;
+      while (size--) {
+        written += write(*buffer++);
+      }
+      return written;
+    }
+
+    size_t write(const char *text) {
+      return text ? write((const uint8_t *)text, strlen(text)) : 0;
+    }
+
+    __attribute__((format(printf, 2, 3)))
+    size_t printf(const char *format, ...) {
+      char buffer[128];
+      va_list arguments;
+      va_start(arguments, format);
+      int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+      va_end(arguments);
+      if (length < 0) {
+        return 0;
+      }
+      return write((const uint8_t *)buffer, (size_t)length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+
+    size_t print(const char *text)  { return write(text); }
+    size_t print(char character)    { return write((uint8_t)character); }
+    size_t print(int value, int base = DEC)           { return print((long)value, base); }
+    size_t print(unsigned value, int base = DEC)      { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC)          { return base == DEC ? printf("%ld", value) : printf("%lx", value); }
+    size_t print(unsigned long value, int base = DEC) { return base == DEC ? printf("%lu", value) : printf("%lx", value); }
+    size_t print(double value, int digits = 2)        { return printf("%.*f", digits, value); }
+
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+#endif // PRINT_H
@@ -0,0 +1,271 @@
+#include "U8g2lib.h"
+
+const u8g2_cb_t u8g2_cb_r0 = { 0 };
+const u8g2_cb_t u8g2_cb_r1 = { 1 };
+const u8g2_cb_t u8g2_cb_r2 = { 2 };
+const u8g2_cb_t u8g2_cb_r3 = { 3 };
+
+// cap height, glyph width and advance of the stand-in fonts [pixels]
+const uint8_t u8g2_font_helvB08_tf[] = { 7, 5, 6 };
+const uint8_t u8g2_font_helvB10_tf[] = { 8, 6, 8 };
+const uint8_t u8g2_font_helvB12_tf[] = { 9, 7, 9 };
+const uint8_t u8g2_font_helvB14_tf[] = { 10, 8, 11 };
+const uint8_t u8g2_font_helvB18_tf[] = { 13, 10, 13 };
+
+// FONT START
+#define GLYPH_FIRST   ' '
+#define GLYPH_LAST    '~'
+#define GLYPH_COLUMNS 5
+#define GLYPH_ROWS    7
+
+// classic 5x7 font, one byte per column with bit 0 on top
+const uint8_t glyphs[GLYPH_LAST - GLYPH_FIRST + 1][GLYPH_COLUMNS] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, // space ! "
+  { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, // # $ %
+  { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, { 0x00, 0x1c, 0x22, 0x41, 0x00 }, // & ' (
+  { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x08, 0x2a, 0x1c, 0x2a, 0x08 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 }, // ) * +
+  { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, // , - .
+  { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 }, // / 0 1
+  { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 }, { 0x18, 0x14, 0x12, 0x7f, 0x10 }, // 2 3 4
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 5 6 7
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, // 8 9 :
+  { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, // ; < =
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3e }, // > ? @
+  { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 }, // A B C
+  { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x01, 0x01 }, // D E F
+  { 0x3e, 0x41, 0x41, 0x51, 0x32 }, { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 }, // G H I
+  { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 }, { 0x7f, 0x40, 0x40, 0x40, 0x40 }, // J K L
+  { 0x7f, 0x02, 0x04, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e }, // M N O
+  { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 }, // P Q R
+  { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f }, // S T U
+  { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x7f, 0x20, 0x18, 0x20, 0x7f }, { 0x63, 0x14, 0x08, 0x14, 0x63 }, // V W X
+  { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 }, // Y Z [
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, // \ ] ^
+  { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, // _ ` a
+  { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7f }, // b c d
+  { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x08, 0x14, 0x54, 0x54, 0x3c }, // e f g
+  { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3d, 0x00 }, // h i j
+  { 0x00, 0x7f, 0x10, 0x28, 0x44 }, { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 }, // k l m
+  { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0x7c, 0x14, 0x14, 0x14, 0x08 }, // n o p
+  { 0x08, 0x14, 0x14, 0x18, 0x7c }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 }, // q r s
+  { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c }, // t u v
+  { 0x3c, 0x40, 0x30, 0x40, 0x3c }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c }, // w x y
+  { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7f, 0x00, 0x00 }, // z { |
+  { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x02, 0x01, 0x02, 0x04, 0x02 },                                   // } ~
+};
+// FONT END
+
+U8G2::U8G2(const u8g2_cb_t *rotation, uint16_t width, uint16_t height) : width(width), height(height) {
+  buffer = new uint8_t[width * height / 8]();
+}
+
+U8G2::~U8G2() {
+  delete[] buffer;
+}
+
+// FRAME START
+void U8G2::clearBuffer() {
+  cleared++;
+  memset(buffer, 0, width * height / 8);
+}
+
+// the SSD1306 gets the whole buffer every time, page by page
+void U8G2::sendBuffer() {
+  frames++;
+  unsigned long page_data  = width;
+  unsigned long transfers  = 1 + (page_data + U8G2_I2C_DATA_CHUNK - 1) / U8G2_I2C_DATA_CHUNK;
+  unsigned long page_bytes = U8G2_I2C_PAGE_COMMANDS + page_data + transfers * U8G2_I2C_TRANSFER_BYTES;
+  unsigned long frame_bytes = page_bytes * (height / 8);
+  unsigned long frame_bits  = frame_bytes * U8G2_I2C_BITS_PER_BYTE + transfers * (height / 8) * U8G2_I2C_FRAMING_BITS;
+  uint32_t duration = (uint32_t)((frame_bits * 1000000ULL + U8G2_I2C_CLOCK - 1) / U8G2_I2C_CLOCK); // [us]
+  i2c_bytes += frame_bytes;
+  i2c_time  += duration;
+  // Wire blocks the calling task for as long as the bus needs
+  delayMicroseconds(duration);
+}
+// FRAME END
+
+// PRIMITIVES START
+void U8G2::set_pixel(int16_t x, int16_t y) {
+  if (x < 0 || y < 0 || x >= width || y >= height) {
+    return;
+  }
+  uint8_t &column = buffer[(y / 8) * width + x];
+  uint8_t bit = 1 << (y % 8);
+  if (draw_color == 0) {
+    column &= ~bit;
+  } else if (draw_color == 2) {
+    column ^= bit;
+  } else {
+    column |= bit;
+  }
+  pixels++;
+}
+
+bool U8G2::getPixel(int16_t x, int16_t y) {
+  if (x < 0 || y < 0 || x >= width || y >= height) {
+    return false;
+  }
+  return buffer[(y / 8) * width + x] & (1 << (y % 8));
+}
+
+void U8G2::horizontal_line(int16_t x, int16_t y, int16_t length) {
+  for (int16_t offset = 0; offset < length; offset++) {
+    set_pixel(x + offset, y);
+  }
+}
+
+void U8G2::vertical_line(int16_t x, int16_t y, int16_t length) {
+  for (int16_t offset = 0; offset < length; offset++) {
+    set_pixel(x, y + offset);
+  }
+}
+
+// Bresenham, both end points are drawn
+void U8G2::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  primitives++;
+  int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int16_t error = dx + dy;
+  while (true) {
+    set_pixel(x0, y0);
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int16_t doubled = 2 * error;
+    if (doubled >= dy) {
+      error += dy;
+      x0 += sx;
+    }
+    if (doubled <= dx) {
+      error += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void U8G2::drawBox(int16_t x, int16_t y, int16_t width, int16_t height) {
+  primitives++;
+  for (int16_t row = 0; row < height; row++) {
+    horizontal_line(x, y + row, width);
+  }
+}
+
+void U8G2::drawFrame(int16_t x, int16_t y, int16_t width, int16_t height) {
+  primitives++;
+  horizontal_line(x, y, width);
+  horizontal_line(x, y + height - 1, width);
+  vertical_line(x, y + 1, height - 2);
+  vertical_line(x + width - 1, y + 1, height - 2);
+}
+
+// one octant step of the midpoint circle, mirrored into the quadrants of option like u8g2 does
+void U8G2::circle_section(int16_t x, int16_t y, int16_t x0, int16_t y0, uint8_t option, bool filled) {
+  if (option & U8G2_DRAW_UPPER_RIGHT) {
+    if (filled) {
+      vertical_line(x0 + x, y0 - y, y + 1);
+      vertical_line(x0 + y, y0 - x, x + 1);
+    } else {
+      set_pixel(x0 + x, y0 - y);
+      set_pixel(x0 + y, y0 - x);
+    }
+  }
+  if (option & U8G2_DRAW_UPPER_LEFT) {
+    if (filled) {
+      vertical_line(x0 - x, y0 - y, y + 1);
+      vertical_line(x0 - y, y0 - x, x + 1);
+    } else {
+      set_pixel(x0 - x, y0 - y);
+      set_pixel(x0 - y, y0 - x);
+    }
+  }
+  if (option & U8G2_DRAW_LOWER_RIGHT) {
+    if (filled) {
+      vertical_line(x0 + x, y0, y + 1);
+      vertical_line(x0 + y, y0, x + 1);
+    } else {
+      set_pixel(x0 + x, y0 + y);
+      set_pixel(x0 + y, y0 + x);
+    }
+  }
+  if (option & U8G2_DRAW_LOWER_LEFT) {
+    if (filled) {
+      vertical_line(x0 - x, y0, y + 1);
+      vertical_line(x0 - y, y0, x + 1);
+    } else {
+      set_pixel(x0 - x, y0 + y);
+      set_pixel(x0 - y, y0 + x);
+    }
+  }
+}
+
+void U8G2::drawCircle(int16_t x0, int16_t y0, int16_t radius, uint8_t option) {
+  primitives++;
+  int16_t f = 1 - radius, ddF_x = 1, ddF_y = -2 * radius;
+  int16_t x = 0, y = radius;
+  circle_section(x, y, x0, y0, option, false);
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    circle_section(x, y, x0, y0, option, false);
+  }
+}
+
+void U8G2::drawDisc(int16_t x0, int16_t y0, int16_t radius, uint8_t option) {
+  primitives++;
+  int16_t f = 1 - radius, ddF_x = 1, ddF_y = -2 * radius;
+  int16_t x = 0, y = radius;
+  circle_section(x, y, x0, y0, option, true);
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    circle_section(x, y, x0, y0, option, true);
+  }
+}
+// PRIMITIVES END
+
+// TEXT START
+// the cursor is on the baseline, nearest neighbour scaling of the 5x7 glyph to the stand-in size
+size_t U8G2::write(uint8_t character) {
+  characters++;
+  if (!font) {
+    return 1;
+  }
+  uint8_t cap = font[0], glyph_width = font[1], advance = font[2];
+  if (character >= GLYPH_FIRST && character <= GLYPH_LAST) {
+    const uint8_t *glyph = glyphs[character - GLYPH_FIRST];
+    for (uint8_t column = 0; column < glyph_width; column++) {
+      uint8_t bits = glyph[column * GLYPH_COLUMNS / glyph_width];
+      for (uint8_t row = 0; row < cap; row++) {
+        if (bits & (1 << (row * GLYPH_ROWS / cap))) {
+          set_pixel(cursor_x + column, cursor_y - cap + row);
+        }
+      }
+    }
+  }
+  cursor_x += advance;
+  return 1;
+}
+
+uint16_t U8G2::getStrWidth(const char *text) {
+  return font ? strlen(text) * font[2] : 0;
+}
+
+int16_t U8G2::drawStr(int16_t x, int16_t y, const char *text) {
+  setCursor(x, y);
+  print(text);
+  return getStrWidth(text);
+}
+// TEXT END
@@ -0,0 +1,125 @@
+#ifndef U8G2LIB_H
+#define U8G2LIB_H
+
+#include <Arduino.h>
+
+#define U8X8_PIN_NONE 255
+
+#define U8G2_DRAW_UPPER_RIGHT 0x01
+#define U8G2_DRAW_UPPER_LEFT  0x02
+#define U8G2_DRAW_LOWER_LEFT  0x04
+#define U8G2_DRAW_LOWER_RIGHT 0x08
+#define U8G2_DRAW_ALL         (U8G2_DRAW_UPPER_RIGHT | U8G2_DRAW_UPPER_LEFT | U8G2_DRAW_LOWER_RIGHT | U8G2_DRAW_LOWER_LEFT)
+
+// bus model of sendBuffer(), u8x8 sends every page as one command transfer and data transfers
+#define U8G2_I2C_CLOCK          400000 // [Hz] what u8x8 sets up for the SSD1306
+#define U8G2_I2C_BITS_PER_BYTE  9      // eight data bits and the acknowledge
+#define U8G2_I2C_FRAMING_BITS   2      // start and stop condition of every transfer
+#define U8G2_I2C_PAGE_COMMANDS  3      // column low, column high and page address
+#define U8G2_I2C_DATA_CHUNK     24     // [bytes] u8x8 splits the page data into transfers of this size
+#define U8G2_I2C_TRANSFER_BYTES 2      // address and control byte in front of every transfer
+
+struct u8g2_cb_t {
+  uint8_t rotation;
+};
+
+extern const u8g2_cb_t u8g2_cb_r0;
+extern const u8g2_cb_t u8g2_cb_r1;
+extern const u8g2_cb_t u8g2_cb_r2;
+extern const u8g2_cb_t u8g2_cb_r3;
+
+#define U8G2_R0 (&u8g2_cb_r0)
+#define U8G2_R1 (&u8g2_cb_r1)
+#define U8G2_R2 (&u8g2_cb_r2)
+#define U8G2_R3 (&u8g2_cb_r3)
+
+// stand-ins for the helvetica fonts: cap height, glyph width and advance in pixels,
+// the glyphs are a scaled 5x7 font, so text lands about where the real font puts it
+extern const uint8_t u8g2_font_helvB08_tf[];
+extern const uint8_t u8g2_font_helvB10_tf[];
+extern const uint8_t u8g2_font_helvB12_tf[];
+extern const uint8_t u8g2_font_helvB14_tf[];
+extern const uint8_t u8g2_font_helvB18_tf[];
+
+// framebuffer device, draws into the page buffer like the full buffer mode of u8g2
+// and counts what a frame costs, sendBuffer() spends the modeled I2C time
+class U8G2 : public Print {
+  public:
+    U8G2(const u8g2_cb_t *rotation, uint16_t width, uint16_t height);
+    ~U8G2();
+
+    bool begin() { return true; }
+    void clearBuffer();
+    void sendBuffer();
+    void clearDisplay() { clearBuffer(); sendBuffer(); }
+    void setPowerSave(uint8_t enabled) {}
+    void setContrast(uint8_t contrast) {}
+
+    // same layout as u8g2: tiles of 8x8 pixels, one byte is a column of 8 pixels with bit 0 on top
+    uint8_t *getBufferPtr() { return buffer; }
+    uint8_t getBufferTileWidth() { return width / 8; }
+    uint8_t getBufferTileHeight() { return height / 8; }
+    bool getPixel(int16_t x, int16_t y);
+
+    void setFont(const uint8_t *font) { this->font = font; }
+    void setFontMode(uint8_t transparent) {}
+    void setDrawColor(uint8_t color) { draw_color = color; }
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    int16_t getCursorX() { return cursor_x; }
+    int16_t getCursorY() { return cursor_y; }
+    uint16_t getDisplayWidth() { return width; }
+    uint16_t getDisplayHeight() { return height; }
+    uint16_t getStrWidth(const char *text);
+
+    void drawPixel(int16_t x, int16_t y) { primitives++; set_pixel(x, y); }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+    void drawHLine(int16_t x, int16_t y, int16_t width) { primitives++; horizontal_line(x, y, width); }
+    void drawVLine(int16_t x, int16_t y, int16_t height) { primitives++; vertical_line(x, y, height); }
+    void drawBox(int16_t x, int16_t y, int16_t width, int16_t height);
+    void drawFrame(int16_t x, int16_t y, int16_t width, int16_t height);
+    void drawCircle(int16_t x, int16_t y, int16_t radius, uint8_t option = U8G2_DRAW_ALL);
+    void drawDisc(int16_t x, int16_t y, int16_t radius, uint8_t option = U8G2_DRAW_ALL);
+    int16_t drawStr(int16_t x, int16_t y, const char *text);
+
+    size_t write(uint8_t character) override;
+    using Print::write;
+
+    unsigned long frames = 0;
+    unsigned long cleared = 0;
+    unsigned long primitives = 0;
+    unsigned long characters = 0;
+    unsigned long pixels = 0;        // pixels drawn, clipped ones not counted
+    unsigned long long i2c_bytes = 0;
+    unsigned long long i2c_time = 0; // [us]
+
+  private:
+    void set_pixel(int16_t x, int16_t y);
+    void horizontal_line(int16_t x, int16_t y, int16_t length);
+    void vertical_line(int16_t x, int16_t y, int16_t length);
+    void circle_section(int16_t x, int16_t y, int16_t x0, int16_t y0, uint8_t option, bool filled);
+
+    uint16_t width;
+    uint16_t height;
+    uint8_t *buffer;
+    uint8_t draw_color = 1;
+    const uint8_t *font = NULL;
+    int16_t cursor_x = 0;
+    int16_t cursor_y = 0;
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C : public U8G2 {
+  public:
+    U8G2_SSD1306_128X64_NONAME_F_HW_I2C(const u8g2_cb_t *rotation, uint8_t reset = U8X8_PIN_NONE,
+                                        uint8_t clock = U8X8_PIN_NONE, uint8_t data = U8X8_PIN_NONE)
+      : U8G2(rotation, 128, 64) {}
+};
+
+// 1.3" modules, u8x8 sends them page by page the same way
+class U8G2_SH1106_128X64_NONAME_F_HW_I2C : public U8G2 {
+  public:
+    U8G2_SH1106_128X64_NONAME_F_HW_I2C(const u8g2_cb_t *rotation, uint8_t reset = U8X8_PIN_NONE,
+                                       uint8_t clock = U8X8_PIN_NONE, uint8_t data = U8X8_PIN_NONE)
+      : U8G2(rotation, 128, 64) {}
+};
+
+#endif // U8G2LIB_H
@@ -0,0 +1,30 @@
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+typedef struct {
+  size_t total_free_bytes;
+  size_t total_allocated_bytes;
+  size_t largest_free_block;
+  size_t minimum_free_bytes;
+  size_t allocated_blocks;
+  size_t free_blocks;
+  size_t total_blocks;
+} multi_heap_info_t;
+
+// glibc only knows bytes, so the block counts stay zero and largest block is the whole free space
+inline void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps) {
+  struct mallinfo2 heap = mallinfo2();
+  *info = {};
+  info->total_free_bytes      = heap.fordblks;
+  info->total_allocated_bytes = heap.uordblks;
+  info->largest_free_block    = heap.fordblks;
+  info->minimum_free_bytes    = heap.fordblks;
+}
+
+#endif // ESP_HEAP_CAPS_H
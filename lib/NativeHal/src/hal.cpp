@@ -0,0 +1,723 @@
+#include "Arduino.h"
+#include "hal.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/timer_group_reg.h"
+#include <deque>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <vector>
+
+#define NANOS_PER_MICRO 1000ULL
+#define NANOS_PER_TICK  (1000000ULL * portTICK_PERIOD_MS)
+#define NEVER           UINT64_MAX
+#define HOST_STACK_SIZE (256 * 1024) // [bytes] host code needs a lot more than the ESP32
+
+// SCHEDULER START
+// Tasks are coroutines on the one host thread, so switching is cheap and
+// nothing needs locking. A task only gives up its core in yield_point().
+namespace {
+
+struct hal_task {
+  TaskFunction_t function;
+  void *parameter;
+  const char *name;
+  uint32_t stack_size; // [bytes] as asked for, the host stack is HOST_STACK_SIZE
+  UBaseType_t priority;
+  int core;
+  uint64_t wake_at;  // [ns] ready once the core reached this
+  uint64_t last_run; // switch count when it got its core, equal priorities take turns by it
+  bool deleted;
+  ucontext_t context;
+};
+
+struct scheduler {
+  std::vector<hal_task *> tasks;
+  hal_task *running = nullptr;       // nullptr while the harness runs
+  ucontext_t harness;
+  uint64_t core_now[HAL_CORES] = {}; // [ns]
+  uint64_t deadline = 0;             // [ns] where hal_run_for() hands back to the harness
+  uint64_t clock_read_cost = 250;    // [ns]
+  uint64_t gpio_cost = 0;            // [ns]
+  uint64_t register_cost = 0;        // [ns]
+  uint64_t core_lead = 1000 * NANOS_PER_MICRO; // [ns]
+  uint64_t horizon = 0;              // [ns] the running task cannot be preempted before this
+  uint64_t switches = 0;
+  uint32_t critical[HAL_CORES] = {}; // nesting of critical sections, the core keeps its task while non-zero
+};
+
+scheduler s;
+
+bool is_ready(const hal_task *task, uint64_t now) {
+  return !task->deleted && task->wake_at <= now;
+}
+
+// highest priority task of the core that is ready at now, equal priorities take turns
+hal_task *ready_task_of(int core, uint64_t now) {
+  hal_task *best = nullptr;
+  for (hal_task *task : s.tasks) {
+    if (task->core != core || !is_ready(task, now)) {
+      continue;
+    }
+    if (!best || task->priority > best->priority
+        || (task->priority == best->priority && task->last_run < best->last_run)) {
+      best = task;
+    }
+  }
+  return best;
+}
+
+uint64_t next_wake_of(int core) {
+  uint64_t next = NEVER;
+  for (const hal_task *task : s.tasks) {
+    if (task->core == core && !task->deleted) {
+      next = min(next, task->wake_at);
+    }
+  }
+  return next;
+}
+
+// the core furthest behind runs next, the running task's core may lead by core_lead before it gives way;
+// returns nullptr once every core reached the deadline
+hal_task *pick_next() {
+  int chosen_core = -1;
+  uint64_t chosen_at = NEVER;
+  for (int core = 0; core < HAL_CORES; core++) {
+    uint64_t at = max(s.core_now[core], next_wake_of(core));
+    if (at >= s.deadline) {
+      continue;
+    }
+    uint64_t compared = at;
+    if (s.running && s.running->core == core) {
+      compared = at > s.core_lead ? at - s.core_lead : 0;
+    }
+    if (compared < chosen_at) {
+      chosen_core = core;
+      chosen_at = compared;
+    }
+  }
+
+  if (chosen_core < 0) {
+    for (int core = 0; core < HAL_CORES; core++) {
+      s.core_now[core] = max(s.core_now[core], s.deadline);
+    }
+    return nullptr;
+  }
+
+  s.core_now[chosen_core] = max(s.core_now[chosen_core], next_wake_of(chosen_core));
+  return ready_task_of(chosen_core, s.core_now[chosen_core]);
+}
+
+// first time pick_next() could choose another task than the given one, nothing else runs until then
+uint64_t horizon_of(const hal_task *task) {
+  uint64_t horizon = s.deadline;
+  for (int core = 0; core < HAL_CORES; core++) {
+    if (core == task->core) {
+      continue;
+    }
+    uint64_t at = max(s.core_now[core], next_wake_of(core));
+    if (at != NEVER) {
+      horizon = min(horizon, at + s.core_lead + 1);
+    }
+  }
+  for (const hal_task *other : s.tasks) {
+    if (other != task && other->core == task->core && !other->deleted && other->priority > task->priority) {
+      horizon = min(horizon, other->wake_at);
+    }
+  }
+  return horizon;
+}
+
+// continues next, returns once the caller is picked again
+void switch_to(hal_task *next) {
+  s.horizon = next ? horizon_of(next) : 0;
+  if (next == s.running) {
+    return;
+  }
+  hal_task *previous = s.running;
+  s.running = next;
+  if (next) {
+    next->last_run = ++s.switches;
+  }
+  swapcontext(previous ? &previous->context : &s.harness, next ? &next->context : &s.harness);
+}
+
+// every clock read and delay passes here, this is where tasks get preempted
+void yield_point() {
+  if (s.running && s.critical[s.running->core]) {
+    return;
+  }
+  switch_to(pick_next());
+}
+
+void run_task() {
+  s.running->function(s.running->parameter);
+  // FreeRTOS tasks must not return
+  vTaskDelete(NULL);
+}
+
+void loop_task(void *parameter) {
+  setup();
+  while (true) {
+    loop();
+    taskYIELD();
+  }
+}
+
+} // namespace
+
+uint64_t hal_now_nano() {
+  return s.running ? s.core_now[s.running->core] : s.deadline;
+}
+
+uint64_t hal_now() {
+  return hal_now_nano() / NANOS_PER_MICRO;
+}
+
+void hal_set_clock_read_cost(uint32_t cost) {
+  s.clock_read_cost = cost;
+}
+
+void hal_set_gpio_cost(uint32_t cost) {
+  s.gpio_cost = cost;
+}
+
+void hal_set_register_cost(uint32_t cost) {
+  s.register_cost = cost;
+}
+
+void hal_set_core_lead(uint32_t lead) {
+  s.core_lead = lead * NANOS_PER_MICRO;
+}
+
+uint64_t hal_task_switches() {
+  return s.switches;
+}
+
+void hal_begin() {
+  // same name, stack and priority as the ESP32 core gives the sketch
+  xTaskCreatePinnedToCore(loop_task, "loopTask", 8192, NULL, 1, NULL, 1);
+}
+
+void hal_run_for(uint64_t duration) {
+  if (s.running) {
+    return;
+  }
+  s.deadline += duration * NANOS_PER_MICRO;
+  switch_to(pick_next());
+}
+
+namespace {
+
+hal_task *create_task(TaskFunction_t function, const char *name, uint32_t stack_size, void *parameter,
+                      UBaseType_t priority, int core, uint64_t wake_at) {
+  hal_task *task = new hal_task{ function, parameter, name, stack_size, priority, core, wake_at, 0, false, {} };
+  getcontext(&task->context);
+  task->context.uc_stack.ss_sp   = malloc(HOST_STACK_SIZE);
+  task->context.uc_stack.ss_size = HOST_STACK_SIZE;
+  task->context.uc_link = NULL;
+  makecontext(&task->context, run_task, 0);
+  s.tasks.push_back(task);
+  return task;
+}
+
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  int pinned = core >= 0 && core < HAL_CORES ? core : 0;
+  hal_task *task = create_task(function, name, stack_size, parameter, min<UBaseType_t>(priority, configMAX_PRIORITIES - 1),
+                               pinned, s.core_now[pinned]);
+  if (handle) {
+    *handle = task;
+  }
+  if (s.running) {
+    // a higher priority task on the same core takes over right away
+    yield_point();
+  }
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (!s.running) {
+    return;
+  }
+  // wakes on a tick boundary like FreeRTOS
+  s.running->wake_at = (s.core_now[s.running->core] / NANOS_PER_TICK + ticks) * NANOS_PER_TICK;
+  yield_point();
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  hal_task *deleted = task ? (hal_task *)task : s.running;
+  if (!deleted) {
+    return;
+  }
+  deleted->deleted = true;
+  if (deleted == s.running) {
+    // never picked again, its stack stays allocated until the process exits
+    yield_point();
+  }
+}
+
+void taskYIELD() {
+  if (!s.running) {
+    return;
+  }
+  s.running->last_run = ++s.switches;
+  yield_point();
+}
+
+TickType_t xTaskGetTickCount() {
+  return hal_now_nano() / NANOS_PER_TICK;
+}
+
+BaseType_t xPortGetCoreID() {
+  return s.running ? s.running->core : 0;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  hal_task *measured = task ? (hal_task *)task : s.running;
+  return measured ? measured->stack_size : 0;
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux) {
+  mux->nesting++;
+  if (s.running) {
+    s.critical[s.running->core]++;
+  }
+}
+
+void vPortExitCritical(portMUX_TYPE *mux) {
+  mux->nesting--;
+  if (s.running && !--s.critical[s.running->core] && s.core_now[s.running->core] >= s.horizon) {
+    // an interrupt or task that became due meanwhile takes over now
+    yield_point();
+  }
+}
+// SCHEDULER END
+
+// CLOCK START
+namespace {
+
+// spends time on the core of the running task, scheduling only happens once the horizon is reached;
+// a long busy wait gets preempted on the way there like on the hardware, only a critical section holds the core
+uint64_t spend(uint64_t duration) {
+  if (!s.running) {
+    return s.deadline;
+  }
+  int core = s.running->core;
+  uint64_t end = s.core_now[core] + duration;
+  while (true) {
+    uint64_t &now = s.core_now[core];
+    now = s.critical[core] || s.horizon <= now ? max(now, end) : min(end, s.horizon);
+    if (now >= s.horizon) {
+      yield_point();
+    }
+    if (s.core_now[core] >= end) {
+      return s.core_now[core];
+    }
+  }
+}
+
+} // namespace
+
+unsigned long micros() {
+  return spend(s.clock_read_cost) / NANOS_PER_MICRO;
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+void delay(uint32_t duration) {
+  vTaskDelay(pdMS_TO_TICKS(duration));
+}
+
+void delayMicroseconds(uint32_t duration) {
+  spend(duration * NANOS_PER_MICRO);
+}
+// CLOCK END
+
+// HARDWARE TIMER START
+#define HAL_TIMERS 4
+#define HAL_INTERRUPT_PRIORITY configMAX_PRIORITIES // above every task
+
+struct hw_timer_t {
+  uint16_t divider;
+  void (*isr)();
+  hal_task *interrupt;  // runs isr on the core that attached it
+  uint64_t started_at;  // [ns] when the count was zero
+  uint64_t alarm;       // [counts]
+  bool autoreload;
+  bool enabled;
+};
+
+namespace {
+
+hw_timer_t timers[HAL_TIMERS] = {};
+
+uint64_t count_duration(const hw_timer_t *timer, uint64_t counts) {
+  return counts * timer->divider * 1000000000ULL / HAL_APB_CLOCK; // [ns]
+}
+
+uint64_t alarm_at(const hw_timer_t *timer) {
+  if (!timer->enabled) {
+    return NEVER;
+  }
+  // an alarm at zero would fire without end
+  return timer->started_at + count_duration(timer, max<uint64_t>(timer->alarm, 1));
+}
+
+// a change from a task moves the alarm right away, one from the isr once it returned
+void schedule_alarm(hw_timer_t *timer) {
+  if (!timer->interrupt || s.running == timer->interrupt) {
+    return;
+  }
+  // an alarm below the count fires right away
+  timer->interrupt->wake_at = max(alarm_at(timer), hal_now_nano());
+  if (s.running) {
+    s.horizon = min(s.horizon, horizon_of(s.running));
+  }
+}
+
+void timer_interrupt(void *parameter) {
+  hw_timer_t *timer = (hw_timer_t *)parameter;
+  while (true) {
+    // stays ready while the isr runs, so no task of the core gets in between
+    if (timer->autoreload) {
+      // counts from zero again when the alarm fired, even when the core let the isr wait
+      timer->started_at = s.running->wake_at;
+    } else {
+      timer->enabled = false;
+    }
+    timer->isr();
+    s.running->wake_at = max(alarm_at(timer), hal_now_nano());
+    yield_point();
+  }
+}
+
+} // namespace
+
+hw_timer_t *timerBegin(uint8_t number, uint16_t divider, bool count_up) {
+  if (number >= HAL_TIMERS) {
+    return nullptr;
+  }
+  hw_timer_t *timer = &timers[number];
+  timer->divider    = divider;
+  timer->started_at = hal_now_nano();
+  return timer;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(), bool edge) {
+  timer->isr = isr;
+  if (!timer->interrupt) {
+    int core = s.running ? s.running->core : 0;
+    timer->interrupt = create_task(timer_interrupt, "TimerInterrupt", 0, timer, HAL_INTERRUPT_PRIORITY, core, NEVER);
+  }
+  schedule_alarm(timer);
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm, bool autoreload) {
+  timer->alarm      = alarm;
+  timer->autoreload = autoreload;
+  schedule_alarm(timer);
+}
+
+void timerAlarmEnable(hw_timer_t *timer) {
+  timer->enabled = true;
+  schedule_alarm(timer);
+}
+
+void timerAlarmDisable(hw_timer_t *timer) {
+  timer->enabled = false;
+  schedule_alarm(timer);
+}
+
+bool timerAlarmEnabled(hw_timer_t *timer) {
+  return timer->enabled;
+}
+
+void timerWrite(hw_timer_t *timer, uint64_t count) {
+  timer->started_at = hal_now_nano() - count_duration(timer, count);
+  schedule_alarm(timer);
+}
+
+namespace {
+
+// the timer a config or alarm register belongs to, nullptr for other addresses;
+// timer n of the Arduino core is timer n % 2 of group n / 2
+hw_timer_t *timer_of_register(uint32_t address, uint32_t &offset) {
+  if (address < REG_TIMG_BASE(0) || address >= REG_TIMG_BASE(2)) {
+    return nullptr;
+  }
+  uint32_t group  = (address - REG_TIMG_BASE(0)) / 0x1000;
+  uint32_t within = address - REG_TIMG_BASE(group);
+  uint32_t stride = TIMG_T1CONFIG_REG(0) - TIMG_T0CONFIG_REG(0);
+  if (within >= 2 * stride) {
+    return nullptr;
+  }
+  offset = within % stride;
+  return &timers[group * 2 + within / stride];
+}
+
+// only alarm enable, autoreload and the alarm value are modelled, the counter always runs up
+uint32_t read_timer_register(uint32_t address) {
+  uint32_t offset = 0;
+  hw_timer_t *timer = timer_of_register(address, offset);
+  if (!timer) {
+    return 0;
+  }
+  switch (offset) {
+    case TIMG_T0CONFIG_REG(0) - REG_TIMG_BASE(0):
+      return TIMG_T0_EN | (timer->autoreload ? TIMG_T0_AUTORELOAD : 0) | (timer->enabled ? TIMG_T0_ALARM_EN : 0)
+             | (uint32_t)(timer->divider & TIMG_T0_DIVIDER) << TIMG_T0_DIVIDER_S;
+    case TIMG_T0ALARMLO_REG(0) - REG_TIMG_BASE(0): return (uint32_t)timer->alarm;
+    case TIMG_T0ALARMHI_REG(0) - REG_TIMG_BASE(0): return (uint32_t)(timer->alarm >> 32);
+    default:                                        return 0;
+  }
+}
+
+void write_timer_register(uint32_t address, uint32_t value) {
+  uint32_t offset = 0;
+  hw_timer_t *timer = timer_of_register(address, offset);
+  if (!timer) {
+    return;
+  }
+  switch (offset) {
+    case TIMG_T0CONFIG_REG(0) - REG_TIMG_BASE(0):
+      timer->autoreload = value & TIMG_T0_AUTORELOAD;
+      timer->enabled    = value & TIMG_T0_ALARM_EN;
+      break;
+    case TIMG_T0ALARMLO_REG(0) - REG_TIMG_BASE(0):
+      timer->alarm = (timer->alarm & 0xffffffff00000000ULL) | value;
+      break;
+    case TIMG_T0ALARMHI_REG(0) - REG_TIMG_BASE(0):
+      timer->alarm = (timer->alarm & 0xffffffffULL) | (uint64_t)value << 32;
+      break;
+    default:
+      return;
+  }
+  schedule_alarm(timer);
+}
+
+} // namespace
+// HARDWARE TIMER END
+
+// GPIO START
+namespace {
+
+struct pin_state {
+  uint8_t mode;
+  uint8_t written; // level of digitalWrite()
+  bool driven;     // hal_set_input() and hal_drive_input() override everything else
+  uint8_t input;
+  hal_pin_source source;
+};
+
+pin_state pins[HAL_PINS] = {};
+uint32_t pins_in_use[2] = {}; // per register bank, pins with a mode or driven, the only ones read_bank() looks at
+std::vector<hal_pin_listener> pin_listeners;
+
+void update_pin_in_use(uint8_t pin) {
+  uint32_t bit = 1UL << (pin % 32);
+  if (pins[pin].mode || pins[pin].driven) {
+    pins_in_use[pin / 32] |= bit;
+  } else {
+    pins_in_use[pin / 32] &= ~bit;
+  }
+}
+
+} // namespace
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < HAL_PINS) {
+    pins[pin].mode = mode;
+    update_pin_in_use(pin);
+  }
+}
+
+namespace {
+
+void write_pin(uint8_t pin, uint8_t level) {
+  pins[pin].written = level ? HIGH : LOW;
+  for (hal_pin_listener listener : pin_listeners) {
+    listener(pin, pins[pin].written, hal_now_nano());
+  }
+}
+
+// pins of the low or the high register bank, pins nobody set up read low
+uint32_t read_bank(uint8_t first) {
+  uint32_t levels = 0;
+  for (uint32_t in_use = pins_in_use[first / 32]; in_use; in_use &= in_use - 1) {
+    uint8_t bit = __builtin_ctz(in_use);
+    levels |= (uint32_t)hal_pin_level(first + bit) << bit;
+  }
+  return levels;
+}
+
+uint32_t written_bank(uint8_t first) {
+  uint32_t levels = 0;
+  for (uint8_t bit = 0; bit < 32 && first + bit < HAL_PINS; bit++) {
+    levels |= (uint32_t)pins[first + bit].written << bit;
+  }
+  return levels;
+}
+
+// lowest pin first, like digitalWrite() one after the other
+void write_bank(uint8_t first, uint32_t mask, uint8_t level) {
+  for (uint8_t bit = 0; bit < 32 && first + bit < HAL_PINS; bit++) {
+    if (mask & (1UL << bit)) {
+      write_pin(first + bit, level);
+    }
+  }
+}
+
+} // namespace
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= HAL_PINS) {
+    return;
+  }
+  if (s.gpio_cost) {
+    spend(s.gpio_cost);
+  }
+  write_pin(pin, level);
+}
+
+int digitalRead(uint8_t pin) {
+  if (s.gpio_cost) {
+    spend(s.gpio_cost);
+  }
+  return hal_pin_level(pin);
+}
+
+uint32_t hal_register_read(uint32_t address) {
+  if (s.register_cost) {
+    spend(s.register_cost);
+  }
+  switch (address) {
+    case GPIO_IN_REG:   return read_bank(0);
+    case GPIO_IN1_REG:  return read_bank(32);
+    case GPIO_OUT_REG:  return written_bank(0);
+    case GPIO_OUT1_REG: return written_bank(32);
+    default:            return read_timer_register(address);
+  }
+}
+
+void hal_register_write(uint32_t address, uint32_t value) {
+  if (s.register_cost) {
+    spend(s.register_cost);
+  }
+  switch (address) {
+    case GPIO_OUT_W1TS_REG:  write_bank(0, value, HIGH);  break;
+    case GPIO_OUT_W1TC_REG:  write_bank(0, value, LOW);   break;
+    case GPIO_OUT1_W1TS_REG: write_bank(32, value, HIGH); break;
+    case GPIO_OUT1_W1TC_REG: write_bank(32, value, LOW);  break;
+    case GPIO_OUT_REG:
+      write_bank(0, value, HIGH);
+      write_bank(0, ~value, LOW);
+      break;
+    case GPIO_OUT1_REG:
+      write_bank(32, value, HIGH);
+      write_bank(32, ~value, LOW);
+      break;
+    default:
+      write_timer_register(address, value);
+      break;
+  }
+}
+
+void hal_set_input(uint8_t pin, uint8_t level) {
+  if (pin < HAL_PINS) {
+    pins[pin].driven = true;
+    pins[pin].input = level ? HIGH : LOW;
+    pins[pin].source = nullptr;
+    update_pin_in_use(pin);
+  }
+}
+
+void hal_drive_input(uint8_t pin, hal_pin_source source) {
+  if (pin < HAL_PINS) {
+    pins[pin].driven = source != nullptr;
+    pins[pin].source = source;
+    update_pin_in_use(pin);
+  }
+}
+
+void hal_release_input(uint8_t pin) {
+  if (pin < HAL_PINS) {
+    pins[pin].driven = false;
+    pins[pin].source = nullptr;
+    update_pin_in_use(pin);
+  }
+}
+
+uint8_t hal_pin_level(uint8_t pin) {
+  if (pin >= HAL_PINS) {
+    return LOW;
+  }
+  const pin_state &state = pins[pin];
+  if (state.source) {
+    return state.source(pin, hal_now_nano()) ? HIGH : LOW;
+  }
+  if (state.driven) {
+    return state.input;
+  }
+  if (state.mode == OUTPUT) {
+    return state.written;
+  }
+  // floating inputs read low
+  return (state.mode & PULLUP) ? HIGH : LOW;
+}
+
+void hal_on_pin_write(hal_pin_listener listener) {
+  pin_listeners.push_back(listener);
+}
+// GPIO END
+
+// SERIAL START
+namespace {
+std::deque<char> serial_input;
+hal_serial_listener serial_listener = nullptr;
+bool serial_echo = true;
+} // namespace
+
+HardwareSerial Serial;
+
+int HardwareSerial::available() {
+  return serial_input.size();
+}
+
+int HardwareSerial::read() {
+  if (serial_input.empty()) {
+    return -1;
+  }
+  char character = serial_input.front();
+  serial_input.pop_front();
+  return (uint8_t)character;
+}
+
+size_t HardwareSerial::write(uint8_t character) {
+  if (serial_listener) {
+    serial_listener(character);
+  }
+  if (serial_echo) {
+    fputc(character, stdout);
+  }
+  return 1;
+}
+
+void hal_on_serial_write(hal_serial_listener listener) {
+  serial_listener = listener;
+}
+
+void hal_set_serial_echo(bool echo) {
+  serial_echo = echo;
+}
+
+void hal_serial_input(const char *text) {
+  while (*text) {
+    serial_input.push_back(*text++);
+  }
+}
+// SERIAL END
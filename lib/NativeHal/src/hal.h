@@ -0,0 +1,73 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+// Harness side of the native build. The firmware runs in FreeRTOS style tasks
+// on two virtual cores, every core keeps its own virtual clock:
+//  - reading micros()/millis() costs the clock read cost and may switch tasks,
+//    so does the GPIO cost of digitalRead()/digitalWrite() and the register
+//    cost of REG_READ()/REG_WRITE() on the GPIO registers
+//  - vTaskDelay() sleeps until the tick boundary like FreeRTOS does
+//  - a core may run ahead of the other one by at most the core lead
+// The tasks are coroutines on the thread calling hal_run_for(), so the harness
+// may change anything between two calls or from inside a listener.
+
+#define HAL_CORES 2
+#define HAL_PINS  40
+
+// VIRTUAL TIME START
+// creates the Arduino loopTask running setup() and then loop(), like the ESP32 core does
+void hal_begin();
+
+// lets the tasks run until every core reached the current time plus duration
+void hal_run_for(uint64_t duration); // [us]
+
+// time of the core of the calling task, or the time hal_run_for() stopped at outside the tasks
+uint64_t hal_now();      // [us]
+uint64_t hal_now_nano(); // [ns]
+
+void hal_set_clock_read_cost(uint32_t cost); // [ns] default 250
+void hal_set_gpio_cost(uint32_t cost);       // [ns] of every digitalRead()/digitalWrite(), default 0
+void hal_set_register_cost(uint32_t cost);   // [ns] of every REG_READ()/REG_WRITE(), default 0
+void hal_set_core_lead(uint32_t lead);       // [us] default 1000, smaller is closer to real but slower
+
+uint64_t hal_task_switches();
+// VIRTUAL TIME END
+
+// GPIO START
+// drives an input from outside, overrides the pull up or down of pinMode()
+void hal_set_input(uint8_t pin, uint8_t level);
+void hal_release_input(uint8_t pin);
+uint8_t hal_pin_level(uint8_t pin);
+
+// called on every digitalWrite() from the writing task, at is its virtual time in [ns];
+// several listeners are called in the order they were added
+typedef void (*hal_pin_listener)(uint8_t pin, uint8_t level, uint64_t at);
+void hal_on_pin_write(hal_pin_listener listener);
+
+// asked on every digitalRead() of the pin instead of the stored level, for inputs that change with time
+typedef uint8_t (*hal_pin_source)(uint8_t pin, uint64_t at);
+void hal_drive_input(uint8_t pin, hal_pin_source source);
+// GPIO END
+
+// PERIPHERY START
+// turns the encoder with the given index, in creation order
+void hal_encoder_turn(uint8_t index, long counts);
+
+// characters the firmware gets from Serial.read()
+void hal_serial_input(const char *text);
+
+// gets everything the firmware writes to Serial, echo sends it to stdout as well (the default)
+typedef void (*hal_serial_listener)(char character);
+void hal_on_serial_write(hal_serial_listener listener);
+void hal_set_serial_echo(bool echo);
+
+// forgets everything stored in Preferences
+void hal_preferences_reset();
+// [us] every write, remove and clear of Preferences keeps the calling task busy, default 0;
+// NVS takes about a millisecond for a write on the ESP32
+void hal_set_preferences_write_cost(uint32_t cost);
+// PERIPHERY END
+
+#endif // HAL_H
@@ -0,0 +1,19 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// runs the sketch for the virtual time given in seconds, forever without an argument;
+// test and benchmark programs bring their own main()
+__attribute__((weak)) int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 0.0;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  hal_begin();
+  if (seconds > 0.0) {
+    hal_run_for((uint64_t)(seconds * 1000000.0));
+    fflush(stdout);
+    return 0;
+  }
+  while (true) {
+    hal_run_for(1000000);
+  }
+}
@@ -0,0 +1,14 @@
+#ifndef SOC_SOC_H
+#define SOC_SOC_H
+
+#include <stdint.h>
+
+// register access goes to the pins and timers of the HAL, see hal.cpp; only the GPIO registers
+// and the alarm registers of the timer groups are known
+uint32_t hal_register_read(uint32_t address);
+void hal_register_write(uint32_t address, uint32_t value);
+
+#define REG_READ(address)         hal_register_read(address)
+#define REG_WRITE(address, value) hal_register_write(address, value)
+
+#endif // SOC_SOC_H
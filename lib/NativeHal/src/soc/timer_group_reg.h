@@ -0,0 +1,21 @@
+#ifndef SOC_TIMER_GROUP_REG_H
+#define SOC_TIMER_GROUP_REG_H
+
+// registers of timer 0 of the two ESP32 timer groups the firmware touches, same as in ESP-IDF;
+// the bases are in soc/soc.h there. Timer n of the Arduino core is timer n % 2 of group n / 2,
+// the registers of timer 1 follow those of timer 0 at TIMG_T1CONFIG_REG(i)
+#define DR_REG_TIMERGROUP0_BASE 0x3ff5f000
+#define DR_REG_TIMERGROUP1_BASE 0x3ff60000
+#define REG_TIMG_BASE(i)        (DR_REG_TIMERGROUP0_BASE + (i) * 0x1000)
+
+#define TIMG_T0CONFIG_REG(i)    (REG_TIMG_BASE(i) + 0x0000)
+#define TIMG_T0_EN              (1UL << 31)
+#define TIMG_T0_AUTORELOAD      (1UL << 29)
+#define TIMG_T0_DIVIDER         0x0000ffff
+#define TIMG_T0_DIVIDER_S       13
+#define TIMG_T0_ALARM_EN        (1UL << 10)
+#define TIMG_T0ALARMLO_REG(i)   (REG_TIMG_BASE(i) + 0x0010)
+#define TIMG_T0ALARMHI_REG(i)   (REG_TIMG_BASE(i) + 0x0014)
+#define TIMG_T1CONFIG_REG(i)    (REG_TIMG_BASE(i) + 0x0024)
+
+#endif // SOC_TIMER_GROUP_REG_H
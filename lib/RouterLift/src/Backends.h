@@ -0,0 +1,89 @@
+#ifndef BACKENDS_H
+#define BACKENDS_H
+
+// Backends are picked by build flags, only the picked one is compiled in:
+//   -DSTEPPER_ENGINE=STEPPER_ENGINE_DIGITAL_WRITE  STEP and DIR through digitalWrite(), default are the register writes of Gpio.h
+//   -DSTEPPER_ENGINE=STEPPER_ENGINE_TIMER          steps from a hardware timer interrupt, see TimerStepper.h
+//   -DSTEPPER_ENGINE=STEPPER_ENGINE_SIMULATED      the profile without pins, for the host
+//   -DENCODER_MODE=ENCODER_MODE_HALF_QUAD          or ENCODER_MODE_FULL_QUAD, default is single edge
+//   -DDISPLAY_DRIVER=DISPLAY_DRIVER_SH1106         1.3" modules, default is the 0.96" SSD1306
+
+#include <AccelStepper.h>
+#include <ESP32Encoder.h>
+#include <U8g2lib.h>
+#include "Gpio.h"
+#include "PinDefinitions.h"
+#include "StepperDriver.h"
+#include "TimerStepper.h"
+
+#define STEPPER_ENGINE_REGISTER      0
+#define STEPPER_ENGINE_DIGITAL_WRITE 1
+#define STEPPER_ENGINE_TIMER         2
+#define STEPPER_ENGINE_SIMULATED     3
+
+#define ENCODER_MODE_SINGLE_EDGE 0
+#define ENCODER_MODE_HALF_QUAD   1
+#define ENCODER_MODE_FULL_QUAD   2
+
+#define DISPLAY_DRIVER_SSD1306 0
+#define DISPLAY_DRIVER_SH1106  1
+
+#ifndef STEPPER_ENGINE
+#define STEPPER_ENGINE STEPPER_ENGINE_REGISTER
+#endif
+
+#ifndef ENCODER_MODE
+#define ENCODER_MODE ENCODER_MODE_SINGLE_EDGE
+#endif
+
+#ifndef DISPLAY_DRIVER
+#define DISPLAY_DRIVER DISPLAY_DRIVER_SSD1306
+#endif
+
+// STEPPER ENGINE START
+// AccelStepper as it comes, one digitalWrite() per pin
+class digital_write_stepper : public AccelStepper {
+  public:
+    digital_write_stepper() : AccelStepper(AccelStepper::DRIVER, PIN_STEP, PIN_DIRECTION) {}
+};
+
+// the motion task only sees stepper_driver, see StepperDriver.h
+#if STEPPER_ENGINE == STEPPER_ENGINE_REGISTER
+typedef accel_stepper_engine<board_stepper> stepper_engine;
+#elif STEPPER_ENGINE == STEPPER_ENGINE_DIGITAL_WRITE
+typedef accel_stepper_engine<digital_write_stepper> stepper_engine;
+#elif STEPPER_ENGINE == STEPPER_ENGINE_TIMER
+typedef timer_stepper_engine<step_pin, direction_pin> stepper_engine;
+#elif STEPPER_ENGINE == STEPPER_ENGINE_SIMULATED
+typedef accel_stepper_engine<simulated_stepper> stepper_engine;
+#else
+#error "STEPPER_ENGINE has to be STEPPER_ENGINE_REGISTER, STEPPER_ENGINE_DIGITAL_WRITE, STEPPER_ENGINE_TIMER or STEPPER_ENGINE_SIMULATED"
+#endif
+// STEPPER ENGINE END
+
+// ENCODER MODE START
+// counts per detent differ, the settings for encoder distances are per count
+inline void attach_encoder(ESP32Encoder &encoder) {
+#if ENCODER_MODE == ENCODER_MODE_SINGLE_EDGE
+  encoder.attachSingleEdge(PIN_ENCODER_A_MINUS, PIN_ENCODER_B_MINUS);
+#elif ENCODER_MODE == ENCODER_MODE_HALF_QUAD
+  encoder.attachHalfQuad(PIN_ENCODER_A_MINUS, PIN_ENCODER_B_MINUS);
+#elif ENCODER_MODE == ENCODER_MODE_FULL_QUAD
+  encoder.attachFullQuad(PIN_ENCODER_A_MINUS, PIN_ENCODER_B_MINUS);
+#else
+#error "ENCODER_MODE has to be ENCODER_MODE_SINGLE_EDGE, ENCODER_MODE_HALF_QUAD or ENCODER_MODE_FULL_QUAD"
+#endif
+}
+// ENCODER MODE END
+
+// DISPLAY DRIVER START
+#if DISPLAY_DRIVER == DISPLAY_DRIVER_SSD1306
+typedef U8G2_SSD1306_128X64_NONAME_F_HW_I2C display_driver;
+#elif DISPLAY_DRIVER == DISPLAY_DRIVER_SH1106
+typedef U8G2_SH1106_128X64_NONAME_F_HW_I2C display_driver;
+#else
+#error "DISPLAY_DRIVER has to be DISPLAY_DRIVER_SSD1306 or DISPLAY_DRIVER_SH1106"
+#endif
+// DISPLAY DRIVER END
+
+#endif // BACKENDS_H
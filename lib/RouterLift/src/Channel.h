@@ -0,0 +1,97 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free links between exactly one producer task and one consumer task.
+// The producer only writes head, the consumer only writes tail, so no
+// critical sections are needed and neither side ever blocks the other.
+
+// CHANNEL START
+// ring buffer for messages that must not get lost, like commands and button presses
+template <typename T, size_t CAPACITY>
+class channel {
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "channel capacity has to be a power of two");
+
+  public:
+    // producer side, returns false when the consumer is CAPACITY messages behind;
+    // always inlined, sample_sensors() pushes from an IRAM_ATTR interrupt
+    inline __attribute__((always_inline)) bool push(const T &item) {
+      uint32_t current_head = head.load(std::memory_order_relaxed);
+      if (current_head - tail.load(std::memory_order_acquire) == CAPACITY) {
+        return false;
+      }
+      items[current_head % CAPACITY] = item;
+      // publishes the item written above
+      head.store(current_head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // consumer side, copies the oldest message without removing it
+    bool peek(T &item) const {
+      uint32_t current_tail = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == current_tail) {
+        return false;
+      }
+      item = items[current_tail % CAPACITY];
+      return true;
+    }
+
+    // consumer side, removes the oldest message
+    bool pop(T &item) {
+      if (!peek(item)) {
+        return false;
+      }
+      // hands the slot back to the producer after it was copied
+      tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool is_empty() const {
+      return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    T items[CAPACITY];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
+// CHANNEL END
+
+// MAILBOX START
+// triple buffer for snapshots where only the newest one matters, like status values;
+// the writer never waits and the reader always gets a complete snapshot
+template <typename T>
+class mailbox {
+  public:
+    // producer side
+    void write(const T &item) {
+      buffers[back] = item;
+      // swap the written buffer into the middle and mark it as fresh
+      back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // consumer side, returns false and the previous snapshot when nothing new was written
+    bool read(T &item) {
+      bool fresh = middle.load(std::memory_order_relaxed) & FRESH;
+      if (fresh) {
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+      }
+      item = buffers[front];
+      return fresh;
+    }
+
+  private:
+    static constexpr uint8_t INDEX = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    T buffers[3] = {};
+    uint8_t back  = 0; // only touched by the producer
+    uint8_t front = 1; // only touched by the consumer
+    std::atomic<uint8_t> middle{2};
+};
+// MAILBOX END
+
+#endif // CHANNEL_H
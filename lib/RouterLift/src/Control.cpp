@@ -0,0 +1,876 @@
+#include "Control.h"
+#include "Gpio.h"
+#include "Input.h"
+#include "SensorFilter.h"
+#include "Settings.h"
+
+// STATUS VALUES START
+motion_status status_motion = {};
+
+long  status_jog_direction = 0; // [-1, 0 or 1] button held for moving up or down
+
+bool  status_slow_speed  = false;
+long  status_slow_offset = 0;
+
+// positions in steps are machine positions, the end stop triggers at 0 once a toolchange referenced them;
+// everything shown counts from the work zero, the zero of the tool plus the selected work offset
+bool  status_machine_referenced = false;
+long  status_tool_zero = 0; // steps, where the tip of the bit touches the table
+
+bool  status_target_active = false;
+long  status_target_lower_limit = 0; // steps
+
+bool  status_workspace_active = false;
+long  status_workspace_upper_limit = 0; // steps
+long  status_workspace_lower_limit = 0; // steps
+
+long  status_tool_slot = 0;
+bool  status_tool_selected  = false;
+bool  status_tool_verifying = false; // the next auto zero checks the offset of the selected tool
+bool  status_target_restore = false; // target was active before the toolchange
+
+// where the tool length sensor should trigger with the bit in the router, from the last probe or the tool table
+bool  status_probe_expected_valid = false;
+long  status_probe_expected = 0; // steps
+
+long  status_preset_slot = 0;
+
+enum overlays status_overlay = overlay_none;
+unsigned long status_overlay_shown_at = 0; // [ms]
+
+// depth passes go up from where they start to the target, pass_step further each
+long  status_pass_start = 0; // steps
+long  status_pass_step  = 0; // steps
+long  status_pass = 0;
+long  status_pass_count = 0;
+
+long  status_feed_override = 100; // [%] of the feed rate, turned during a feed plunge
+long  status_feed_rate     = 0;   // [mm per minute] the feed runs at
+bool  status_feed_limited  = false; // the motor maximum or a resonance band changed the feed
+
+long status_settings_menu_active_page =  0;
+long status_settings_menu_pages_count = SETTINGS_PAGES_COUNT;
+
+const char *status_error_message = "";
+
+bool status_diagnostics_visible = false; // hidden settings menu page
+diagnostics_report status_diagnostics = {};
+uint32_t status_tick_period_maximal = 0; // [us]
+unsigned long status_diagnostics_sampled_at = 0; // [ms]
+
+mailbox<control_status> control_status_for_display;
+mailbox<diagnostics_report> diagnostics_for_display;
+// STATUS VALUES END
+
+// STATE MACHINE VALUES START
+enum states current_state = default_start;
+unsigned long current_state_entered_at = 0; // [ms]
+// STATE MACHINE VALUES END
+
+// COMPUTED VALUES START
+long work_zero() {
+  return status_tool_zero + work_offset_in_steps();
+}
+
+long work_position(long machine_position) {
+  return machine_position - work_zero();
+}
+
+void exit_halt_motor() {
+  motion_halt();
+}
+
+bool entry_error() {
+  motion_halt();
+  status_tool_verifying = false;
+  return true;
+}
+
+void deactivate_target() {
+  status_target_active = false;
+  motion_set_target(false, status_target_lower_limit);
+}
+void deactivate_workspace() {
+  status_workspace_active = false;
+  motion_set_workspace(false, status_workspace_lower_limit, status_workspace_upper_limit);
+}
+enum events error_with(const char *error_message) {
+  Serial.printf("Error: %s\n", error_message);
+  status_error_message = error_message;
+  return event_fault;
+}
+void activate_workspace() {
+  status_workspace_lower_limit = status_motion.position;
+  status_workspace_upper_limit = status_workspace_lower_limit + (preference_workspace_height / mm_per_step());
+  status_workspace_active = true;
+  motion_set_workspace(true, status_workspace_lower_limit, status_workspace_upper_limit);
+  Serial.printf("status_workspace_lower_limit: %ld\n", status_workspace_lower_limit);
+  Serial.printf("status_workspace_upper_limit: %ld\n", status_workspace_upper_limit);
+}
+
+void activate_target() {
+  status_target_active = true;
+  status_target_lower_limit = status_motion.position;
+  motion_set_target(true, status_target_lower_limit);
+}
+
+// up is the way the end stop references the position, so approaching from below ends every move going up
+void update_backlash() {
+  long approach = 0;
+  if (preference_approach_from_below) {
+    approach = (preference_backlash + lround(APPROACH_OVERSHOOT / mm_per_step())) * preference_motor_direction;
+  }
+  motion_set_backlash(preference_backlash, approach);
+}
+
+static_assert(PITCH_TABLE_POINTS + 1 <= MOTION_PITCH_POINTS, "the pitch table and its point at the end stop have to fit into the motion task");
+
+// the table starts at the end stop, where the machine position is referenced; a carriage further down than
+// the steps say is at a machine position further down than the motor counts. Before the reference the motor
+// counts from wherever it stood at power on, so the screw stays perfect until then
+void update_pitch_table() {
+  motion_pitch_table table = {};
+  long spacing = lround(PITCH_TABLE_SPACING / mm_per_step()); // [steps]
+  long down    = -preference_motor_direction;
+  if (status_machine_referenced && spacing > 0 && !is_pitch_table_empty()) {
+    table.count = PITCH_TABLE_POINTS + 1;
+    for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+      long screw = (point + 1) * spacing * down;
+      table.screw[point + 1]    = screw;
+      table.carriage[point + 1] = screw + lround(preference_pitch_errors[point] / mm_per_step()) * down;
+    }
+  }
+  motion_set_pitch_table(table);
+  // the motion task put them on the screw with the old table
+  motion_set_workspace(status_workspace_active, status_workspace_lower_limit, status_workspace_upper_limit);
+  motion_set_target(status_target_active, status_target_lower_limit);
+}
+
+// move back with a quarter of base speed, give up after MM_TO_FREE_ERROR
+void free_sensor_end_stop() {
+  motion_free_end_stop(resonance_free_speed(-preference_motor_speed_maximal * 0.25 * preference_motor_direction),
+                       (long)(MM_TO_FREE_ERROR / mm_per_step()),
+                       -FREE_SENSOR_TOLERANCE * preference_motor_direction);
+}
+
+void free_sensor_tool_length() {
+  motion_free_tool_length(resonance_free_speed(-preference_motor_speed_maximal * 0.25 * preference_motor_direction),
+                          (long)(MM_TO_FREE_ERROR / mm_per_step()),
+                          -FREE_SENSOR_TOLERANCE * preference_motor_direction);
+}
+
+bool entry_goto_toolchange() {
+  status_target_restore = status_target_active;
+  status_tool_selected  = false;
+  status_tool_verifying = false;
+  // another bit triggers somewhere else
+  status_probe_expected_valid = false;
+  deactivate_target();
+  deactivate_workspace();
+  motion_run_speed(resonance_free_speed(preference_motor_speed_maximal * preference_motor_direction));
+  return true;
+}
+
+bool entry_finish_toolchange() {
+  // the motion task stopped where the end stop triggered, that is machine 0 from now on;
+  // zero and target keep their place relative to each other until the next tool gets its zero
+  long trigger = status_motion.position;
+  status_tool_zero          -= trigger;
+  status_target_lower_limit -= trigger;
+  status_machine_referenced  = true;
+  motion_set_position(0);
+  update_pitch_table();
+  free_sensor_end_stop();
+  return true;
+}
+
+// [s] a move over distance takes with the profile, speeding up and slowing down
+float profile_move_duration(long distance, float speed, float acceleration) {
+  float ramps = speed * speed / acceleration; // [steps] to reach speed and stop again
+  if (distance < ramps) {
+    return 2.0 * sqrt(distance / acceleration);
+  }
+  return 2.0 * speed / acceleration + (distance - ramps) / speed;
+}
+
+// position the approach stops at before the sensor, or the position itself when crawling all the way is as fast
+long probe_approach_position() {
+  float probe_speed = preference_auto_zero_speed * preference_motor_direction;
+  if (!status_probe_expected_valid || probe_speed == 0.0) {
+    return status_motion.position;
+  }
+  long direction = probe_speed > 0 ? 1 : -1;
+  long approach  = status_probe_expected - direction * (long)(PROBE_APPROACH_CLEARANCE / mm_per_step());
+  long distance  = (approach - status_motion.position) * direction;
+  // set_speed() caps the probe speed at the maximal speed of the profile as well
+  float speed_maximal = preference_motor_speed_maximal >> status_slow_speed;
+  float acceleration  = preference_motor_acceleration >> status_slow_speed;
+  if (distance <= 0 || profile_move_duration(distance, speed_maximal, acceleration) >= distance / min(fabsf(probe_speed), speed_maximal)) {
+    return status_motion.position;
+  }
+  return approach;
+}
+
+bool entry_goto_tool_length_sensor() {
+  deactivate_target();
+  long approach = probe_approach_position();
+  if (approach != status_motion.position) {
+    Serial.printf("probe approach: %ld\n", approach);
+    motion_approach_probe(approach, resonance_free_speed(preference_auto_zero_speed * preference_motor_direction));
+  } else {
+    motion_probe(resonance_free_speed(preference_auto_zero_speed * preference_motor_direction));
+  }
+  return true;
+}
+
+bool entry_finish_tool_length_sensor() {
+  free_sensor_tool_length();
+  // set target position at tool_length_height, the motion task starts it once the sensor is free
+  motion_move(-preference_sensor_tool_length_height / mm_per_step() * preference_motor_direction);
+  return true;
+}
+
+// starts at pass 0, the first press goes to pass 1
+bool entry_depth_passes() {
+  status_pass_start = status_motion.position;
+  status_pass_step  = lroundf(preference_pass_step / mm_per_step());
+  status_pass       = 0;
+  status_pass_count = passes_for(status_pass_start - status_target_lower_limit, status_pass_step);
+  Serial.printf("passes: %ld of %ld steps\n", status_pass_count, status_pass_step);
+  return true;
+}
+
+// constant speed without a ramp, the whole way is at the feed rate; the motion task stops it at the target
+// or a workspace limit like every other move; only the motor maximum and the resonance bands change it
+void run_feed() {
+  float requested = preference_feed_rate * status_feed_override / 100.0 / 60.0 / mm_per_step(); // [steps per second]
+  float speed = resonance_free_speed(min(requested, (float)preference_motor_speed_maximal));
+  status_feed_rate    = lroundf(speed * 60.0 * mm_per_step());
+  status_feed_limited = speed != requested;
+  Serial.printf("feed: %ld mm/min at %ld%%, runs at %ld mm/min\n", preference_feed_rate, status_feed_override, status_feed_rate);
+  motion_run_speed(-speed);
+}
+
+// slow speed halves speed and acceleration, the cruise stays out of the resonance bands either way
+void update_profile() {
+  motion_set_profile(resonance_free_speed(preference_motor_speed_maximal >> status_slow_speed), preference_motor_acceleration >> status_slow_speed);
+}
+
+// every plunge starts at the feed rate as set; the profile caps constant speeds too,
+// so the feed gets the one of fast speed whatever the speed mode is
+bool entry_feed_plunge() {
+  status_feed_override = 100;
+  motion_set_profile(resonance_free_speed(preference_motor_speed_maximal), preference_motor_acceleration);
+  run_feed();
+  return true;
+}
+
+void exit_feed_plunge() {
+  motion_halt();
+  update_profile();
+}
+
+// sends only what change_setting() says a page changed, a detent should not cost a command per setting
+void update_motion_settings(int changed) {
+  if (changed & setting_group_backlash) {
+    update_backlash();
+  }
+  if (changed & setting_group_pitch_table) {
+    update_pitch_table();
+  }
+  if (changed & setting_group_profile) {
+    update_profile();
+  }
+}
+
+bool entry_reset() {
+  reset_settings_to_default();
+  update_motion_settings(setting_group_all);
+  return true;
+}
+
+// COMPUTED VALUES END
+
+void toggle_target() {
+  status_target_restore = false;
+  if (status_target_active) {
+    deactivate_target();
+  } else {
+    activate_target();
+  }
+}
+
+// a target set for the last tool stays at its height above the table
+void move_tool_zero_to(long zero) {
+  status_target_lower_limit += zero - status_tool_zero;
+  status_tool_zero = zero;
+  Serial.printf("tool zero: %ld, work zero G%ld: %ld\n", status_tool_zero, 54 + preference_work_offset_slot, work_zero());
+}
+
+void set_zero() {
+  deactivate_target();
+  move_tool_zero_to(status_motion.position);
+}
+
+// the target height stays the same above the table, so it holds for the next tool as well
+void restore_target() {
+  if (status_target_restore) {
+    status_target_active = true;
+    motion_set_target(true, status_target_lower_limit);
+  }
+  status_target_restore = false;
+}
+
+bool is_tool_table_enabled() {
+  return preference_tool_table_enabled;
+}
+
+bool is_selected_tool_known() {
+  return is_tool_known(status_tool_slot);
+}
+
+// zero where auto zero put it with this tool, without probing;
+// with verify on, the next auto zero has to end up at the same zero
+void apply_tool_offset() {
+  status_tool_selected  = true;
+  status_tool_verifying = preference_tool_verify_enabled;
+  move_tool_zero_to(preference_tool_offsets[status_tool_slot]);
+  // auto zero freed the sensor and went down by its height to this zero
+  status_probe_expected = status_tool_zero + (long)(preference_sensor_tool_length_height / mm_per_step() + FREE_SENSOR_TOLERANCE) * preference_motor_direction;
+  status_probe_expected_valid = true;
+  restore_target();
+}
+
+// the next auto zero measures the offset
+void select_new_tool() {
+  status_tool_selected = true;
+}
+
+void forget_selected_tool() {
+  forget_tool(status_tool_slot);
+}
+
+void finish_auto_zero() {
+  if (status_tool_selected && status_machine_referenced) {
+    store_tool_offset(status_tool_slot, status_motion.position);
+  }
+  set_zero();
+  if (status_tool_selected) {
+    restore_target();
+  }
+  status_tool_verifying = false;
+}
+
+void show_overlay(enum overlays overlay) {
+  status_overlay          = overlay;
+  status_overlay_shown_at = millis();
+}
+
+void keep_preset_visible() {
+  show_overlay(overlay_preset);
+}
+
+void select_preset(long steps) {
+  status_preset_slot = ((status_preset_slot + steps) % PRESET_SLOTS_COUNT + PRESET_SLOTS_COUNT) % PRESET_SLOTS_COUNT;
+  keep_preset_visible();
+}
+
+void store_preset_here() {
+  store_preset(status_preset_slot, position_in_mm(work_position(status_motion.position)));
+  keep_preset_visible();
+}
+
+// one planned move, ending at the target or workspace limit instead of running into it
+void recall_preset() {
+  keep_preset_visible();
+  if (!is_preset_stored(status_preset_slot)) {
+    return;
+  }
+  long position = work_zero() + lroundf(preference_presets[status_preset_slot] / mm_per_step()) * preference_motor_direction;
+  if (status_workspace_active) {
+    position = constrain(position, min(status_workspace_lower_limit, status_workspace_upper_limit),
+                         max(status_workspace_lower_limit, status_workspace_upper_limit));
+  }
+  if (status_target_active) {
+    position = max(position, status_target_lower_limit);
+  }
+  Serial.printf("preset %ld to: %ld\n", status_preset_slot + 1, position);
+  motion_move_to(position);
+}
+
+void change_pass_step_here(long steps) {
+  change_pass_step(steps);
+  show_overlay(overlay_pass_step);
+}
+
+// the target is the final height, so there is something above the bit to cut in passes
+bool can_start_passes() {
+  return status_target_active && status_motion.position > status_target_lower_limit
+         && lroundf(preference_pass_step / mm_per_step()) > 0;
+}
+
+// the motion task stops at the target anyway, the last pass ends there exactly
+void next_pass() {
+  if (status_pass >= status_pass_count) {
+    return;
+  }
+  status_pass++;
+  long position = status_pass_start - pass_distance(status_pass, status_pass_start - status_target_lower_limit, status_pass_step);
+  Serial.printf("pass %ld/%ld to: %ld\n", status_pass, status_pass_count, position);
+  motion_move_to(position);
+}
+
+void change_feed_rate_here(long steps) {
+  change_feed_rate(steps);
+  show_overlay(overlay_feed_rate);
+}
+
+// like depth passes the feed goes up to the target, so it has to be above the bit
+bool can_start_feed() {
+  return status_target_active && status_motion.position > status_target_lower_limit;
+}
+
+void toggle_diagnostics() {
+  status_diagnostics_visible = !status_diagnostics_visible;
+}
+
+void previous_settings_page() {
+  status_settings_menu_active_page -= 1;
+  status_settings_menu_active_page = (status_settings_menu_active_page + status_settings_menu_pages_count) % status_settings_menu_pages_count;
+}
+
+void next_settings_page() {
+  status_settings_menu_active_page += 1;
+  status_settings_menu_active_page = (status_settings_menu_active_page + status_settings_menu_pages_count) % status_settings_menu_pages_count;
+}
+
+// STATE TICKS START
+enum events tick_default_start() {
+  // FREE END STOP SENSOR
+  if (status_motion.faulted) {
+    return error_with(ERROR_END_STOP);
+  } else if (status_motion.end_stop_triggered && is_motion_settled(status_motion)) {
+    free_sensor_end_stop();
+  }
+
+  // MOVE WITH ENCODER
+  if (input_encoder_steps) {
+    // from where the carriage is; approaching from below it goes past the target on purpose, so from where it ends up
+    bool approaching = preference_approach_from_below && (status_motion.mode == motion_accelerate || status_motion.mode == motion_overshooting);
+    long from = approaching ? status_motion.target : status_motion.position;
+    long distance;
+    if (status_slow_speed) {
+      // move according steps and make sure it i always a multiple of preference_motor_steps_slow
+      distance = input_encoder_steps * preference_motor_steps_slow * preference_motor_direction - (work_position(from) % preference_motor_steps_slow);
+    } else {
+      // move according steps and make sure it i always a multiple of preference_motor_steps_fast plus finer position from moving with preference_motor_steps_slow
+      distance = input_encoder_steps * preference_motor_steps_fast * preference_motor_direction - (work_position(from) % preference_motor_steps_fast) + status_slow_offset;
+    }
+    motion_move_to(from + distance);
+    Serial.printf("targetPosition(): %ld\n", from + distance);
+    input_encoder_steps = 0;
+  }
+
+  // GO TO WORKSPACE MINIMUM
+  if (consume_input(input_goto_bottom_press)) {
+    if (status_workspace_active) {
+      motion_move_to(status_workspace_upper_limit);
+    }
+  }
+
+  // HEIGHT PRESETS, goto bottom held while turning selects, releasing it recalls, holding it alone stores
+  if (consume_input(input_preset_select)) {
+    select_preset(input_pending_steps);
+  } else if (consume_input(input_preset_recall)) {
+    recall_preset();
+  } else if (consume_input(input_goto_bottom_hold)) {
+    store_preset_here();
+  }
+
+  // DEPTH PASS STEP, set speed held while turning, kept once it is released
+  if (consume_input(input_pass_step)) {
+    change_pass_step_here(input_pending_steps);
+  } else if (consume_input(input_pass_step_set)) {
+    save_pass_step();
+  }
+
+  // FEED RATE, set zero held while turning, kept once it is released
+  if (consume_input(input_feed_rate)) {
+    change_feed_rate_here(input_pending_steps);
+  } else if (consume_input(input_feed_rate_set)) {
+    save_feed_rate();
+  }
+
+  // TOGGLE TARGET
+  if (consume_input(input_set_speed_hold)) {
+    toggle_target();
+  }
+
+  // MOVE UP OR DOWN WHILE BUTTON IS HELD
+  long jog_direction = status_inputs.active<button_up_pin>() - status_inputs.active<button_down_pin>();
+  if (jog_direction != status_jog_direction) {
+    if (jog_direction) {
+      motion_run_speed(resonance_free_speed(jog_direction * preference_motor_speed_maximal * preference_motor_direction));
+    } else {
+      motion_halt();
+    }
+    status_jog_direction = jog_direction;
+  }
+
+  // TOGGLE SPEED
+  if (consume_input(input_set_speed_press)) {
+    status_slow_speed = !status_slow_speed;
+    status_slow_offset = work_position(status_motion.target) % preference_motor_steps_fast;
+    update_profile();
+  }
+
+  // STATE CHANGES
+  if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  } else if (consume_input(input_set_zero_press)) {
+    return event_set_zero_press;
+  } else if (consume_input(input_set_zero_hold)) {
+    return event_set_zero_hold;
+  } else if (consume_input(input_pass_start)) {
+    return event_pass_start;
+  } else if (consume_input(input_feed_start)) {
+    return event_feed_start;
+  }
+  return event_none;
+}
+
+enum events tick_goto_tool_length_sensor() {
+  // keep moving until the motion task latched the sensor or got blocked
+  if (!is_motion_settled(status_motion)) {
+    return event_none;
+  } else if (status_motion.probe_triggered) {
+    status_probe_expected       = status_motion.probe_position;
+    status_probe_expected_valid = true;
+    return event_tool_length_trigger;
+  }
+  return error_with(ERROR_AUTO_ZERO);
+}
+
+enum events tick_finish_tool_length_sensor() {
+  // move until at target or not allowed
+  if (status_motion.faulted || status_motion.blocked) {
+    return error_with(ERROR_AUTO_ZERO);
+  } else if (is_motion_settled(status_motion)) {
+    // the offset already put the zero here, unless it belongs to another tool
+    if (status_tool_verifying && labs(status_motion.position - status_tool_zero) * mm_per_step() > TOOL_VERIFY_TOLERANCE) {
+      return error_with(ERROR_TOOL_OFFSET);
+    }
+    return event_target_reached;
+  }
+  return event_none;
+}
+
+enum events tick_goto_toolchange() {
+  // STATE CHANGES
+  if (status_motion.end_stop_triggered) {
+    return event_end_stop_trigger;
+  } else if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  }
+  return event_none;
+}
+
+enum events tick_finish_toolchange() {
+  // wait until the end stop is free again
+  if (status_motion.faulted) {
+    return error_with(ERROR_END_STOP);
+  } else if (is_motion_settled(status_motion)) {
+    return event_done;
+  }
+  return event_none;
+}
+
+enum events tick_select_tool() {
+  if (input_encoder_steps) {
+    status_tool_slot = ((status_tool_slot + input_encoder_steps) % TOOL_SLOTS_COUNT + TOOL_SLOTS_COUNT) % TOOL_SLOTS_COUNT;
+    input_encoder_steps = 0;
+  }
+
+  if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  } else if (consume_input(input_set_zero_press)) {
+    return event_set_zero_press;
+  } else if (consume_input(input_set_zero_hold)) {
+    return event_set_zero_hold;
+  }
+  return event_none;
+}
+
+enum events tick_depth_passes() {
+  if (status_motion.faulted) {
+    return error_with(ERROR_END_STOP);
+  }
+
+  if (consume_input(input_goto_bottom_press)) {
+    return event_goto_bottom_press;
+  } else if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  }
+  return event_none;
+}
+
+enum events tick_feed_plunge() {
+  if (status_motion.faulted) {
+    return error_with(ERROR_END_STOP);
+  }
+
+  // FEED OVERRIDE, the encoder changes the speed on the way
+  if (input_encoder_steps) {
+    status_feed_override = constrain(status_feed_override + input_encoder_steps * FEED_OVERRIDE_STEP,
+                                     (long)FEED_OVERRIDE_MINIMAL, (long)FEED_OVERRIDE_MAXIMAL);
+    run_feed();
+    input_encoder_steps = 0;
+  }
+
+  if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  } else if (is_motion_settled(status_motion)) {
+    // stopped at the target, or short of it at a workspace limit or the end stop
+    return event_target_reached;
+  }
+  return event_none;
+}
+
+// leaves the state once its minimum_duration is over
+enum events tick_done() {
+  return event_done;
+}
+
+enum events tick_settings_menu() {
+  if (input_encoder_steps) {
+    update_motion_settings(change_setting(status_settings_menu_active_page, input_encoder_steps));
+    input_encoder_steps = 0;
+  }
+
+  if (consume_input(input_toolchange_press)) {
+    return event_toolchange_press;
+  } else if (consume_input(input_set_zero_press)) {
+    return event_set_zero_press;
+  } else if (consume_input(input_set_zero_hold)) {
+    return event_set_zero_hold;
+  } else if (consume_input(input_goto_bottom_press)) {
+    return event_goto_bottom_press;
+  } else if (consume_input(input_goto_bottom_hold)) {
+    return event_goto_bottom_hold;
+  }
+  return event_none;
+}
+
+enum events tick_error() {
+  if (consume_input(input_set_zero_hold)) {
+    return event_set_zero_hold;
+  }
+  return event_none;
+}
+// STATE TICKS END
+
+// STATE TABLES START
+constexpr state_handlers state_table[states_count] = {
+  // state                      name                         entry                            exit             tick                            minimum_duration
+  { default_start,             "default_start",             nullptr,                         nullptr,         tick_default_start,             0 },
+  { goto_tool_length_sensor,   "goto_tool_length_sensor",   entry_goto_tool_length_sensor,   exit_halt_motor, tick_goto_tool_length_sensor,   0 },
+  { finish_tool_length_sensor, "finish_tool_length_sensor", entry_finish_tool_length_sensor, exit_halt_motor, tick_finish_tool_length_sensor, 0 },
+  { goto_toolchange,           "goto_toolchange",           entry_goto_toolchange,           exit_halt_motor, tick_goto_toolchange,           0 },
+  { finish_toolchange,         "finish_toolchange",         entry_finish_toolchange,         nullptr,         tick_finish_toolchange,         0 },
+  { select_tool,               "select_tool",               nullptr,                         nullptr,         tick_select_tool,               0 },
+  { depth_passes,              "depth_passes",              entry_depth_passes,              exit_halt_motor, tick_depth_passes,              0 },
+  { feed_plunge,               "feed_plunge",               entry_feed_plunge,               exit_feed_plunge, tick_feed_plunge,              0 },
+  { settings_menu,             "settings_menu",             nullptr,                         nullptr,         tick_settings_menu,             0 },
+  { reset,                     "reset",                     entry_reset,                     nullptr,         tick_done,                      DURATION_SHOW_MESSAGE },
+  { error,                     "error",                     entry_error,                     nullptr,         tick_error,                     0 },
+};
+
+// sorted by from and event, rows of the same cell are tried top down
+constexpr transition transition_table[] = {
+  // from                       event                       guard                            action                  to
+  { default_start,             event_toolchange_press,     nullptr,                         nullptr,                goto_toolchange },
+  { default_start,             event_set_zero_press,       is_sensor_tool_length_enabled,   nullptr,                goto_tool_length_sensor },
+  { default_start,             event_set_zero_press,       nullptr,                         set_zero,               STATE_UNCHANGED },
+  { default_start,             event_set_zero_hold,        nullptr,                         nullptr,                settings_menu },
+  { default_start,             event_pass_start,           can_start_passes,                nullptr,                depth_passes },
+  { default_start,             event_feed_start,           can_start_feed,                  nullptr,                feed_plunge },
+  { default_start,             event_fault,                nullptr,                         nullptr,                error },
+  { goto_tool_length_sensor,   event_tool_length_trigger,  nullptr,                         nullptr,                finish_tool_length_sensor },
+  { goto_tool_length_sensor,   event_fault,                nullptr,                         nullptr,                error },
+  { finish_tool_length_sensor, event_target_reached,       nullptr,                         finish_auto_zero,       default_start },
+  { finish_tool_length_sensor, event_fault,                nullptr,                         nullptr,                error },
+  { goto_toolchange,           event_toolchange_press,     nullptr,                         nullptr,                default_start },
+  { goto_toolchange,           event_end_stop_trigger,     nullptr,                         nullptr,                finish_toolchange },
+  { goto_toolchange,           event_fault,                nullptr,                         nullptr,                error },
+  { finish_toolchange,         event_done,                 is_tool_table_enabled,           activate_workspace,     select_tool },
+  { finish_toolchange,         event_done,                 nullptr,                         activate_workspace,     default_start },
+  { finish_toolchange,         event_fault,                nullptr,                         nullptr,                error },
+  { select_tool,               event_toolchange_press,     nullptr,                         nullptr,                default_start },
+  { select_tool,               event_set_zero_press,       is_selected_tool_known,          apply_tool_offset,      default_start },
+  { select_tool,               event_set_zero_press,       nullptr,                         select_new_tool,        default_start },
+  { select_tool,               event_set_zero_hold,        nullptr,                         forget_selected_tool,   STATE_UNCHANGED },
+  { select_tool,               event_fault,                nullptr,                         nullptr,                error },
+  { depth_passes,              event_toolchange_press,     nullptr,                         nullptr,                default_start },
+  { depth_passes,              event_goto_bottom_press,    nullptr,                         next_pass,              STATE_UNCHANGED },
+  { depth_passes,              event_fault,                nullptr,                         nullptr,                error },
+  { feed_plunge,               event_toolchange_press,     nullptr,                         nullptr,                default_start },
+  { feed_plunge,               event_target_reached,       nullptr,                         nullptr,                default_start },
+  { feed_plunge,               event_fault,                nullptr,                         nullptr,                error },
+  { settings_menu,             event_toolchange_press,     nullptr,                         previous_settings_page, STATE_UNCHANGED },
+  { settings_menu,             event_set_zero_press,       nullptr,                         next_settings_page,     STATE_UNCHANGED },
+  { settings_menu,             event_set_zero_hold,        nullptr,                         nullptr,                default_start },
+  { settings_menu,             event_goto_bottom_press,    nullptr,                         toggle_diagnostics,     STATE_UNCHANGED },
+  { settings_menu,             event_goto_bottom_hold,     nullptr,                         nullptr,                reset },
+  { settings_menu,             event_fault,                nullptr,                         nullptr,                error },
+  { reset,                     event_done,                 nullptr,                         nullptr,                default_start },
+  { reset,                     event_fault,                nullptr,                         nullptr,                error },
+  { error,                     event_set_zero_hold,        nullptr,                         nullptr,                settings_menu },
+};
+
+static_assert(state_handlers_are_in_order(state_table), "state_table has to list every state in enum order");
+static_assert(transitions_are_valid(transition_table), "transition_table has a row with an invalid state or event");
+static_assert(transitions_are_sorted(transition_table), "transition_table has to be sorted by from and event");
+static_assert(transitions_are_reachable(transition_table), "transition_table has a row hidden by an unguarded row above");
+static_assert(faults_lead_to_error(transition_table), "transition_table misses an event_fault row into error");
+static_assert(states_can_be_left(transition_table), "transition_table has a state without a way out");
+
+static_assert(passes_for(1000, 250) == 4 && passes_for(1001, 250) == 5 && passes_for(0, 250) == 0,
+              "depth passes have to cover the distance with the fewest passes");
+static_assert(pass_distance(4, 1001, 250) == 1000 && pass_distance(5, 1001, 250) == 1001,
+              "the last depth pass has to end at the distance");
+
+constexpr transition_index transition_lookup = index_transitions(transition_table);
+// STATE TABLES END
+
+void change_state_to(enum states new_state, void (*action)()) {
+  Serial.printf("%s -> %s\n", state_table[current_state].name, state_table[new_state].name);
+  if (state_table[current_state].exit) {
+    state_table[current_state].exit();
+  }
+  if (action) {
+    action();
+  }
+  current_state = new_state;
+  current_state_entered_at = millis();
+  if (state_table[new_state].entry && !state_table[new_state].entry()) {
+    // entry has set the error message
+    Serial.printf("%s -> %s\n", state_table[new_state].name, state_table[error].name);
+    current_state = error;
+    state_table[error].entry();
+  }
+}
+
+void dispatch(enum events event) {
+  const transition_range &range = transition_lookup.cell[current_state][event];
+  for (uint8_t row = range.first; row < range.first + range.count; row++) {
+    const transition &candidate = transition_table[row];
+    if (candidate.guard && !candidate.guard()) {
+      continue;
+    }
+    if (candidate.to != STATE_UNCHANGED) {
+      // keep a transient screen up without blocking the loop, faults leave right away
+      if (event != event_fault && millis() - current_state_entered_at < state_table[current_state].minimum_duration) {
+        return;
+      }
+      change_state_to(candidate.to, candidate.action);
+    } else {
+      candidate.action();
+    }
+    return;
+  }
+}
+
+void publish_control_status() {
+  control_status status = {
+    current_state,
+    status_target_active,
+    position_in_mm(work_position(status_target_lower_limit)),
+    status_slow_speed,
+    status_workspace_active,
+    status_workspace_upper_limit,
+    status_workspace_lower_limit,
+    status_settings_menu_active_page,
+    work_zero(),
+    status_tool_slot,
+    status_tool_selected,
+    status_preset_slot,
+    millis() - status_overlay_shown_at < DURATION_SHOW_OVERLAY ? status_overlay : overlay_none,
+    status_pass,
+    status_pass_count,
+    status_feed_rate,
+    status_feed_limited,
+    status_error_message,
+    status_diagnostics_visible
+  };
+  control_status_for_display.write(status);
+}
+
+void control_tick() {
+  status_inputs = sample_inputs();
+  bool was_moving = status_motion.mode != motion_idle;
+  motion_status_for_control.read(status_motion);
+  if (was_moving && status_motion.mode == motion_idle) {
+    Serial.printf("worst step latency: %lu us\n", status_motion.tick_period_maximal);
+  }
+  receive_inputs();
+  receive_sensor_edges();
+  dispatch(state_table[current_state].tick());
+  publish_control_status();
+
+  if (millis() - status_diagnostics_sampled_at >= DIAGNOSTICS_INTERVAL) {
+    sample_diagnostics(status_diagnostics);
+    status_diagnostics.control_tick_period_maximal = status_tick_period_maximal;
+    diagnostics_for_display.write(status_diagnostics);
+    status_diagnostics_sampled_at = millis();
+  }
+  // 'd' on the serial monitor prints the latest report, 'g' times the GPIO access
+  if (Serial.available()) {
+    char command = Serial.read();
+    if (command == 'd') {
+      print_diagnostics(status_diagnostics);
+      print_sensor_filters();
+    } else if (command == 'g' && status_motion.mode == motion_idle
+               && status_motion.command_sequence == motion_commands_sent) {
+      // writes DIR with its own level, so only while the motion task has nothing to do
+      print_gpio_benchmark(benchmark_gpio<sensor_end_stop_trigger_pin, direction_pin>());
+    }
+  }
+}
+
+void control_loop(void * parameter) {
+  // everything is set up once this task runs, allocations from here on are reported
+  begin_diagnostics();
+  sample_diagnostics(status_diagnostics);
+  print_diagnostics(status_diagnostics);
+  status_diagnostics_sampled_at = millis();
+  // on this core the sampler interrupt stays off the step timing of the motion task
+  begin_sensor_filters();
+
+  // a state holding up the loop shows up here, transient screens must not
+  uint32_t ticked_at = micros();
+  while (true) {
+    uint32_t now = micros();
+    status_tick_period_maximal = max(status_tick_period_maximal, now - ticked_at);
+    ticked_at = now;
+    control_tick();
+    // state changes need no more than a millisecond, the rest of the core is for the display
+    task_delay(diagnostics_control_task, 1);
+  }
+}
+
+void begin_control() {
+  update_backlash();
+  if (preference_power_on_toolchange) {
+    dispatch(event_toolchange_press);
+  }
+
+  // core 1 belongs to the motion task, so the state machine runs next to the display
+  xTaskCreatePinnedToCore(
+    control_loop, /* Function to implement the task */
+    "ControlTask", /* Name of the task */
+    CONTROL_TASK_STACK_SIZE,  /* Stack size in bytes */
+    NULL,  /* Task input parameter */
+    CONTROL_TASK_PRIORITY,  /* Priority of the task */
+    &task_loads[diagnostics_control_task].handle,  /* Task handle. */
+    CONTROL_TASK_CORE); /* Core where the task should run */
+}
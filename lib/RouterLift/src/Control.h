@@ -0,0 +1,103 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <Arduino.h>
+#include "Channel.h"
+#include "Diagnostics.h"
+#include "Motion.h"
+#include "StateMachine.h"
+
+#define DURATION_SHOW_MESSAGE 1000 // [ms]
+#define DURATION_SHOW_OVERLAY 2000 // [ms] after the last preset, pass step or feed rate input
+
+#define MM_TO_FREE_ERROR 3.0 // [mm]
+
+#define FREE_SENSOR_TOLERANCE 30 // [steps]
+
+#define TOOL_VERIFY_TOLERANCE 0.2 // [mm] a verify probe further off means the wrong tool was picked
+
+#define PROBE_APPROACH_CLEARANCE 2.0 // [mm] short of the expected trigger the fast approach stops at
+
+#define APPROACH_OVERSHOOT 1.0 // [mm] past the target and the backlash a move down goes before coming up to it
+
+#define FEED_OVERRIDE_STEP     10  // [% per encoder step] turned during a feed plunge
+#define FEED_OVERRIDE_MINIMAL  10  // [%]
+#define FEED_OVERRIDE_MAXIMAL  200 // [%]
+
+#define ERROR_END_STOP      "ENDSTOP ERR"
+#define ERROR_AUTO_ZERO     "AUTOZERO ERR"
+#define ERROR_INVALID_STATE "INVALID STATE"
+#define ERROR_TOOL_OFFSET   "TOOL OFFSET ERR"
+
+#define CONTROL_TASK_STACK_SIZE 8192 // [bytes]
+#define CONTROL_TASK_PRIORITY   3
+#define CONTROL_TASK_CORE       0
+
+// STATUS VALUES START
+// shown in place of speed and target for DURATION_SHOW_OVERLAY
+enum overlays {
+  overlay_none,
+  overlay_preset,
+  overlay_pass_step,
+  overlay_feed_rate
+};
+
+// what the display task needs from the control task
+struct control_status {
+  enum states state;
+  bool  target_active;
+  float target_height; // mm above the work zero
+  bool  slow_speed;
+  bool  workspace_active;
+  long  workspace_upper_limit; // steps
+  long  workspace_lower_limit; // steps
+  long  settings_menu_active_page;
+  long  work_zero; // steps, machine position the display counts from
+  long  tool_slot;
+  bool  tool_selected; // the bit in the router is the tool of tool_slot
+  long  preset_slot;
+  enum overlays overlay;
+  long  pass;       // of depth_passes, 0 before the first
+  long  pass_count;
+  long  feed_rate;     // [mm per minute] the feed runs at, of feed_plunge
+  bool  feed_limited;  // the motor maximum or a resonance band changed it
+  const char *error_message;
+  bool diagnostics_visible;
+};
+
+extern mailbox<control_status> control_status_for_display; // control task -> display task
+extern mailbox<diagnostics_report> diagnostics_for_display; // control task -> display task
+
+// only touched by the control task
+extern motion_status status_motion; // snapshot of the motion task
+extern bool status_machine_referenced; // a toolchange put machine 0 where the end stop triggers
+extern uint32_t status_tick_period_maximal; // [us] longest time from one control tick to the next since boot
+// STATUS VALUES END
+
+// STATE TABLES START
+extern const state_handlers state_table[states_count];
+// STATE TABLES END
+
+// CONTROL START
+void dispatch(enum events event);
+void control_tick();
+
+// [steps] of a machine position from the work zero, control task only
+long work_position(long machine_position);
+
+// sends the pitch errors of the settings to the motion task, a perfect screw until the machine is referenced
+void update_pitch_table();
+
+// depth passes of step going distance, the last one ends at distance exactly
+constexpr long passes_for(long distance, long step) {
+  return distance <= 0 || step <= 0 ? 0 : (distance + step - 1) / step;
+}
+constexpr long pass_distance(long pass, long distance, long step) {
+  return pass * step < distance ? pass * step : distance;
+}
+
+// runs the power on toolchange and starts the control task, call once everything else is set up
+void begin_control();
+// CONTROL END
+
+#endif // CONTROL_H
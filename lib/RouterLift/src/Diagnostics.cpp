@@ -0,0 +1,112 @@
+#include "Diagnostics.h"
+
+// DIAGNOSTICS VALUES START
+task_load task_loads[diagnostics_tasks_count] = {
+  { "MotionTask",  NULL, {0} },
+  { "ControlTask", NULL, {0} },
+  { "DisplayTask", NULL, {0} },
+};
+
+std::atomic<uint32_t> tick_periods[TICK_PERIOD_BUCKETS] = {};
+
+// only touched by the control task
+uint32_t diagnostics_sampled_at = 0; // [us]
+uint32_t diagnostics_delayed_before[diagnostics_tasks_count] = {};
+uint32_t diagnostics_heap_blocks_after_setup = 0;
+// DIAGNOSTICS VALUES END
+
+void task_delay(enum diagnostics_tasks task, TickType_t ticks) {
+  uint32_t started = micros();
+  vTaskDelay(ticks);
+  task_loads[task].delayed.fetch_add(micros() - started, std::memory_order_relaxed);
+}
+
+uint32_t tick_period_percentile(const uint32_t (&counts)[TICK_PERIOD_BUCKETS], uint8_t percent) {
+  uint64_t total = 0;
+  for (uint32_t count : counts) {
+    total += count;
+  }
+  if (!total) {
+    return 0;
+  }
+  uint64_t below = 0;
+  for (int bucket = 0; bucket < TICK_PERIOD_BUCKETS - 1; bucket++) {
+    below += counts[bucket];
+    if (below * 100 >= total * percent) {
+      return (bucket + 1) * TICK_PERIOD_BUCKET_WIDTH;
+    }
+  }
+  return UINT32_MAX;
+}
+
+void sample_tick_periods(uint32_t (&counts)[TICK_PERIOD_BUCKETS]) {
+  for (int bucket = 0; bucket < TICK_PERIOD_BUCKETS; bucket++) {
+    counts[bucket] = tick_periods[bucket].load(std::memory_order_relaxed);
+  }
+}
+
+void sample_heap(diagnostics_report &report) {
+  multi_heap_info_t heap;
+  heap_caps_get_info(&heap, MALLOC_CAP_8BIT);
+  report.heap_free               = heap.total_free_bytes;
+  report.heap_free_minimal       = heap.minimum_free_bytes;
+  report.heap_largest_block      = heap.largest_free_block;
+  report.heap_blocks             = heap.allocated_blocks;
+  report.heap_blocks_since_setup = (long)heap.allocated_blocks - (long)diagnostics_heap_blocks_after_setup;
+}
+
+void begin_diagnostics() {
+  multi_heap_info_t heap;
+  heap_caps_get_info(&heap, MALLOC_CAP_8BIT);
+  diagnostics_heap_blocks_after_setup = heap.allocated_blocks;
+  diagnostics_sampled_at = micros();
+}
+
+void sample_diagnostics(diagnostics_report &report) {
+  uint32_t now = micros();
+  uint32_t elapsed = now - diagnostics_sampled_at;
+  diagnostics_sampled_at = now;
+
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    uint32_t delayed = task_loads[task].delayed.load(std::memory_order_relaxed);
+    uint32_t busy = elapsed - min(elapsed, delayed - diagnostics_delayed_before[task]);
+    diagnostics_delayed_before[task] = delayed;
+
+    report.tasks[task].name       = task_loads[task].name;
+    report.tasks[task].cpu_share  = elapsed ? (uint64_t)busy * 100 / elapsed : 0;
+    report.tasks[task].stack_free = task_loads[task].handle ? uxTaskGetStackHighWaterMark(task_loads[task].handle) : 0;
+  }
+
+  uint32_t counts[TICK_PERIOD_BUCKETS];
+  sample_tick_periods(counts);
+  report.tick_period_median          = tick_period_percentile(counts, 50);
+  report.tick_period_slowest_percent = tick_period_percentile(counts, 99);
+  for (int sensor = 0; sensor < filtered_sensors_count; sensor++) {
+    report.sensor_edges[sensor]           = sensor_edge_summaries[sensor];
+    report.sensor_latency_maximal[sensor] = sensor_filter_latency_maximal[sensor].load(std::memory_order_relaxed);
+  }
+  sample_heap(report);
+}
+
+void print_diagnostics(const diagnostics_report &report) {
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    Serial.printf("%-12s cpu %3u %%  stack free %6u bytes\n",
+                  report.tasks[task].name, report.tasks[task].cpu_share, report.tasks[task].stack_free);
+  }
+  Serial.printf("motion tick median %u us, 99 %% below %u us\n",
+                report.tick_period_median, report.tick_period_slowest_percent);
+  Serial.printf("control tick longest %u us\n", report.control_tick_period_maximal);
+  for (int sensor = 0; sensor < filtered_sensors_count; sensor++) {
+    const sensor_edge_summary &summary = report.sensor_edges[sensor];
+    Serial.printf("%-12s edges %u, filter latency max %u us", filtered_sensor_names[sensor],
+                  summary.edges, report.sensor_latency_maximal[sensor]);
+    if (summary.edges) {
+      Serial.printf(", last %s at %u us after %u us", summary.last.active ? "triggered" : "free",
+                    summary.last.at, summary.last.latency);
+    }
+    Serial.printf("\n");
+  }
+  Serial.printf("heap free %u bytes, minimal %u bytes, largest block %u bytes\n",
+                report.heap_free, report.heap_free_minimal, report.heap_largest_block);
+  Serial.printf("heap blocks %u, %+ld since setup\n", report.heap_blocks, report.heap_blocks_since_setup);
+}
@@ -0,0 +1,72 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_heap_caps.h>
+#include "SensorFilter.h"
+
+#define DIAGNOSTICS_INTERVAL 1000 // [ms]
+#define TICK_PERIOD_BUCKETS      32
+#define TICK_PERIOD_BUCKET_WIDTH 1 // [us] the last bucket counts everything longer
+
+// DIAGNOSTICS VALUES START
+enum diagnostics_tasks {
+  diagnostics_motion_task,
+  diagnostics_control_task,
+  diagnostics_display_task,
+  diagnostics_tasks_count
+};
+
+struct task_load {
+  const char *name;
+  TaskHandle_t handle;
+  std::atomic<uint32_t> delayed; // [us] time spent in task_delay(), only written by the task itself
+};
+
+extern task_load task_loads[diagnostics_tasks_count];
+
+struct task_report {
+  const char *name;
+  uint8_t  cpu_share;  // [%] time not spent in task_delay(), so waiting on the I2C bus counts as busy
+  uint32_t stack_free; // [bytes] lowest amount of free stack since the task started
+};
+
+// periods of the motion tick while moving, only written by the motion task
+extern std::atomic<uint32_t> tick_periods[TICK_PERIOD_BUCKETS];
+
+struct diagnostics_report {
+  task_report tasks[diagnostics_tasks_count];
+  uint32_t tick_period_median; // [us] upper bound of the bucket
+  uint32_t tick_period_slowest_percent; // [us] 99th percentile, upper bound of the bucket
+  uint32_t control_tick_period_maximal; // [us] longest time between two control ticks since boot
+  sensor_edge_summary sensor_edges[filtered_sensors_count];
+  uint32_t sensor_latency_maximal[filtered_sensors_count]; // [us] of the filters since boot
+  uint32_t heap_free;          // [bytes]
+  uint32_t heap_free_minimal;  // [bytes] lowest amount of free heap since boot
+  uint32_t heap_largest_block; // [bytes] biggest allocation that still fits
+  uint32_t heap_blocks;        // allocated blocks
+  long     heap_blocks_since_setup; // non-zero means something allocates in steady state
+};
+// DIAGNOSTICS VALUES END
+
+// called by every task instead of vTaskDelay, so its load can be computed
+void task_delay(enum diagnostics_tasks task, TickType_t ticks);
+
+// in the header, the motion task calls it every tick
+inline void record_tick_period(uint32_t period) {
+  uint32_t bucket = min<uint32_t>(period / TICK_PERIOD_BUCKET_WIDTH, TICK_PERIOD_BUCKETS - 1);
+  tick_periods[bucket].store(tick_periods[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// upper bound of the bucket holding the given share of tick periods, UINT32_MAX when it is the last one
+uint32_t tick_period_percentile(const uint32_t (&counts)[TICK_PERIOD_BUCKETS], uint8_t percent);
+void sample_tick_periods(uint32_t (&counts)[TICK_PERIOD_BUCKETS]);
+void sample_heap(diagnostics_report &report);
+
+// call once when everything is set up, later reports count allocations from here
+void begin_diagnostics();
+void sample_diagnostics(diagnostics_report &report);
+void print_diagnostics(const diagnostics_report &report);
+
+#endif // DIAGNOSTICS_H
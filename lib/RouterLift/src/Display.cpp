@@ -0,0 +1,478 @@
+#include "Display.h"
+#include "Input.h"
+#include "SensorFilter.h"
+#include "Settings.h"
+
+// PERIPHERY START
+display_driver display_I2C(U8G2_R0, U8X8_PIN_NONE, PIN_ICC_CLOCK, PIN_ICC_DATA);
+// PERIPHERY END
+
+// MISC. VARIABLES START
+int ux = 57; // helper to draw target circle
+int uy = 48; // helper to draw target circle
+
+float pos_in_mm = 0.0; // holds computed value
+// MISC. VARIABLES END
+
+// DISPLAY VALUES START
+motion_status display_motion = {};
+control_status display_control = {};
+diagnostics_report display_diagnostics = {};
+// DISPLAY VALUES END
+
+// DISPLAY START
+void show_position_in_mm() {
+  display_I2C.setFont(u8g2_font_helvB18_tf); // choose a suitable font
+
+  pos_in_mm = position_in_mm(display_motion.position - display_control.work_zero);
+
+  if (pos_in_mm >= 0) {
+    if (pos_in_mm < 10) {
+      display_I2C.setCursor(30, 25);
+    } else {
+      display_I2C.setCursor(17, 25);
+    }
+  } else {
+    if (pos_in_mm > -10) {
+      display_I2C.setCursor(22, 25);
+    } else {
+      display_I2C.setCursor(9, 25);
+    }
+  }
+  display_I2C.print(pos_in_mm);
+  display_I2C.print(" mm");
+}
+
+// leaves the cursor at the start of the line for what goes left of it
+void show_target() {
+  display_I2C.drawCircle(ux, uy - 6, 7, U8G2_DRAW_ALL);
+  display_I2C.drawCircle(ux, uy - 6, 4, U8G2_DRAW_ALL);
+  display_I2C.drawLine(ux - 8, uy - 6, ux + 8, uy - 6);
+  display_I2C.drawLine(ux, uy - 14, ux, uy + 2);
+  display_I2C.setCursor(69, 48);
+  display_I2C.setFont(u8g2_font_helvB10_tf);
+  display_I2C.print(display_control.target_height);
+  display_I2C.print("mm");
+  display_I2C.setFont(u8g2_font_helvB12_tf);
+  display_I2C.setCursor(0, 48);
+}
+
+void show_fast_slow_and_target() {
+  display_I2C.setCursor(45, 48);
+
+  if (display_control.target_active) {
+    show_target();
+  }
+
+  if (display_control.slow_speed) {
+    display_I2C.print("SLOW");
+  } else {
+    display_I2C.print("FAST");
+  }
+}
+
+// in place of speed and target while a preset is picked
+void show_preset() {
+  display_I2C.setFont(u8g2_font_helvB12_tf);
+  display_I2C.setCursor(0, 48);
+  display_I2C.print("P");
+  display_I2C.print(display_control.preset_slot + 1);
+  display_I2C.print("  ");
+  if (is_preset_stored(display_control.preset_slot)) {
+    display_I2C.print(preference_presets[display_control.preset_slot]);
+    display_I2C.print(" mm");
+  } else {
+    display_I2C.print("--");
+  }
+}
+
+// in place of speed and target while the pass step is dialed
+void show_pass_step() {
+  display_I2C.setFont(u8g2_font_helvB12_tf);
+  display_I2C.setCursor(0, 48);
+  display_I2C.print("Step ");
+  display_I2C.print(preference_pass_step);
+  display_I2C.print(" mm");
+}
+
+// in place of speed, next to the target the passes end at
+void show_pass() {
+  show_target();
+  display_I2C.print(display_control.pass);
+  display_I2C.print("/");
+  display_I2C.print(display_control.pass_count);
+}
+
+// in place of speed and target while the feed rate is dialed
+void show_feed_rate() {
+  display_I2C.setFont(u8g2_font_helvB12_tf);
+  display_I2C.setCursor(0, 48);
+  display_I2C.print("F");
+  display_I2C.print(preference_feed_rate);
+  display_I2C.print(" mm/min");
+}
+
+// in place of speed, next to the target the feed ends at; what it runs at, marked when that is not what was asked for
+void show_feed() {
+  show_target();
+  display_I2C.setFont(u8g2_font_helvB10_tf);
+  display_I2C.print("F");
+  display_I2C.print(display_control.feed_rate);
+  if (display_control.feed_limited) {
+    display_I2C.print("!");
+  }
+}
+
+void show_workspace() {
+  if (display_control.workspace_active) {
+    display_I2C.setCursor(5, 64);
+    display_I2C.setFont(u8g2_font_helvB08_tf);
+    display_I2C.print("WS");
+    if (display_motion.position == display_control.workspace_lower_limit) {
+      display_I2C.print(" MAX");
+    }
+    if (display_motion.position == display_control.workspace_upper_limit) {
+      display_I2C.print(" MIN");;
+    }
+  }
+}
+
+void show_menu_title(const char *title) {
+  display_I2C.setFont(u8g2_font_helvB10_tf);
+  display_I2C.setCursor(0, 15);
+  display_I2C.print(title);
+  display_I2C.setFont(u8g2_font_helvB12_tf);
+  display_I2C.setCursor(0, 50);
+}
+
+void show_tool() {
+  if (display_control.tool_selected) {
+    display_I2C.setCursor(100, 64);
+    display_I2C.setFont(u8g2_font_helvB08_tf);
+    display_I2C.print("T");
+    display_I2C.print(display_control.tool_slot + 1);
+  }
+}
+
+// G54 is the default and goes without a label
+void show_work_offset() {
+  if (preference_work_offset_slot != 0) {
+    display_I2C.setCursor(70, 64);
+    display_I2C.setFont(u8g2_font_helvB08_tf);
+    display_I2C.print("G");
+    display_I2C.print(54 + preference_work_offset_slot);
+  }
+}
+
+void show_select_tool() {
+  show_menu_title("Select Tool");
+  display_I2C.print("T");
+  display_I2C.print(display_control.tool_slot + 1);
+  display_I2C.print("  ");
+  if (is_tool_known(display_control.tool_slot)) {
+    // height of the end stop above the zero of the tool
+    display_I2C.print(-position_in_mm(preference_tool_offsets[display_control.tool_slot]));
+    display_I2C.print(" mm");
+  } else {
+    display_I2C.print("NEW");
+  }
+}
+
+void show_sensor_tool_length_enabled() {
+  if (display_inputs.active<sensor_tool_length_enabled_pin>()) {
+    display_I2C.drawDisc(125, 61, 2, U8G2_DRAW_ALL);
+  }
+}
+
+void show_settings_menu() {
+  switch (display_control.settings_menu_active_page) {
+    case 0:
+      show_menu_title("Maximal Speed");
+      display_I2C.print(preference_motor_speed_maximal);
+      display_I2C.print(" steps/sec");
+      break;
+    case 1:
+      show_menu_title("Acceleration");
+      display_I2C.print(preference_motor_acceleration);
+      display_I2C.print(" steps/sec^2");
+      break;
+    case 2:
+      show_menu_title("Steps per Rev.");
+      display_I2C.print(preference_motor_steps_per_revolution);
+      break;
+    case 3:
+      show_menu_title("Motor Direction");
+      if (preference_motor_direction == -1) {
+        display_I2C.print("CCW");
+      } else {
+        display_I2C.print("CW");
+      }
+      break;
+    case 4:
+      show_menu_title("TL-Sensor Height");
+      display_I2C.print(preference_sensor_tool_length_height);
+      display_I2C.print(" mm");
+      break;
+    case 5:
+      show_menu_title("Thread Pitch");
+      display_I2C.print(preference_motor_thread_pitch);
+      display_I2C.print(" mm");
+      break;
+    case 6:
+      show_menu_title("Encoder Slow");
+      display_I2C.print(preference_motor_steps_slow * mm_per_step());
+      display_I2C.print(" mm/step");
+      break;
+    case 7:
+      show_menu_title("Encoder Fast");
+      display_I2C.print(preference_motor_steps_fast * mm_per_step());
+      display_I2C.print(" mm/step");
+      break;
+    case 8:
+      show_menu_title("Toolchange Speed");
+      display_I2C.print(preference_motor_speed_toolchange);
+      display_I2C.print(" steps/sec");
+      break;
+    case 9:
+      show_menu_title("Autozero Speed");
+      display_I2C.print(preference_auto_zero_speed);
+      display_I2C.print(" steps/sec");
+      break;
+    case 10:
+      show_menu_title("Workspace Height");
+      display_I2C.print(preference_workspace_height);
+      display_I2C.print(" mm");
+      break;
+    case 11:
+      show_menu_title("PowerUp-Toolch.");
+      if (preference_power_on_toolchange) {
+        display_I2C.print("OK");
+      } else {
+        display_I2C.print("--");
+      }
+      break;
+    case 12:
+      show_menu_title("TL-Sensor Enable");
+      if (preference_sensor_tool_length_enabled_normally_closed) {
+        display_I2C.print("NC");
+      } else {
+        display_I2C.print("NO");
+      }
+      break;
+    case 13:
+      show_menu_title("TL-Sensor");
+      if (preference_sensor_tool_length_normally_closed) {
+        display_I2C.print("NC");
+      } else {
+        display_I2C.print("NO");
+      }
+      break;
+    case 14:
+      show_menu_title("Endstop-Sensor");
+      if (preference_sensor_end_stop_normally_closed) {
+        display_I2C.print("NC");
+      } else {
+        display_I2C.print("NO");
+      }
+      break;
+    case 15:
+      show_menu_title("Tool Table");
+      if (preference_tool_table_enabled) {
+        display_I2C.print("OK");
+      } else {
+        display_I2C.print("--");
+      }
+      break;
+    case 16:
+      show_menu_title("Tool Verify");
+      if (preference_tool_verify_enabled) {
+        display_I2C.print("OK");
+      } else {
+        display_I2C.print("--");
+      }
+      break;
+    case 17:
+      show_menu_title("Endstop Filter");
+      display_I2C.print(sensor_filter_settings[preference_sensor_end_stop_filter].name);
+      break;
+    case 18:
+      show_menu_title("TL-Sensor Filter");
+      display_I2C.print(sensor_filter_settings[preference_sensor_tool_length_filter].name);
+      break;
+    case 19:
+      show_menu_title("Work Offset");
+      display_I2C.print("G");
+      display_I2C.print(54 + preference_work_offset_slot);
+      break;
+    case 20: {
+      char title[32];
+      snprintf(title, sizeof(title), "G%ld Height", 54 + preference_work_offset_slot);
+      show_menu_title(title);
+      display_I2C.print(preference_work_offsets[preference_work_offset_slot]);
+      display_I2C.print(" mm");
+      break;
+    }
+    case 21:
+      show_menu_title("Pass Step");
+      display_I2C.print(preference_pass_step);
+      display_I2C.print(" mm");
+      break;
+    case 22:
+      show_menu_title("Backlash");
+      display_I2C.print(preference_backlash);
+      display_I2C.print(" steps");
+      break;
+    case 23:
+      show_menu_title("Approach Below");
+      if (preference_approach_from_below) {
+        display_I2C.print("OK");
+      } else {
+        display_I2C.print("--");
+      }
+      break;
+    case 24:
+      show_menu_title("Pitch Point");
+      display_I2C.print(lround((preference_pitch_point + 1) * PITCH_TABLE_SPACING));
+      display_I2C.print(" mm down");
+      break;
+    case 25: {
+      char title[32];
+      snprintf(title, sizeof(title), "Pitch Error %.0fmm", (preference_pitch_point + 1) * PITCH_TABLE_SPACING);
+      show_menu_title(title);
+      display_I2C.print(preference_pitch_errors[preference_pitch_point]);
+      display_I2C.print(" mm");
+      break;
+    }
+    case 26:
+      show_menu_title("Resonance Band");
+      display_I2C.print(preference_resonance_band + 1);
+      if (preference_resonance_upper[preference_resonance_band] == preference_resonance_lower[preference_resonance_band]) {
+        display_I2C.print(" off");
+      }
+      break;
+    case 27: {
+      char title[32];
+      snprintf(title, sizeof(title), "Band %ld From", preference_resonance_band + 1);
+      show_menu_title(title);
+      display_I2C.print(preference_resonance_lower[preference_resonance_band]);
+      display_I2C.print(" steps/sec");
+      break;
+    }
+    case 28: {
+      char title[32];
+      snprintf(title, sizeof(title), "Band %ld To", preference_resonance_band + 1);
+      show_menu_title(title);
+      display_I2C.print(preference_resonance_upper[preference_resonance_band]);
+      display_I2C.print(" steps/sec");
+      break;
+    }
+    case 29:
+      show_menu_title("Feed Rate");
+      display_I2C.print(preference_feed_rate);
+      display_I2C.print(" mm/min");
+      break;
+    default:
+      Serial.printf("invalid menu page number: %ld\n", display_control.settings_menu_active_page);
+  }
+}
+
+void show_diagnostics() {
+  display_I2C.setFont(u8g2_font_helvB08_tf);
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    display_I2C.setCursor(0, 10 * (task + 1));
+    display_I2C.printf("%.7s %3u%% %5uB", display_diagnostics.tasks[task].name,
+                       display_diagnostics.tasks[task].cpu_share, display_diagnostics.tasks[task].stack_free);
+  }
+  display_I2C.setCursor(0, 40);
+  display_I2C.printf("Heap %u min %u", display_diagnostics.heap_free, display_diagnostics.heap_free_minimal);
+  display_I2C.setCursor(0, 50);
+  display_I2C.printf("Block %u", display_diagnostics.heap_largest_block);
+  display_I2C.setCursor(0, 60);
+  display_I2C.printf("Allocs %u (%+ld)", display_diagnostics.heap_blocks, display_diagnostics.heap_blocks_since_setup);
+}
+
+void show_error() {
+  display_I2C.setFont(u8g2_font_helvB14_tf);
+  display_I2C.setCursor(30, 30);
+  display_I2C.print("ERROR:");
+  display_I2C.setFont(u8g2_font_helvB10_tf);
+  display_I2C.setCursor(0, 50);
+  display_I2C.print(display_control.error_message);
+}
+
+void show_reset() {
+  display_I2C.setFont(u8g2_font_helvB14_tf);
+  display_I2C.setCursor(30, 30);
+  display_I2C.print("RESET");
+  display_I2C.setCursor(30, 50);
+  display_I2C.print("VALUES");
+}
+
+void draw() {
+  motion_status_for_display.read(display_motion);
+  control_status_for_display.read(display_control);
+  diagnostics_for_display.read(display_diagnostics);
+  display_I2C.clearBuffer();
+  switch (display_control.state) {
+    case settings_menu:
+      if (display_control.diagnostics_visible) {
+        show_diagnostics();
+      } else {
+        show_settings_menu();
+      }
+      break;
+    case reset:
+      show_reset();
+      break;
+    case error:
+      show_error();
+      break;
+    case select_tool:
+      show_select_tool();
+      show_sensor_tool_length_enabled();
+      break;
+    default:
+      show_position_in_mm();
+      if (display_control.state == depth_passes) {
+        show_pass();
+      } else if (display_control.state == feed_plunge) {
+        show_feed();
+      } else if (display_control.overlay == overlay_preset) {
+        show_preset();
+      } else if (display_control.overlay == overlay_pass_step) {
+        show_pass_step();
+      } else if (display_control.overlay == overlay_feed_rate) {
+        show_feed_rate();
+      } else {
+        show_fast_slow_and_target();
+      }
+      show_workspace();
+      show_work_offset();
+      show_tool();
+      show_sensor_tool_length_enabled();
+  }
+  display_I2C.sendBuffer();
+}
+
+void draw_loop(void * parameter) {
+  display_I2C.begin();
+
+  while (true) {
+    collect_inputs();
+    draw();
+    // lets the idle task of core 0 feed the watchdog between frames
+    task_delay(diagnostics_display_task, 1);
+  }
+}
+
+void begin_display() {
+  xTaskCreatePinnedToCore(
+    draw_loop, /* Function to implement the task */
+    "DisplayTask", /* Name of the task */
+    DISPLAY_TASK_STACK_SIZE,  /* Stack size in bytes */
+    NULL,  /* Task input parameter */
+    DISPLAY_TASK_PRIORITY,  /* Priority of the task */
+    &task_loads[diagnostics_display_task].handle,  /* Task handle. */
+    DISPLAY_TASK_CORE); /* Core where the task should run */
+}
+// DISPLAY END
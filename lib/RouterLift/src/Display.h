@@ -0,0 +1,31 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Arduino.h>
+#include "Backends.h"
+#include "Control.h"
+#include "Diagnostics.h"
+#include "Motion.h"
+
+#define DISPLAY_TASK_STACK_SIZE 10000 // [bytes]
+#define DISPLAY_TASK_PRIORITY   2
+#define DISPLAY_TASK_CORE       0
+
+extern display_driver display_I2C;
+
+// DISPLAY VALUES START
+// only touched by the display task
+extern motion_status display_motion;             // snapshot of the motion task
+extern control_status display_control;           // snapshot of the control task
+extern diagnostics_report display_diagnostics;   // snapshot of the control task
+// DISPLAY VALUES END
+
+// DISPLAY START
+// one frame of whatever the control task shows
+void draw();
+
+// starts the display task, it collects the inputs between frames
+void begin_display();
+// DISPLAY END
+
+#endif // DISPLAY_H
@@ -0,0 +1,20 @@
+#include "Gpio.h"
+
+// INPUT SAMPLE START
+std::atomic<uint32_t> input_inversion[2] = {};
+std::atomic<uint32_t> input_filtered_mask[2] = {};
+std::atomic<uint32_t> input_filtered[2] = {};
+
+void set_input_inversion(const input_sample &inversion) {
+  input_inversion[0].store(inversion.banks[0], std::memory_order_relaxed);
+  input_inversion[1].store(inversion.banks[1], std::memory_order_relaxed);
+}
+// INPUT SAMPLE END
+
+// GPIO BENCHMARK START
+void print_gpio_benchmark(const gpio_benchmark &result) {
+  Serial.printf("board %s, %u calls each, loop alone %u ns\n", board::name, GPIO_BENCHMARK_CALLS, result.empty);
+  Serial.printf("digitalRead  %5u ns, register read  %5u ns\n", result.digital_read, result.register_read);
+  Serial.printf("digitalWrite %5u ns, register write %5u ns\n", result.digital_write, result.register_write);
+}
+// GPIO BENCHMARK END
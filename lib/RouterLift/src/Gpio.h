@@ -0,0 +1,208 @@
+#ifndef GPIO_H
+#define GPIO_H
+
+// Pins known at compile time read and write the GPIO registers directly,
+// one register access instead of the pin lookup of digitalRead()/digitalWrite().
+// pinMode() in setup() stays with the Arduino core.
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+#include <atomic>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+#include "PinDefinitions.h"
+
+#define GPIO_INLINE inline __attribute__((always_inline))
+
+#define GPIO_BENCHMARK_CALLS 100000
+
+// GPIO REGISTERS START
+// GPIO 0 to 31 are in the first register bank, 32 to 39 in the second
+template <uint8_t PIN>
+struct gpio_pin {
+  static_assert(PIN < 40, "the ESP32 has GPIO 0 to 39");
+
+  static constexpr uint8_t  number = PIN;
+  static constexpr uint32_t mask   = 1UL << (PIN % 32);
+  static constexpr uint32_t input_register  = PIN < 32 ? GPIO_IN_REG : GPIO_IN1_REG;
+  static constexpr uint32_t output_register = PIN < 32 ? GPIO_OUT_REG : GPIO_OUT1_REG;
+  static constexpr uint32_t set_register    = PIN < 32 ? GPIO_OUT_W1TS_REG : GPIO_OUT1_W1TS_REG;
+  static constexpr uint32_t clear_register  = PIN < 32 ? GPIO_OUT_W1TC_REG : GPIO_OUT1_W1TC_REG;
+
+  static GPIO_INLINE bool read() {
+    return REG_READ(input_register) & mask;
+  }
+
+  // level last written, not what the pin reads
+  static GPIO_INLINE bool written() {
+    return REG_READ(output_register) & mask;
+  }
+
+  static GPIO_INLINE void write(bool level) {
+    static_assert(PIN < 34, "GPIO 34 to 39 are inputs only");
+    REG_WRITE(level ? set_register : clear_register, mask);
+  }
+};
+// GPIO REGISTERS END
+
+// BOARD PINS START
+typedef gpio_pin<PIN_STEP>      step_pin;
+typedef gpio_pin<PIN_DIRECTION> direction_pin;
+
+typedef gpio_pin<PIN_BUTTON_UP>          button_up_pin;
+typedef gpio_pin<PIN_BUTTON_DOWN>        button_down_pin;
+typedef gpio_pin<PIN_BUTTON_TOOLCHANGE>  button_toolchange_pin;
+typedef gpio_pin<PIN_BUTTON_SET_ZERO>    button_set_zero_pin;
+typedef gpio_pin<PIN_BUTTON_SET_SPEED>   button_set_speed_pin;
+typedef gpio_pin<PIN_BUTTON_GOTO_BOTTOM> button_goto_bottom_pin;
+
+typedef gpio_pin<PIN_SENSOR_END_STOP_TRIGGER>    sensor_end_stop_trigger_pin;
+typedef gpio_pin<PIN_SENSOR_TOOL_LENGTH_TRIGGER> sensor_tool_length_trigger_pin;
+typedef gpio_pin<PIN_SENSOR_TOOL_LENGTH_ENABLED> sensor_tool_length_enabled_pin;
+// BOARD PINS END
+
+// INPUT SAMPLE START
+// every input pin at one moment, a set bit is an active input: button down or sensor triggered
+struct input_sample {
+  uint32_t banks[2]; // GPIO 0 to 31 and GPIO 32 to 39
+
+  template <typename pin>
+  GPIO_INLINE bool active() const {
+    return banks[pin::number / 32] & pin::mask;
+  }
+
+  GPIO_INLINE bool active(uint8_t pin) const {
+    return banks[pin / 32] & (1UL << (pin % 32));
+  }
+
+  template <typename pin>
+  void set(bool active) {
+    banks[pin::number / 32] = active ? banks[pin::number / 32] | pin::mask : banks[pin::number / 32] & ~pin::mask;
+  }
+};
+
+constexpr uint8_t input_pins[] = {
+  PIN_BUTTON_UP, PIN_BUTTON_DOWN, PIN_BUTTON_TOOLCHANGE, PIN_BUTTON_SET_ZERO, PIN_BUTTON_SET_SPEED, PIN_BUTTON_GOTO_BOTTOM,
+  PIN_SENSOR_END_STOP_TRIGGER, PIN_SENSOR_TOOL_LENGTH_TRIGGER, PIN_SENSOR_TOOL_LENGTH_ENABLED
+};
+
+constexpr uint32_t input_bank_mask(uint8_t bank) {
+  uint32_t mask = 0;
+  for (uint8_t pin : input_pins) {
+    if (pin / 32 == bank) {
+      mask |= 1UL << (pin % 32);
+    }
+  }
+  return mask;
+}
+
+// pins whose level is flipped, so that active reads as set; written by the control task
+extern std::atomic<uint32_t> input_inversion[2];
+
+// sensor pins the sampler of SensorFilter.h debounces and their debounced levels, active is set;
+// written by the sampler interrupt
+extern std::atomic<uint32_t> input_filtered_mask[2];
+extern std::atomic<uint32_t> input_filtered[2];
+
+void set_input_inversion(const input_sample &inversion);
+
+// one register read per bank that has inputs, the second one only on boards with inputs above GPIO 31
+GPIO_INLINE input_sample sample_raw_inputs() {
+  input_sample sample = {};
+  if constexpr (input_bank_mask(0) != 0) {
+    sample.banks[0] = (REG_READ(GPIO_IN_REG) ^ input_inversion[0].load(std::memory_order_relaxed)) & input_bank_mask(0);
+  }
+  if constexpr (input_bank_mask(1) != 0) {
+    sample.banks[1] = (REG_READ(GPIO_IN1_REG) ^ input_inversion[1].load(std::memory_order_relaxed)) & input_bank_mask(1);
+  }
+  return sample;
+}
+
+// what the tasks work with: the pins as they are, debounced sensors as the sampler last filtered them
+GPIO_INLINE input_sample sample_inputs() {
+  input_sample sample = sample_raw_inputs();
+  for (uint8_t bank = 0; bank < 2; bank++) {
+    uint32_t filtered = input_filtered_mask[bank].load(std::memory_order_relaxed);
+    sample.banks[bank] = (sample.banks[bank] & ~filtered) | (input_filtered[bank].load(std::memory_order_relaxed) & filtered);
+  }
+  return sample;
+}
+// INPUT SAMPLE END
+
+// STEPPER OUTPUT START
+// AccelStepper in DRIVER mode with STEP and DIR set by one write to the set and one to the clear register
+template <typename step_output, typename direction_output>
+class gpio_stepper : public AccelStepper {
+  static_assert(step_output::set_register == direction_output::set_register,
+                "STEP and DIR have to be in the same register bank");
+
+  public:
+    gpio_stepper() : AccelStepper(AccelStepper::DRIVER, step_output::number, direction_output::number) {}
+
+  protected:
+    // bit 0 is STEP, bit 1 is DIR
+    void setOutputPins(uint8_t mask) override {
+      uint32_t high = (mask & 0b01 ? step_output::mask : 0) | (mask & 0b10 ? direction_output::mask : 0);
+      uint32_t low  = (step_output::mask | direction_output::mask) & ~high;
+      REG_WRITE(step_output::set_register, high);
+      REG_WRITE(step_output::clear_register, low);
+    }
+};
+
+typedef gpio_stepper<step_pin, direction_pin> board_stepper;
+// STEPPER OUTPUT END
+
+// GPIO BENCHMARK START
+// average time per call with the loop around it, empty is the loop alone;
+// writes output its own level back, so only while nothing else writes that pin
+struct gpio_benchmark {
+  uint32_t empty;          // [ns]
+  uint32_t digital_read;   // [ns]
+  uint32_t register_read;  // [ns]
+  uint32_t digital_write;  // [ns]
+  uint32_t register_write; // [ns]
+};
+
+template <typename input, typename output>
+gpio_benchmark benchmark_gpio() {
+  gpio_benchmark result;
+  volatile uint32_t sink = 0;
+  bool level = output::written();
+  uint32_t started;
+
+  started = micros();
+  for (uint32_t call = 0; call < GPIO_BENCHMARK_CALLS; call++) {
+    sink = sink + call;
+  }
+  result.empty = (uint64_t)(micros() - started) * 1000 / GPIO_BENCHMARK_CALLS;
+
+  started = micros();
+  for (uint32_t call = 0; call < GPIO_BENCHMARK_CALLS; call++) {
+    sink = sink + digitalRead(input::number);
+  }
+  result.digital_read = (uint64_t)(micros() - started) * 1000 / GPIO_BENCHMARK_CALLS;
+
+  started = micros();
+  for (uint32_t call = 0; call < GPIO_BENCHMARK_CALLS; call++) {
+    sink = sink + input::read();
+  }
+  result.register_read = (uint64_t)(micros() - started) * 1000 / GPIO_BENCHMARK_CALLS;
+
+  started = micros();
+  for (uint32_t call = 0; call < GPIO_BENCHMARK_CALLS; call++) {
+    digitalWrite(output::number, level);
+  }
+  result.digital_write = (uint64_t)(micros() - started) * 1000 / GPIO_BENCHMARK_CALLS;
+
+  started = micros();
+  for (uint32_t call = 0; call < GPIO_BENCHMARK_CALLS; call++) {
+    output::write(level);
+  }
+  result.register_write = (uint64_t)(micros() - started) * 1000 / GPIO_BENCHMARK_CALLS;
+  return result;
+}
+
+void print_gpio_benchmark(const gpio_benchmark &result);
+// GPIO BENCHMARK END
+
+#endif // GPIO_H
@@ -0,0 +1,206 @@
+#include "Input.h"
+#include "Backends.h"
+#include "SensorFilter.h"
+#include "Settings.h"
+
+// PERIPHERY START
+ESP32Encoder encoder;
+// PERIPHERY END
+
+// INPUT VALUES START
+const char *input_names[] = {
+  "input_none",
+  "input_toolchange_press",
+  "input_set_zero_press",
+  "input_set_zero_hold",
+  "input_set_speed_press",
+  "input_set_speed_hold",
+  "input_goto_bottom_press",
+  "input_goto_bottom_hold",
+  "input_preset_select",
+  "input_preset_recall",
+  "input_pass_step",
+  "input_pass_step_set",
+  "input_pass_start",
+  "input_feed_rate",
+  "input_feed_rate_set",
+  "input_feed_start",
+  "input_encoder"
+};
+
+channel<input_event, INPUT_EVENTS_LENGTH> input_events;
+
+// only touched by the display task
+button_input button_toolchange  = { PIN_BUTTON_TOOLCHANGE,  input_toolchange_press,  input_none,             input_none,          input_none,          input_none,       true, false, false, false, 0 };
+button_input button_set_zero    = { PIN_BUTTON_SET_ZERO,    input_set_zero_press,    input_set_zero_hold,    input_feed_rate,     input_feed_rate_set, input_feed_start, true, false, false, false, 0 };
+button_input button_set_speed   = { PIN_BUTTON_SET_SPEED,   input_set_speed_press,   input_set_speed_hold,   input_pass_step,     input_pass_step_set, input_pass_start, true, false, false, false, 0 };
+button_input button_goto_bottom = { PIN_BUTTON_GOTO_BOTTOM, input_goto_bottom_press, input_goto_bottom_hold, input_preset_select, input_preset_recall, input_none,       true, false, false, false, 0 };
+
+int64_t input_encoder_count_sent = 0; // encoder count already sent to the control task
+
+// only touched by the control task
+enum input_types input_pending = input_none;
+long input_encoder_steps = 0;
+long input_pending_steps = 0;
+// INPUT VALUES END
+
+// SENSOR VALUES START
+input_sample status_inputs  = {};
+input_sample display_inputs = {};
+
+void update_input_inversion() {
+  input_sample inversion = {};
+  inversion.set<button_up_pin>(true);
+  inversion.set<button_down_pin>(true);
+  inversion.set<button_toolchange_pin>(true);
+  inversion.set<button_set_zero_pin>(true);
+  inversion.set<button_set_speed_pin>(true);
+  inversion.set<button_goto_bottom_pin>(true);
+  inversion.set<sensor_end_stop_trigger_pin>(!preference_sensor_end_stop_normally_closed);
+  inversion.set<sensor_tool_length_trigger_pin>(!preference_sensor_tool_length_normally_closed);
+  inversion.set<sensor_tool_length_enabled_pin>(!preference_sensor_tool_length_enabled_normally_closed);
+  set_input_inversion(inversion);
+}
+
+void update_sensor_filters() {
+  set_sensor_filters(preference_sensor_end_stop_filter, preference_sensor_tool_length_filter);
+}
+
+bool is_sensor_tool_length_enabled() {
+  return status_inputs.active<sensor_tool_length_enabled_pin>();
+}
+// SENSOR VALUES END
+
+// INPUT START
+void begin_input() {
+  pinMode(PIN_BUTTON_UP,          INPUT_PULLUP);
+  pinMode(PIN_BUTTON_DOWN,        INPUT_PULLUP);
+  pinMode(PIN_BUTTON_TOOLCHANGE,  INPUT_PULLUP);
+  pinMode(PIN_BUTTON_SET_ZERO,    INPUT_PULLUP);
+  pinMode(PIN_BUTTON_SET_SPEED,   INPUT_PULLUP);
+  pinMode(PIN_BUTTON_GOTO_BOTTOM, INPUT_PULLUP);
+
+  pinMode(PIN_SENSOR_END_STOP_TRIGGER,    INPUT_PULLUP);
+  pinMode(PIN_SENSOR_TOOL_LENGTH_TRIGGER, INPUT_PULLUP);
+  pinMode(PIN_SENSOR_TOOL_LENGTH_ENABLED, INPUT_PULLUP);
+
+  ESP32Encoder::useInternalWeakPullResistors = UP;
+  attach_encoder(encoder);
+  encoder.clearCount();
+}
+
+void send_input(enum input_types type) {
+  input_event event = { type, 0 };
+  // dropped when the control task is INPUT_EVENTS_LENGTH inputs behind
+  input_events.push(event);
+}
+
+// the button toolchange starts with, nullptr when it changes the tool
+button_input *start_chord_button() {
+  button_input *buttons[] = { &button_set_zero, &button_set_speed };
+  for (button_input *button : buttons) {
+    if (button->start != input_none && button->counting && display_inputs.active(button->pin)) {
+      return button;
+    }
+  }
+  return nullptr;
+}
+
+// press is sent on release before DURATION_BUTTON_HOLD, hold once the button is down that long;
+// after a chord turn or start only the release counts
+void collect_button_input(button_input &button) {
+  bool down = display_inputs.active(button.pin);
+  if (!button.released) {
+    // wait for release to avoid double press
+    button.released = !down;
+  } else if (button.chorded || button.started) {
+    if (!down) {
+      if (button.chorded) {
+        send_input(button.turned);
+      }
+      button.chorded  = false;
+      button.started  = false;
+      button.counting = false;
+    }
+  } else if (button.hold == input_none) {
+    if (down) {
+      button_input *chord = &button == &button_toolchange ? start_chord_button() : nullptr;
+      if (chord) {
+        send_input(chord->start);
+        chord->started = true;
+      } else {
+        send_input(button.press);
+      }
+      button.released = false;
+    }
+  } else if (down && !button.counting) {
+    button.counting   = true;
+    button.pressed_at = millis();
+  } else if (down && millis() - button.pressed_at > DURATION_BUTTON_HOLD) {
+    send_input(button.hold);
+    button.counting = false;
+    button.released = false;
+  } else if (!down && button.counting) {
+    send_input(button.press);
+    button.counting = false;
+  }
+}
+
+// the button the encoder turns with, nullptr when it moves the lift
+button_input *chord_button() {
+  button_input *buttons[] = { &button_goto_bottom, &button_set_zero, &button_set_speed };
+  for (button_input *button : buttons) {
+    if (button->turn != input_none && button->counting && display_inputs.active(button->pin)) {
+      return button;
+    }
+  }
+  return nullptr;
+}
+
+void collect_inputs() {
+  display_inputs = sample_inputs();
+
+  // encoder steps since last check, they stay on the counter until the control task can take them;
+  // with a chord button down they are its turn instead of a move
+  int64_t encoder_count = encoder.getCount();
+  if (encoder_count != input_encoder_count_sent) {
+    button_input *chord = chord_button();
+    input_event event = { chord ? chord->turn : input_encoder, (long)(encoder_count - input_encoder_count_sent) };
+    if (input_events.push(event)) {
+      input_encoder_count_sent = encoder_count;
+      if (chord) {
+        chord->chorded = true;
+      }
+    }
+  }
+
+  collect_button_input(button_toolchange);
+  collect_button_input(button_goto_bottom);
+  collect_button_input(button_set_zero);
+  collect_button_input(button_set_speed);
+}
+
+void receive_inputs() {
+  input_event event;
+  input_pending = input_none;
+  input_encoder_steps = 0;
+  while (input_events.pop(event)) {
+    if (event.type == input_encoder) {
+      input_encoder_steps += event.encoder_steps;
+    } else {
+      input_pending       = event.type;
+      input_pending_steps = event.encoder_steps;
+      break;
+    }
+  }
+}
+
+bool consume_input(enum input_types type) {
+  if (input_pending == type) {
+    Serial.println(input_names[type]);
+    input_pending = input_none;
+    return true;
+  }
+  return false;
+}
+// INPUT END
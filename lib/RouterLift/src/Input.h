@@ -0,0 +1,93 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <Arduino.h>
+#include <ESP32Encoder.h>
+#include "Channel.h"
+#include "Gpio.h"
+
+#define DURATION_BUTTON_HOLD   750 // [ms]
+
+#define INPUT_EVENTS_LENGTH     16 // power of two
+
+// Buttons and encoder are collected by the display task between frames and
+// sent to the control task, which also samples the jog buttons and sensors.
+
+extern ESP32Encoder encoder;
+
+// INPUT VALUES START
+enum input_types {
+  input_none,
+  input_toolchange_press,
+  input_set_zero_press,
+  input_set_zero_hold,
+  input_set_speed_press,
+  input_set_speed_hold,
+  input_goto_bottom_press,
+  input_goto_bottom_hold,
+  input_preset_select, // encoder turned while goto bottom is down
+  input_preset_recall, // goto bottom released after turning
+  input_pass_step,     // encoder turned while set speed is down
+  input_pass_step_set, // set speed released after turning
+  input_pass_start,    // toolchange pressed while set speed is down
+  input_feed_rate,     // encoder turned while set zero is down
+  input_feed_rate_set, // set zero released after turning
+  input_feed_start,    // toolchange pressed while set zero is down
+  input_encoder
+};
+
+extern const char *input_names[];
+
+struct input_event {
+  enum input_types type;
+  long encoder_steps; // also of a chord turn
+};
+
+struct button_input {
+  uint8_t pin;
+  enum input_types press;
+  enum input_types hold;    // input_none sends press as soon as the button goes down
+  enum input_types turn;    // input_none leaves the encoder alone while the button is down
+  enum input_types turned;  // sent on release instead of press and hold once turn was sent
+  enum input_types start;   // sent instead of the toolchange press while the button is down, input_none ignores it
+  bool released;
+  bool counting;
+  bool chorded;             // the encoder turned since the button went down
+  bool started;             // toolchange was pressed since the button went down
+  unsigned long pressed_at; // [ms]
+};
+
+extern channel<input_event, INPUT_EVENTS_LENGTH> input_events; // display task -> control task
+
+// only touched by the control task
+extern enum input_types input_pending; // button input of this control tick
+extern long input_encoder_steps; // is non-zero when encoder steps occurred since last input processing
+extern long input_pending_steps; // encoder steps of a pending chord turn
+// INPUT VALUES END
+
+// SENSOR VALUES START
+// inputs of the current tick, sampled once at its start
+extern input_sample status_inputs;  // only touched by the control task
+extern input_sample display_inputs; // only touched by the display task
+
+// buttons pull their pin low, a sensor pulls it low when triggered unless it is normally closed
+void update_input_inversion();
+// the filters of SensorFilter.h as the settings pick them
+void update_sensor_filters();
+
+bool is_sensor_tool_length_enabled();
+// SENSOR VALUES END
+
+// INPUT START
+// pins and encoder, call before the tasks start
+void begin_input();
+
+// display task side
+void collect_inputs();
+
+// control task side, takes the inputs sent since the last control tick, at most one button input per tick
+void receive_inputs();
+bool consume_input(enum input_types type);
+// INPUT END
+
+#endif // INPUT_H
@@ -0,0 +1,582 @@
+#include "Motion.h"
+
+// PERIPHERY START
+stepper_engine stepper;
+// PERIPHERY END
+
+// MOTION INTERFACE START
+channel<motion_command, MOTION_COMMANDS_LENGTH> motion_commands;
+mailbox<motion_status> motion_status_for_control;
+mailbox<motion_status> motion_status_for_display;
+mailbox<motion_pitch_table> motion_pitch_tables;
+
+uint32_t motion_commands_sent = 0;
+// MOTION INTERFACE END
+
+// MOTION TASK VALUES START
+// only touched by the motion task
+enum motion_modes motion_mode = motion_idle;
+
+bool  motion_workspace_active = false;
+long  motion_workspace_lower_limit = 0; // [steps]
+long  motion_workspace_upper_limit = 0; // [steps]
+
+bool  motion_target_active = false;
+long  motion_target_lower_limit = 0; // [steps]
+
+long  motion_backlash = 0; // [steps]
+long  motion_approach = 0; // [steps]
+
+// the carriage stands while the motor takes up the backlash after a reversal; the engine is set back
+// by the backlash, so once it stepped through it, its position is the carriage again
+int   motion_lash_direction = 0;  // of the last step, 0 before the first, which takes up nothing
+bool  motion_taking_up = false;
+long  motion_take_up_end = 0;     // [steps] where the carriage stands until then
+long  motion_tick_position = 0;   // [steps] of the engine after the last tick
+
+long  motion_approach_target = 0; // [steps] on the screw of a move that overshoots
+long  motion_carriage_target = 0; // [steps] the last move was sent to, the screw may not have a step right there
+
+motion_pitch_table motion_pitch = {};
+
+input_sample motion_inputs = {}; // sampled once per motion tick
+
+uint8_t motion_free_sensor_pin = PIN_SENSOR_END_STOP_TRIGGER;
+long  motion_free_start_position = 0; // [steps] for error detection
+long  motion_free_maximal_distance = 0; // [steps] for error detection
+long  motion_free_tolerance = 0; // [steps] extra distance to avoid triggering sensor again
+
+float motion_probe_speed = 0.0; // [steps per second] once the approach arrived
+
+unsigned long motion_last_tick = 0;    // [us]
+unsigned long motion_last_publish = 0; // [us]
+
+motion_status motion_published = {};
+// MOTION TASK VALUES END
+
+// where the carriage stands with the engine at position, the engine lags behind it while taking up the backlash
+long carriage_at(long position) {
+  if (motion_taking_up && (motion_take_up_end - position) * motion_lash_direction > 0) {
+    return motion_take_up_end;
+  }
+  return position;
+}
+
+long carriage_position() {
+  return carriage_at(stepper.position());
+}
+
+// halves round away from zero
+long divide_rounded(long dividend, long divisor) {
+  if (divisor < 0) {
+    dividend = -dividend;
+    divisor  = -divisor;
+  }
+  return dividend >= 0 ? (dividend + divisor / 2) / divisor : -((-dividend + divisor / 2) / divisor);
+}
+
+long interpolate_pitch(long position, const long *from, const long *to, long count) {
+  if (count == 0) {
+    return position;
+  }
+  long last  = count - 1;
+  long along = from[last] >= from[0] ? 1 : -1;
+  if ((position - from[0]) * along <= 0) {
+    return to[0] + position - from[0];
+  }
+  for (long point = 1; point <= last; point++) {
+    if ((position - from[point]) * along <= 0) {
+      return to[point - 1] + divide_rounded((position - from[point - 1]) * (to[point] - to[point - 1]),
+                                            from[point] - from[point - 1]);
+    }
+  }
+  return to[last] + position - from[last];
+}
+
+long true_position(long screw_position) {
+  return interpolate_pitch(screw_position, motion_pitch.screw, motion_pitch.carriage, motion_pitch.count);
+}
+
+long screw_position(long true_position) {
+  return interpolate_pitch(true_position, motion_pitch.carriage, motion_pitch.screw, motion_pitch.count);
+}
+
+void halt_motor() {
+  stepper.halt();
+}
+
+// direction of the next step in steps, AccelStepper keeps going the old way while it slows down for a target behind it
+int next_step_direction() {
+  return (stepper.speed() > 0) - (stepper.speed() < 0);
+}
+
+bool moves_motor_within_workspace() {
+  // moving down with space below
+  return (next_step_direction() < 0 && stepper.position() > motion_workspace_lower_limit)
+         // or moving up with space above
+         || (next_step_direction() > 0 && stepper.position() < motion_workspace_upper_limit);
+}
+
+bool moves_motor_within_target() {
+  // moving down with space to target
+  return (next_step_direction() < 0 && stepper.position() > motion_target_lower_limit)
+         // or moving up with no limit
+         || (next_step_direction() > 0);
+}
+
+bool is_motor_move_possible() {
+  // end stop not activated
+  return !motion_inputs.active<sensor_end_stop_trigger_pin>()
+         && (
+           // workspace is off
+           !motion_workspace_active
+           // or inside workspace
+           || moves_motor_within_workspace()
+         )
+         && (
+           // target is off
+           !motion_target_active
+           // or inside target
+           || moves_motor_within_target()
+         );
+}
+
+bool move_motor_constant() {
+  if (is_motor_move_possible()) {
+    stepper.run_speed_tick();
+    return true;
+  } else {
+    halt_motor();
+    return false;
+  }
+}
+
+bool move_motor_accelerate() {
+  if (is_motor_move_possible()) {
+    stepper.run_tick();
+    return true;
+  } else {
+    halt_motor();
+    return false;
+  }
+}
+
+void stop_motion(bool blocked) {
+  halt_motor();
+  motion_mode = motion_idle;
+  motion_published.blocked = blocked;
+}
+
+// the limits of is_motor_move_possible()
+void get_move_limits(long &lower, long &upper) {
+  lower = LONG_MIN;
+  upper = LONG_MAX;
+  if (motion_workspace_active) {
+    lower = motion_workspace_lower_limit;
+    upper = motion_workspace_upper_limit;
+  }
+  if (motion_target_active) {
+    lower = max(lower, motion_target_lower_limit);
+  }
+}
+
+// target is where the carriage really ends up; against the approach direction it goes past the target
+// first, as far as the limits let it
+void move_carriage_to(long carriage_target) {
+  motion_carriage_target = carriage_target;
+  long target = screw_position(carriage_target);
+  if (motion_approach != 0 && (target - carriage_position()) * motion_approach < 0) {
+    long lower, upper;
+    get_move_limits(lower, upper);
+    long overshoot = constrain(target - motion_approach, lower, upper);
+    if ((overshoot - target) * motion_approach < 0) {
+      motion_approach_target = target;
+      stepper.move_to(overshoot);
+      motion_mode = motion_overshooting;
+      return;
+    }
+  }
+  stepper.move_to(target);
+  motion_mode = motion_accelerate;
+}
+
+bool is_motion_freeing() {
+  return motion_mode == motion_freeing || motion_mode == motion_freeing_tolerance;
+}
+
+// what the engine may step to on its own between two ticks, the same limits is_motor_move_possible() checks
+void update_step_window() {
+  long lower = LONG_MIN;
+  long upper = LONG_MAX;
+  if (!is_motion_freeing()) {
+    get_move_limits(lower, upper);
+  }
+  if (motion_taking_up) {
+    // set back by the backlash the engine may start outside, the carriage is still inside
+    lower = min(lower, stepper.position());
+    upper = max(upper, stepper.position());
+  }
+  stepper.set_step_window(lower, upper);
+}
+
+void free_sensor(uint8_t sensor_pin, const motion_command &command) {
+  motion_free_sensor_pin       = sensor_pin;
+  motion_free_start_position   = stepper.position();
+  motion_free_maximal_distance = command.position;
+  motion_free_tolerance        = command.upper_limit;
+  // freeing steps past the limits, the engine has to know before it may step
+  motion_mode = motion_freeing;
+  update_step_window();
+  stepper.set_speed(command.speed);
+}
+
+void apply_motion_command(const motion_command &command) {
+  if (motion_published.faulted && command.type != motion_command_halt) {
+    return;
+  }
+  motion_published.blocked = false;
+  switch (command.type) {
+    case motion_command_halt:
+      motion_published.faulted = false;
+      stop_motion(false);
+      break;
+    case motion_command_move:
+      move_carriage_to(true_position(carriage_position()) + command.position);
+      break;
+    case motion_command_move_to:
+      move_carriage_to(command.position);
+      break;
+    case motion_command_run_speed:
+      stepper.set_speed(command.speed);
+      motion_mode = motion_constant;
+      break;
+    case motion_command_probe:
+      motion_published.probe_triggered = false;
+      stepper.set_speed(command.speed);
+      motion_mode = motion_probing;
+      break;
+    case motion_command_approach_probe:
+      motion_published.probe_triggered = false;
+      motion_probe_speed = command.speed;
+      stepper.move_to(screw_position(command.position));
+      motion_mode = motion_approaching;
+      break;
+    case motion_command_free_end_stop:
+      free_sensor(PIN_SENSOR_END_STOP_TRIGGER, command);
+      break;
+    case motion_command_free_tool_length:
+      free_sensor(PIN_SENSOR_TOOL_LENGTH_TRIGGER, command);
+      break;
+    case motion_command_set_position: {
+      // keep the limits where they are on the lead screw
+      long position = screw_position(command.position);
+      long shift    = position - stepper.position();
+      motion_workspace_lower_limit += shift;
+      motion_workspace_upper_limit += shift;
+      motion_target_lower_limit    += shift;
+      motion_take_up_end           += shift;
+      motion_tick_position         += shift;
+      stepper.set_position(position);
+      motion_mode = motion_idle;
+      break;
+    }
+    case motion_command_set_profile:
+      stepper.set_profile(command.speed, command.acceleration);
+      break;
+    case motion_command_set_workspace:
+      motion_workspace_active      = command.active;
+      motion_workspace_lower_limit = screw_position(command.position);
+      motion_workspace_upper_limit = screw_position(command.upper_limit);
+      break;
+    case motion_command_set_target:
+      motion_target_active      = command.active;
+      motion_target_lower_limit = screw_position(command.position);
+      break;
+    case motion_command_set_backlash:
+      motion_backlash = command.position;
+      motion_approach = command.upper_limit;
+      break;
+    case motion_command_set_pitch_table:
+      // the limits stay on the screw where the old table put them until they are set again
+      motion_pitch_tables.read(motion_pitch);
+      break;
+  }
+}
+
+// returns true when a command was applied
+bool receive_motion_commands() {
+  bool received = false;
+  motion_command command;
+  while (motion_commands.peek(command)) {
+    // freeing a sensor finishes before anything else but a halt is applied
+    if (is_motion_freeing() && command.type != motion_command_halt) {
+      break;
+    }
+    motion_commands.pop(command);
+    apply_motion_command(command);
+    // an engine stepping on its own may step right after the command, with the limits it set
+    update_step_window();
+    motion_published.command_sequence++;
+    received = true;
+  }
+  return received;
+}
+
+bool is_motion_accelerated() {
+  return motion_mode == motion_accelerate || motion_mode == motion_approaching
+         || motion_mode == motion_freeing_tolerance || motion_mode == motion_overshooting;
+}
+
+// at the first step after a reversal the engine reverses from standing still, so starting it over
+// from the shifted position keeps the profile; a reversal in the middle of a take up only goes
+// back over what was taken up so far
+void take_up_backlash() {
+  long position = stepper.position();
+  if (motion_taking_up && (position - motion_take_up_end) * motion_lash_direction >= 0) {
+    motion_taking_up = false;
+  }
+  // an engine stepping on its own may have finished a short move since the last tick
+  long moved = position - motion_tick_position;
+  int direction = next_step_direction();
+  if (direction == 0) {
+    direction = (moved > 0) - (moved < 0);
+  }
+  if (direction == 0 || direction == motion_lash_direction) {
+    return;
+  }
+  // or have taken the first steps of the reversal, or the last ones before it
+  long last     = moved * direction < 0 ? position : motion_tick_position;
+  long stepped  = max(0L, moved * direction);
+  long carriage = carriage_at(last);
+  long taken    = motion_taking_up ? motion_backlash - labs(motion_take_up_end - last) : motion_backlash;
+  bool reversed = motion_lash_direction != 0;
+  motion_lash_direction = direction;
+  if (!reversed || motion_backlash == 0) {
+    motion_taking_up = false;
+    return;
+  }
+  long  target = stepper.target();
+  float speed  = stepper.speed();
+  stepper.set_position(carriage - direction * (taken - stepped));
+  if (is_motion_accelerated()) {
+    stepper.move_to(target);
+  } else {
+    stepper.set_speed(speed);
+  }
+  motion_taking_up   = taken > stepped;
+  motion_take_up_end = carriage;
+  update_step_window();
+}
+
+// latches where the sensor triggered before anything moves on
+void latch_probe() {
+  motion_published.probe_position  = true_position(carriage_position());
+  motion_published.probe_triggered = true;
+  stop_motion(false);
+}
+
+void publish_motion_status() {
+  motion_published.mode               = motion_mode;
+  motion_published.position           = true_position(carriage_position());
+  if (motion_mode == motion_accelerate || motion_mode == motion_overshooting) {
+    motion_published.target = motion_carriage_target;
+  } else {
+    motion_published.target = true_position(stepper.target());
+  }
+  motion_published.speed              = stepper.speed();
+  motion_published.end_stop_triggered = motion_inputs.active<sensor_end_stop_trigger_pin>();
+  motion_status_for_control.write(motion_published);
+  motion_status_for_display.write(motion_published);
+}
+
+// a task, not an interrupt: like the AccelStepper and channel code it calls it runs from flash,
+// only the interrupts of TimerStepper.h and SensorFilter.cpp are IRAM_ATTR. A flash cache miss or a
+// Preferences write on the other core can hold up a step of the AccelStepper engine, steps of the
+// timer engine (-DSTEPPER_ENGINE=STEPPER_ENGINE_TIMER) come from IRAM
+void motion_tick() {
+  unsigned long now = micros();
+  if (motion_mode != motion_idle) {
+    record_tick_period(now - motion_last_tick);
+    if (now - motion_last_tick > motion_published.tick_period_maximal) {
+      motion_published.tick_period_maximal = now - motion_last_tick;
+    }
+  }
+  motion_last_tick = now;
+  // every check of this tick sees the same inputs
+  motion_inputs = sample_inputs();
+
+  enum motion_modes last_mode = motion_mode;
+  bool changed = receive_motion_commands();
+  if (motion_mode != motion_idle) {
+    take_up_backlash();
+  }
+
+  switch (motion_mode) {
+    case motion_idle:
+      break;
+    case motion_accelerate:
+      if (!move_motor_accelerate()) {
+        stop_motion(stepper.distance_to_go() != 0);
+      } else if (!stepper.is_running()) {
+        // at the target and standing still
+        stop_motion(false);
+      }
+      break;
+    case motion_constant:
+      if (!move_motor_constant()) {
+        stop_motion(true);
+      }
+      break;
+    case motion_probing:
+      if (motion_inputs.active<sensor_tool_length_trigger_pin>()) {
+        latch_probe();
+      } else if (!move_motor_constant()) {
+        stop_motion(true);
+      }
+      break;
+    case motion_approaching:
+      if (motion_inputs.active<sensor_tool_length_trigger_pin>()) {
+        // the estimate was off, better a hard stop than running on into the sensor
+        latch_probe();
+      } else if (!move_motor_accelerate()) {
+        stop_motion(stepper.distance_to_go() != 0);
+      } else if (!stepper.is_running()) {
+        // slowed down to a stop short of the sensor, the rest at probe speed
+        stepper.set_speed(motion_probe_speed);
+        motion_mode = motion_probing;
+      }
+      break;
+    case motion_freeing:
+      if (!motion_inputs.active(motion_free_sensor_pin)) {
+        // move some extra steps to avoid triggering sensor again
+        stepper.move(motion_free_tolerance);
+        motion_mode = motion_freeing_tolerance;
+      } else if (abs(stepper.position() - motion_free_start_position) > motion_free_maximal_distance) {
+        motion_published.faulted = true;
+        stop_motion(false);
+      } else {
+        stepper.run_speed_tick();
+      }
+      break;
+    case motion_freeing_tolerance:
+      if (!stepper.run_tick()) {
+        stop_motion(false);
+      }
+      break;
+    case motion_overshooting:
+      // an engine stepping on its own may have arrived since the last tick, standing it could not move on
+      if (!stepper.is_running()) {
+        // past the target, the way back ends in the approach direction
+        stepper.move_to(motion_approach_target);
+        motion_mode = motion_accelerate;
+      } else if (!move_motor_accelerate()) {
+        stop_motion(stepper.distance_to_go() != 0);
+      }
+      break;
+  }
+
+  motion_tick_position = stepper.position();
+
+  if (changed || motion_mode != last_mode || now - motion_last_publish >= MOTION_STATUS_INTERVAL) {
+    publish_motion_status();
+    motion_last_publish = now;
+  }
+}
+
+void motion_loop(void * parameter) {
+  while (true) {
+    motion_tick();
+    if (motion_mode == motion_idle) {
+      // nothing to step, give the core to lower priorities
+      task_delay(diagnostics_motion_task, 1);
+    }
+  }
+}
+
+void begin_motion() {
+  stepper.begin();
+  motion_inputs = sample_inputs();
+  publish_motion_status();
+
+  xTaskCreatePinnedToCore(
+    motion_loop, /* Function to implement the task */
+    "MotionTask", /* Name of the task */
+    MOTION_TASK_STACK_SIZE,  /* Stack size in bytes */
+    NULL,  /* Task input parameter */
+    MOTION_TASK_PRIORITY,  /* Priority of the task */
+    &task_loads[diagnostics_motion_task].handle,  /* Task handle. */
+    MOTION_TASK_CORE); /* Core where the task should run */
+}
+
+// MOTION COMMANDS START
+
+void send_motion_command(const motion_command &command) {
+  while (!motion_commands.push(command)) {
+    // the motion task runs at top priority, a full channel drains within a tick
+    vTaskDelay(1);
+  }
+  motion_commands_sent++;
+}
+
+void motion_halt() {
+  send_motion_command({ motion_command_halt });
+}
+
+void motion_move(long distance) {
+  send_motion_command({ motion_command_move, distance });
+}
+
+void motion_move_to(long target) {
+  send_motion_command({ motion_command_move_to, target });
+}
+
+void motion_run_speed(float speed) {
+  send_motion_command({ motion_command_run_speed, 0, 0, speed });
+}
+
+void motion_probe(float speed) {
+  send_motion_command({ motion_command_probe, 0, 0, speed });
+}
+
+void motion_approach_probe(long approach, float speed) {
+  send_motion_command({ motion_command_approach_probe, approach, 0, speed });
+}
+
+void motion_free_end_stop(float speed, long maximal_distance, long tolerance) {
+  send_motion_command({ motion_command_free_end_stop, maximal_distance, tolerance, speed });
+}
+
+void motion_free_tool_length(float speed, long maximal_distance, long tolerance) {
+  send_motion_command({ motion_command_free_tool_length, maximal_distance, tolerance, speed });
+}
+
+void motion_set_position(long position) {
+  send_motion_command({ motion_command_set_position, position });
+}
+
+void motion_set_profile(float speed, float acceleration) {
+  send_motion_command({ motion_command_set_profile, 0, 0, speed, acceleration });
+}
+
+void motion_set_workspace(bool active, long lower_limit, long upper_limit) {
+  send_motion_command({ motion_command_set_workspace, lower_limit, upper_limit, 0, 0, active });
+}
+
+void motion_set_target(bool active, long lower_limit) {
+  send_motion_command({ motion_command_set_target, lower_limit, 0, 0, 0, active });
+}
+
+void motion_set_backlash(long backlash, long approach) {
+  send_motion_command({ motion_command_set_backlash, backlash, approach });
+}
+
+// the command keeps the table in order with the commands around it, a newer table written before it is applied wins
+void motion_set_pitch_table(const motion_pitch_table &table) {
+  motion_pitch_tables.write(table);
+  send_motion_command({ motion_command_set_pitch_table });
+}
+
+bool is_motion_settled(const motion_status &status) {
+  return status.command_sequence == motion_commands_sent && status.mode == motion_idle;
+}
+// MOTION COMMANDS END
@@ -0,0 +1,150 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+#include "Channel.h"
+#include "Diagnostics.h"
+#include "Backends.h"
+#include "Gpio.h"
+
+#define MOTION_TASK_STACK_SIZE  4096 // [bytes]
+// overridable to compare against motion sharing a core with the other tasks, see sim/benchmark.cpp
+#ifndef MOTION_TASK_PRIORITY
+#define MOTION_TASK_PRIORITY    (configMAX_PRIORITIES - 1)
+#endif
+#ifndef MOTION_TASK_CORE
+#define MOTION_TASK_CORE        1
+#endif
+#define MOTION_COMMANDS_LENGTH  16 // power of two
+#define MOTION_STATUS_INTERVAL  1000 // [us]
+#define MOTION_PITCH_POINTS     16 // of the pitch error table
+
+extern stepper_engine stepper;
+
+// MOTION INTERFACE START
+// the motion task owns the stepper, everybody else talks to it with commands and reads its status
+
+enum motion_command_types {
+  motion_command_halt,
+  motion_command_move,             // position is the distance
+  motion_command_move_to,          // position is the target
+  motion_command_run_speed,        // runs at speed until halted or blocked
+  motion_command_probe,            // runs at speed until the tool length sensor triggers
+  motion_command_approach_probe,   // moves with the profile to position, then probes at speed, the sensor may trigger on the way
+  motion_command_free_end_stop,    // backs off at speed for at most position steps, then upper_limit extra steps
+  motion_command_free_tool_length, // same as motion_command_free_end_stop
+  motion_command_set_position,
+  motion_command_set_profile,      // speed is the maximal speed
+  motion_command_set_workspace,    // position is the lower limit
+  motion_command_set_target,       // position is the lower limit
+  motion_command_set_backlash,     // position is the backlash, upper_limit the approach
+  motion_command_set_pitch_table   // takes the newest table from motion_pitch_tables
+};
+
+enum motion_modes {
+  motion_idle,
+  motion_accelerate,
+  motion_constant,
+  motion_probing,
+  motion_approaching,
+  motion_freeing,
+  motion_freeing_tolerance,
+  motion_overshooting // past the target of a move against the approach direction, comes back to it
+};
+
+struct motion_command {
+  enum motion_command_types type;
+  long  position;     // [steps]
+  long  upper_limit;  // [steps]
+  float speed;        // [steps per second]
+  float acceleration; // [steps per second per second]
+  bool  active;
+};
+
+// the points go along the screw in one direction, between them the error is interpolated, beyond them it stays
+struct motion_pitch_table {
+  long screw[MOTION_PITCH_POINTS];    // [steps] the motor counts on a perfect screw
+  long carriage[MOTION_PITCH_POINTS]; // [steps] where the carriage really is then
+  long count;                         // 0 is a perfect screw
+};
+
+struct motion_status {
+  uint32_t command_sequence; // number of commands applied so far
+  enum motion_modes mode;
+  long  position;       // [steps] of the carriage, the motor is off by the backlash while taking it up and by the pitch error of the screw
+  long  target;         // [steps] where the move ends
+  float speed;          // [steps per second]
+  bool  blocked;        // last move was stopped by the end stop, workspace or target
+  bool  faulted;        // freeing a sensor failed, commands are ignored until the next halt
+  bool  end_stop_triggered;
+  bool  probe_triggered;
+  long  probe_position; // [steps] latched when the tool length sensor triggered
+  unsigned long tick_period_maximal; // [us] worst time between two step chances while moving
+};
+
+extern channel<motion_command, MOTION_COMMANDS_LENGTH> motion_commands; // control task -> motion task
+extern mailbox<motion_status> motion_status_for_control;                // motion task -> control task
+extern mailbox<motion_status> motion_status_for_display;                // motion task -> display task
+extern mailbox<motion_pitch_table> motion_pitch_tables;                 // control task -> motion task, one table is too big for a command
+
+extern uint32_t motion_commands_sent; // only touched by the sender
+// MOTION INTERFACE END
+
+// MOTION TASK VALUES START
+// only touched by the motion task
+extern enum motion_modes motion_mode;
+
+extern bool  motion_workspace_active;
+extern long  motion_workspace_lower_limit; // [steps]
+extern long  motion_workspace_upper_limit; // [steps]
+
+extern bool  motion_target_active;
+extern long  motion_target_lower_limit; // [steps]
+
+extern long  motion_backlash; // [steps] the motor turns after a reversal before the carriage follows
+extern long  motion_approach; // [steps] signed by the direction every move ends with, 0 ends either way
+
+extern motion_pitch_table motion_pitch;
+
+extern input_sample motion_inputs; // sampled once per motion tick
+
+extern motion_status motion_published;
+// MOTION TASK VALUES END
+
+// MOTION TASK START
+void motion_tick();
+
+// [steps] piecewise linear from one column of a pitch table to the other, beyond its ends the screw is perfect
+long interpolate_pitch(long position, const long *from, const long *to, long count);
+
+// [steps] between where the motor counts on a perfect screw and where the carriage really is, through the pitch table
+long true_position(long screw_position);
+long screw_position(long true_position);
+
+// call once the input inversion is set
+void begin_motion();
+// MOTION TASK END
+
+// MOTION COMMANDS START
+// called from the control task only, the channel has a single producer
+void motion_halt();
+void motion_move(long distance);
+void motion_move_to(long target);
+void motion_run_speed(float speed);
+void motion_probe(float speed);
+void motion_approach_probe(long approach, float speed);
+void motion_free_end_stop(float speed, long maximal_distance, long tolerance);
+void motion_free_tool_length(float speed, long maximal_distance, long tolerance);
+void motion_set_position(long position);
+void motion_set_profile(float speed, float acceleration);
+void motion_set_workspace(bool active, long lower_limit, long upper_limit);
+void motion_set_target(bool active, long lower_limit);
+void motion_set_backlash(long backlash, long approach);
+void motion_set_pitch_table(const motion_pitch_table &table);
+
+// all commands are applied and nothing moves anymore
+bool is_motion_settled(const motion_status &status);
+// MOTION COMMANDS END
+
+#endif // MOTION_H
@@ -0,0 +1,120 @@
+#ifndef PIN_DEFINITIONS_H
+#define PIN_DEFINITIONS_H
+
+#include <stdint.h>
+
+// Pin maps of the boards, the build env picks one with -DBOARD_SMD or
+// -DBOARD_PROTOTYPE, without either it is the THT board.
+
+#define PIN_NONE 0xff
+
+// BOARD PROFILES START
+struct board_tht {
+  static constexpr const char *name = "THT";
+
+  static constexpr uint8_t enable    = 36; // CFG6 of the driver
+  static constexpr uint8_t step      = 12;
+  static constexpr uint8_t direction = 13;
+
+  static constexpr uint8_t button_up          = 21;
+  static constexpr uint8_t button_down        = 19;
+  static constexpr uint8_t button_toolchange  = 18;
+  static constexpr uint8_t button_set_zero    = 5;
+  static constexpr uint8_t button_set_speed   = 17;
+  static constexpr uint8_t button_goto_bottom = 16;
+
+  static constexpr uint8_t encoder_a = 14;
+  static constexpr uint8_t encoder_b = 27;
+
+  static constexpr uint8_t i2c_data  = 22;
+  static constexpr uint8_t i2c_clock = 23;
+
+  static constexpr uint8_t sensor_end_stop_trigger    = 33;
+  static constexpr uint8_t sensor_tool_length_trigger = 25;
+  static constexpr uint8_t sensor_tool_length_enabled = 26;
+};
+
+struct board_smd {
+  static constexpr const char *name = "SMD";
+
+  static constexpr uint8_t enable    = PIN_NONE;
+  static constexpr uint8_t step      = 15;
+  static constexpr uint8_t direction = 13;
+
+  static constexpr uint8_t button_up          = 27;
+  static constexpr uint8_t button_down        = 26;
+  static constexpr uint8_t button_toolchange  = 25;
+  static constexpr uint8_t button_set_zero    = 32;
+  static constexpr uint8_t button_set_speed   = 35;
+  static constexpr uint8_t button_goto_bottom = 34;
+
+  static constexpr uint8_t encoder_a = 14;
+  static constexpr uint8_t encoder_b = 12;
+
+  static constexpr uint8_t i2c_data  = 33;
+  static constexpr uint8_t i2c_clock = 36;
+
+  static constexpr uint8_t sensor_end_stop_trigger    = 18;
+  static constexpr uint8_t sensor_tool_length_trigger = 19;
+  static constexpr uint8_t sensor_tool_length_enabled = 23;
+};
+
+// hand wired board from before the PCBs, env az-delivery-devkit-v4-prototype
+struct board_prototype {
+  static constexpr const char *name = "prototype";
+
+  static constexpr uint8_t enable    = PIN_NONE;
+  static constexpr uint8_t step      = 19;
+  static constexpr uint8_t direction = 15;
+
+  static constexpr uint8_t button_up          = 23;
+  static constexpr uint8_t button_down        = 18;
+  static constexpr uint8_t button_toolchange  = 32;
+  static constexpr uint8_t button_set_zero    = 13;
+  static constexpr uint8_t button_set_speed   = 4;
+  static constexpr uint8_t button_goto_bottom = 25;
+
+  static constexpr uint8_t encoder_a = 14;
+  static constexpr uint8_t encoder_b = 27;
+
+  static constexpr uint8_t i2c_data  = 21;
+  static constexpr uint8_t i2c_clock = 22;
+
+  static constexpr uint8_t sensor_end_stop_trigger    = 16;
+  static constexpr uint8_t sensor_tool_length_trigger = 17;
+  static constexpr uint8_t sensor_tool_length_enabled = 5;
+};
+
+#if defined(BOARD_SMD)
+typedef board_smd board;
+#elif defined(BOARD_PROTOTYPE)
+typedef board_prototype board;
+#else
+typedef board_tht board;
+#endif
+// BOARD PROFILES END
+
+// PINS START
+constexpr uint8_t PIN_ENABLE    = board::enable;
+constexpr uint8_t PIN_STEP      = board::step;
+constexpr uint8_t PIN_DIRECTION = board::direction;
+
+constexpr uint8_t PIN_BUTTON_UP          = board::button_up;
+constexpr uint8_t PIN_BUTTON_DOWN        = board::button_down;
+constexpr uint8_t PIN_BUTTON_TOOLCHANGE  = board::button_toolchange;
+constexpr uint8_t PIN_BUTTON_SET_ZERO    = board::button_set_zero;
+constexpr uint8_t PIN_BUTTON_SET_SPEED   = board::button_set_speed;
+constexpr uint8_t PIN_BUTTON_GOTO_BOTTOM = board::button_goto_bottom;
+
+constexpr uint8_t PIN_ENCODER_A_MINUS = board::encoder_a;
+constexpr uint8_t PIN_ENCODER_B_MINUS = board::encoder_b;
+
+constexpr uint8_t PIN_ICC_DATA  = board::i2c_data;
+constexpr uint8_t PIN_ICC_CLOCK = board::i2c_clock;
+
+constexpr uint8_t PIN_SENSOR_END_STOP_TRIGGER    = board::sensor_end_stop_trigger;
+constexpr uint8_t PIN_SENSOR_TOOL_LENGTH_TRIGGER = board::sensor_tool_length_trigger;
+constexpr uint8_t PIN_SENSOR_TOOL_LENGTH_ENABLED = board::sensor_tool_length_enabled;
+// PINS END
+
+#endif // PIN_DEFINITIONS_H
@@ -0,0 +1,36 @@
+#include "RouterLift.h"
+
+void router_lift_setup() {
+  Serial.begin(115200);
+  if (PIN_ENABLE != PIN_NONE) {
+    pinMode(PIN_ENABLE, OUTPUT);
+    digitalWrite(PIN_ENABLE, HIGH); //deactivate driver (LOW active)
+    digitalWrite(PIN_ENABLE, LOW); //activate driver
+  }
+  pinMode(PIN_STEP, OUTPUT);
+  pinMode(PIN_DIRECTION,  OUTPUT);
+
+  // INPUT SETUP START
+  begin_input();
+  // INPUT SETUP END
+
+  // PREFERENCES SETUP START
+  preferences.begin("settings", false);
+  read_settings();
+  // PREFERENCES SETUP END
+
+  // STEPPER MOTOR SETUP START
+  // speed unit is [steps per second]
+  stepper.set_profile(resonance_free_speed(preference_motor_speed_maximal), preference_motor_acceleration);
+  stepper.set_position(0);
+  begin_motion();
+  // STEPPER MOTOR SETUP END
+
+  // DISPLAY SETUP START
+  begin_display();
+  // DISPLAY SETUP END
+
+  // CONTROL SETUP START
+  begin_control();
+  // CONTROL SETUP END
+}
@@ -0,0 +1,28 @@
+#ifndef ROUTER_LIFT_H
+#define ROUTER_LIFT_H
+
+// Router lift control as one library. Every module is its own translation unit,
+// the tasks only share what the headers declare:
+//  - Motion:   motion task, owns the stepper through the stepper driver of StepperDriver.h
+//  - Input:    buttons, encoder and sensors
+//  - SensorFilter: timer sampled debouncing of the end stop and the tool length sensor
+//  - Display:  display task, draws and collects the inputs
+//  - Settings: preferences and the settings menu pages
+//  - Control:  control task with the state machine
+
+#include "Backends.h"
+#include "Control.h"
+#include "Diagnostics.h"
+#include "Display.h"
+#include "Gpio.h"
+#include "Input.h"
+#include "Motion.h"
+#include "PinDefinitions.h"
+#include "SensorFilter.h"
+#include "Settings.h"
+#include "StepperDriver.h"
+
+// sets up the periphery and starts the tasks, call from setup()
+void router_lift_setup();
+
+#endif // ROUTER_LIFT_H
@@ -0,0 +1,197 @@
+#include "SensorFilter.h"
+
+// SENSOR FILTER VALUES START
+const sensor_filter_setting sensor_filter_settings[SENSOR_FILTER_SETTINGS_COUNT] = {
+  { sensor_filter_raw,        1,  "RAW"    },
+  { sensor_filter_vote,       3,  "VOTE 3" },
+  { sensor_filter_vote,       5,  "VOTE 5" },
+  { sensor_filter_vote,       9,  "VOTE 9" },
+  { sensor_filter_integrator, 4,  "INT 4"  },
+  { sensor_filter_integrator, 8,  "INT 8"  },
+  { sensor_filter_integrator, 16, "INT 16" },
+};
+
+const char *filtered_sensor_names[filtered_sensors_count] = {
+  "end stop",
+  "tool length"
+};
+
+channel<sensor_edge, SENSOR_EDGES_LENGTH> sensor_edges;
+
+std::atomic<uint32_t> sensor_filter_latency_maximal[filtered_sensors_count] = {};
+sensor_edge_summary sensor_edge_summaries[filtered_sensors_count] = {};
+
+// kind and samples are copies of the setting: sensor_filter_settings is in flash, the sampler
+// interrupt may come while a Preferences write has the flash cache off
+struct sensor_filter {
+  uint8_t  pin;
+  const sensor_filter_setting *setting; // task side only
+  enum sensor_filter_kinds kind;
+  uint8_t  samples;
+  uint32_t history;  // vote: one bit per sample, the newest in bit 0
+  uint8_t  level;    // integrator: 0 is inactive, samples is active
+  bool     active;   // output
+  bool     changing; // samples disagree with the output since changing_since
+  uint32_t changing_since; // [us]
+};
+
+// only touched under the lock
+sensor_filter sensor_filters[filtered_sensors_count] = {
+  { PIN_SENSOR_END_STOP_TRIGGER,    &sensor_filter_settings[0], sensor_filter_raw, 1 },
+  { PIN_SENSOR_TOOL_LENGTH_TRIGGER, &sensor_filter_settings[0], sensor_filter_raw, 1 },
+};
+
+portMUX_TYPE sensor_filter_lock = portMUX_INITIALIZER_UNLOCKED;
+hw_timer_t *sensor_filter_timer = nullptr;
+bool sensor_filter_sampling = false; // some sensor is filtered
+// SENSOR FILTER VALUES END
+
+uint32_t IRAM_ATTR window_mask(uint8_t samples) {
+  return samples >= 32 ? UINT32_MAX : (1UL << samples) - 1;
+}
+
+// set bits, in place of __builtin_popcount() which may become a call into libgcc in flash
+uint32_t IRAM_ATTR count_bits(uint32_t bits) {
+  bits = bits - ((bits >> 1) & 0x55555555);
+  bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+  return (((bits + (bits >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+// all samples in the filter agree with its output again
+bool IRAM_ATTR is_filter_settled(const sensor_filter &filter) {
+  uint8_t samples = filter.samples;
+  if (filter.kind == sensor_filter_vote) {
+    return (filter.history & window_mask(samples)) == (filter.active ? window_mask(samples) : 0);
+  }
+  return filter.level == (filter.active ? samples : 0);
+}
+
+// returns true when the output switched
+bool IRAM_ATTR filter_sample(sensor_filter &filter, bool raw) {
+  uint8_t samples = filter.samples;
+  bool active = filter.active;
+  if (filter.kind == sensor_filter_vote) {
+    filter.history = (filter.history << 1) | raw;
+    active = count_bits(filter.history & window_mask(samples)) * 2 > samples;
+  } else {
+    if (raw && filter.level < samples) {
+      filter.level++;
+    } else if (!raw && filter.level > 0) {
+      filter.level--;
+    }
+    if (filter.level == samples) {
+      active = true;
+    } else if (filter.level == 0) {
+      active = false;
+    }
+  }
+  bool switched = active != filter.active;
+  filter.active = active;
+  return switched;
+}
+
+void IRAM_ATTR publish_filtered(uint8_t pin, bool active) {
+  uint32_t mask = 1UL << (pin % 32);
+  if (active) {
+    input_filtered[pin / 32].fetch_or(mask, std::memory_order_relaxed);
+  } else {
+    input_filtered[pin / 32].fetch_and(~mask, std::memory_order_relaxed);
+  }
+}
+
+void IRAM_ATTR sample_sensors() {
+  portENTER_CRITICAL_ISR(&sensor_filter_lock);
+  uint32_t now = micros();
+  input_sample raw = sample_raw_inputs();
+  for (int sensor = 0; sensor < filtered_sensors_count; sensor++) {
+    sensor_filter &filter = sensor_filters[sensor];
+    if (filter.kind == sensor_filter_raw) {
+      continue;
+    }
+    bool level = raw.active(filter.pin);
+    if (!filter.changing && level != filter.active) {
+      filter.changing       = true;
+      filter.changing_since = now;
+    }
+    if (filter_sample(filter, level)) {
+      publish_filtered(filter.pin, filter.active);
+      sensor_edge edge = { (enum filtered_sensors)sensor, filter.active, now, now - filter.changing_since };
+      if (edge.latency > sensor_filter_latency_maximal[sensor].load(std::memory_order_relaxed)) {
+        sensor_filter_latency_maximal[sensor].store(edge.latency, std::memory_order_relaxed);
+      }
+      // dropped when the control task is SENSOR_EDGES_LENGTH edges behind
+      sensor_edges.push(edge);
+      filter.changing = false;
+    } else if (filter.changing && is_filter_settled(filter)) {
+      // a glitch the filter swallowed
+      filter.changing = false;
+    }
+  }
+  portEXIT_CRITICAL_ISR(&sensor_filter_lock);
+}
+
+void update_sampling() {
+  if (!sensor_filter_timer) {
+    return;
+  }
+  if (sensor_filter_sampling) {
+    timerAlarmEnable(sensor_filter_timer);
+  } else {
+    timerAlarmDisable(sensor_filter_timer);
+  }
+}
+
+// SENSOR FILTER START
+void set_sensor_filters(long end_stop_setting, long tool_length_setting) {
+  long settings[filtered_sensors_count] = { end_stop_setting, tool_length_setting };
+  uint32_t mask[2] = {};
+
+  portENTER_CRITICAL(&sensor_filter_lock);
+  input_sample raw = sample_raw_inputs();
+  sensor_filter_sampling = false;
+  for (int sensor = 0; sensor < filtered_sensors_count; sensor++) {
+    sensor_filter &filter = sensor_filters[sensor];
+    long setting = settings[sensor];
+    filter.setting  = &sensor_filter_settings[setting >= 0 && setting < SENSOR_FILTER_SETTINGS_COUNT ? setting : 0];
+    filter.kind     = filter.setting->kind;
+    filter.samples  = filter.setting->samples;
+    filter.active   = raw.active(filter.pin);
+    filter.history  = filter.active ? UINT32_MAX : 0;
+    filter.level    = filter.active ? filter.samples : 0;
+    filter.changing = false;
+    publish_filtered(filter.pin, filter.active);
+    if (filter.kind != sensor_filter_raw) {
+      mask[filter.pin / 32] |= 1UL << (filter.pin % 32);
+      sensor_filter_sampling = true;
+    }
+  }
+  input_filtered_mask[0].store(mask[0], std::memory_order_relaxed);
+  input_filtered_mask[1].store(mask[1], std::memory_order_relaxed);
+  update_sampling();
+  portEXIT_CRITICAL(&sensor_filter_lock);
+}
+
+void begin_sensor_filters() {
+  sensor_filter_timer = timerBegin(SENSOR_FILTER_TIMER, SENSOR_FILTER_DIVIDER, true);
+  timerAttachInterrupt(sensor_filter_timer, sample_sensors, true);
+  timerAlarmWrite(sensor_filter_timer, SENSOR_SAMPLE_INTERVAL, true);
+  portENTER_CRITICAL(&sensor_filter_lock);
+  update_sampling();
+  portEXIT_CRITICAL(&sensor_filter_lock);
+}
+
+void receive_sensor_edges() {
+  sensor_edge edge;
+  while (sensor_edges.pop(edge)) {
+    sensor_edge_summary &summary = sensor_edge_summaries[edge.sensor];
+    summary.edges++;
+    summary.last = edge;
+  }
+}
+
+void print_sensor_filters() {
+  for (int sensor = 0; sensor < filtered_sensors_count; sensor++) {
+    Serial.printf("%-12s filter %s\n", filtered_sensor_names[sensor], sensor_filters[sensor].setting->name);
+  }
+}
+// SENSOR FILTER END
@@ -0,0 +1,81 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "Channel.h"
+#include "Gpio.h"
+
+#define SENSOR_FILTER_TIMER    1   // timer 0 steps the motor with STEPPER_ENGINE_TIMER
+#define SENSOR_FILTER_DIVIDER  80  // APB clock to 1 MHz, alarms are in [us]
+#define SENSOR_SAMPLE_INTERVAL 100 // [us]
+#define SENSOR_EDGES_LENGTH    16  // power of two
+
+// Debounces the end stop and the tool length sensor from a timer interrupt at a fixed rate, each
+// with the filter its setting picks. sample_inputs() hands the filtered levels to every task.
+// Raw sensors are read by the tasks like any other pin, with both raw the interrupt does not run.
+//
+// A filter holds its output until enough samples agree on the other level, so a glitch shorter
+// than that never reaches the tasks and a bouncing contact gives one edge. The price is latency,
+// on a clean edge about samples * SENSOR_SAMPLE_INTERVAL for an integrator and half of that for a vote,
+// the probe runs on that long after the sensor triggered.
+
+// SENSOR FILTER VALUES START
+enum sensor_filter_kinds {
+  sensor_filter_raw,
+  sensor_filter_vote,      // majority of the last samples
+  sensor_filter_integrator // counts up while active and down while not, switches at either end
+};
+
+struct sensor_filter_setting {
+  enum sensor_filter_kinds kind;
+  uint8_t samples; // vote window or integrator range, at most 32
+  const char *name;
+};
+
+#define SENSOR_FILTER_SETTINGS_COUNT 7
+extern const sensor_filter_setting sensor_filter_settings[SENSOR_FILTER_SETTINGS_COUNT];
+
+enum filtered_sensors {
+  filtered_end_stop,
+  filtered_tool_length,
+  filtered_sensors_count
+};
+
+extern const char *filtered_sensor_names[filtered_sensors_count];
+
+struct sensor_edge {
+  enum filtered_sensors sensor;
+  bool active;
+  uint32_t at;      // [us] micros() of the sample that switched the filter
+  uint32_t latency; // [us] since the first sample at the new level that led to the edge
+};
+
+extern channel<sensor_edge, SENSOR_EDGES_LENGTH> sensor_edges; // sampler interrupt -> control task
+
+// what receive_sensor_edges() made of the edges, for the diagnostics report
+struct sensor_edge_summary {
+  uint32_t edges;   // since boot
+  sensor_edge last; // valid once edges is non-zero
+};
+
+extern sensor_edge_summary sensor_edge_summaries[filtered_sensors_count]; // only touched by the control task
+
+// worst latency since boot, written by the sampler interrupt
+extern std::atomic<uint32_t> sensor_filter_latency_maximal[filtered_sensors_count]; // [us]
+// SENSOR FILTER VALUES END
+
+// SENSOR FILTER START
+// settings are indices into sensor_filter_settings, out of range is raw;
+// filters restart at the level the pins have, so a change gives no edge
+void set_sensor_filters(long end_stop_setting, long tool_length_setting);
+
+// the sampler interrupt runs on the calling core, call from the control task
+void begin_sensor_filters();
+
+// control task side, counts the edges filtered since the last call into sensor_edge_summaries
+void receive_sensor_edges();
+void print_sensor_filters();
+// SENSOR FILTER END
+
+#endif // SENSOR_FILTER_H
@@ -0,0 +1,492 @@
+#include "Settings.h"
+#include "Input.h"
+#include "SensorFilter.h"
+#include <math.h>
+
+// PERIPHERY START
+Preferences preferences;
+// PERIPHERY END
+
+// PREFERENCE VALUES START
+long  default_motor_steps_per_revolution = DEFAULT_STEPS_PER_REVOLUTION; // [steps per revolution]
+float default_motor_thread_pitch         =    8.0; // [mm per revolution]
+long  default_motor_steps_slow           = round(0.05 / (default_motor_thread_pitch / default_motor_steps_per_revolution))  ; // [steps per encoder step]
+long  default_motor_steps_fast           = round(1.0 / (default_motor_thread_pitch / default_motor_steps_per_revolution))  ; // [steps per encoder step]
+long  default_motor_direction            = -1  ; // [-1 or 1]
+long  default_motor_speed_maximal        = default_motor_steps_per_revolution  ; // [steps per second]
+long  default_motor_speed_toolchange     = default_motor_steps_per_revolution  ; // [steps per second]
+long  default_motor_acceleration         = default_motor_steps_per_revolution >> 2  ; // [steps per second per second]
+
+bool  default_sensor_end_stop_normally_closed = true;
+long  default_sensor_end_stop_filter = 0; // raw
+
+bool  default_sensor_tool_length_enabled_normally_closed = false;
+bool  default_sensor_tool_length_normally_closed = false;
+float default_sensor_tool_length_height = 0.0; // mm
+long  default_sensor_tool_length_filter = 0; // raw
+
+float default_workspace_height = 75.0; // mm
+
+bool  default_power_on_toolchange = false;
+
+long  default_auto_zero_speed = 1600; // [steps per second]
+
+bool  default_tool_table_enabled  = false;
+bool  default_tool_verify_enabled = false;
+
+float default_pass_step = 2.0; // mm
+
+long  default_feed_rate = 300; // [mm per minute]
+
+long  default_backlash = 0; // [steps]
+bool  default_approach_from_below = false;
+
+long  preference_motor_steps_per_revolution; // [steps per revolution]
+float preference_motor_thread_pitch;         // [mm per revolution]
+long  preference_motor_steps_slow;           // [steps per encoder step]
+long  preference_motor_steps_fast;           // [steps per encoder step]
+long  preference_motor_direction;            // [-1 or 1]
+long  preference_motor_speed_maximal;        // [steps per second]
+long  preference_motor_speed_toolchange;     // [steps per second]
+long  preference_motor_acceleration;         // [steps per second per second]
+
+bool  preference_sensor_end_stop_normally_closed;
+long  preference_sensor_end_stop_filter;
+bool  preference_sensor_tool_length_enabled_normally_closed;
+bool  preference_sensor_tool_length_normally_closed;
+float preference_sensor_tool_length_height; // mm
+long  preference_sensor_tool_length_filter;
+
+float preference_workspace_height; // mm
+
+bool  preference_power_on_toolchange;
+
+long  preference_auto_zero_speed; // [steps per second]
+
+bool  preference_tool_table_enabled;
+bool  preference_tool_verify_enabled;
+long  preference_tool_offsets[TOOL_SLOTS_COUNT]; // [steps]
+
+long  preference_work_offset_slot;
+float preference_work_offsets[WORK_OFFSETS_COUNT]; // mm
+
+float preference_presets[PRESET_SLOTS_COUNT]; // mm
+
+float preference_pass_step; // mm
+
+long  preference_feed_rate; // [mm per minute]
+
+long  preference_backlash; // [steps]
+bool  preference_approach_from_below;
+
+long  preference_pitch_point;
+float preference_pitch_errors[PITCH_TABLE_POINTS]; // mm
+
+long  preference_resonance_band;
+long  preference_resonance_lower[RESONANCE_BANDS_COUNT]; // [steps per second]
+long  preference_resonance_upper[RESONANCE_BANDS_COUNT]; // [steps per second]
+// PREFERENCE VALUES END
+
+// COMPUTED VALUES START
+float mm_per_step() {
+  return preference_motor_thread_pitch / preference_motor_steps_per_revolution; // [mm per step]
+}
+
+float position_in_mm(long position) {
+  return round(position * mm_per_step() * 100) / 100 * preference_motor_direction; // [mm]
+}
+
+long work_offset_in_steps() {
+  return lround(preference_work_offsets[preference_work_offset_slot] / mm_per_step()) * preference_motor_direction; // [steps]
+}
+
+float resonance_free_speed(float speed) {
+  float magnitude = min(fabsf(speed), (float)preference_motor_speed_maximal);
+  // an edge may lie inside another band
+  for (long pass = 0; pass < RESONANCE_BANDS_COUNT; pass++) {
+    for (long band = 0; band < RESONANCE_BANDS_COUNT; band++) {
+      long lower = preference_resonance_lower[band];
+      long upper = preference_resonance_upper[band];
+      if (magnitude > lower && magnitude < upper) {
+        // a band from standstill past the maximal speed leaves nothing to go to, the speed stays
+        if (lower > 0 || upper <= preference_motor_speed_maximal) {
+          magnitude = lower > 0 ? lower : upper;
+        }
+      }
+    }
+  }
+  return speed < 0 ? -magnitude : magnitude; // [steps per second]
+}
+// COMPUTED VALUES END
+
+// SETTINGS START
+static_assert(2 * PITCH_ERROR_MAXIMAL < PITCH_TABLE_SPACING, "neighbouring points of the pitch table could swap places");
+
+// preference key of a tool slot
+const char *tool_key(long slot) {
+  static char key[8];
+  snprintf(key, sizeof(key), "tool_%ld", slot);
+  return key;
+}
+
+// preference key of a work offset slot
+const char *work_key(long slot) {
+  static char key[8];
+  snprintf(key, sizeof(key), "work_%ld", slot);
+  return key;
+}
+
+// preference key of a height preset
+const char *preset_key(long slot) {
+  static char key[12];
+  snprintf(key, sizeof(key), "preset_%ld", slot);
+  return key;
+}
+
+// keeps the compensated travel going the way the motor turns
+float limit_pitch_error(float error) {
+  return constrain(error, (float)-PITCH_ERROR_MAXIMAL, (float)PITCH_ERROR_MAXIMAL);
+}
+
+// preference keys of the limits of a resonance band
+const char *resonance_lower_key(long band) {
+  static char key[12];
+  snprintf(key, sizeof(key), "res_low_%ld", band);
+  return key;
+}
+
+const char *resonance_upper_key(long band) {
+  static char key[12];
+  snprintf(key, sizeof(key), "res_up_%ld", band);
+  return key;
+}
+
+// preference key of a point of the pitch table
+const char *pitch_key(long point) {
+  static char key[12];
+  snprintf(key, sizeof(key), "pitch_%ld", point);
+  return key;
+}
+
+void read_settings() {
+  preference_motor_steps_per_revolution = preferences.getLong64("steps_per_rev", default_motor_steps_per_revolution);
+  preference_motor_thread_pitch         = preferences.getFloat("thread_pitch", default_motor_thread_pitch);
+  preference_motor_steps_slow           = preferences.getLong64("steps_slow", default_motor_steps_slow);
+  preference_motor_steps_fast           = preferences.getLong64("steps_fast", default_motor_steps_fast);
+  preference_motor_direction            = preferences.getLong64("motor_dir", default_motor_direction);
+  preference_motor_speed_maximal        = preferences.getLong64("motor_speed_max", default_motor_speed_maximal);
+  preference_motor_speed_toolchange     = preferences.getLong64("speed_toolch", default_motor_speed_toolchange);
+  preference_motor_acceleration         = preferences.getLong64("motor_acc", default_motor_acceleration);
+
+  preference_sensor_end_stop_normally_closed = preferences.getBool("end_stop_n_c", default_sensor_end_stop_normally_closed);
+  preference_sensor_end_stop_filter          = constrain((long)preferences.getLong64("end_stop_filter", default_sensor_end_stop_filter), 0L, SENSOR_FILTER_SETTINGS_COUNT - 1L);
+
+  preference_sensor_tool_length_normally_closed         = preferences.getBool("tlsensor_n_c", default_sensor_tool_length_normally_closed);
+  preference_sensor_tool_length_enabled_normally_closed = preferences.getBool("tlsensor_en_n_c", default_sensor_tool_length_enabled_normally_closed);
+  preference_sensor_tool_length_height                  = preferences.getFloat("tlsensor_height", default_sensor_tool_length_height);
+  preference_sensor_tool_length_filter                  = constrain((long)preferences.getLong64("tlsensor_filter", default_sensor_tool_length_filter), 0L, SENSOR_FILTER_SETTINGS_COUNT - 1L);
+
+  preference_workspace_height = preferences.getFloat("ws_height", default_workspace_height);
+
+  preference_power_on_toolchange = preferences.getBool("pwr_on_toolch", default_power_on_toolchange);
+
+  preference_auto_zero_speed = preferences.getLong64("auto_zero_speed", default_auto_zero_speed);
+
+  preference_tool_table_enabled  = preferences.getBool("tool_table", default_tool_table_enabled);
+  preference_tool_verify_enabled = preferences.getBool("tool_verify", default_tool_verify_enabled);
+  for (long slot = 0; slot < TOOL_SLOTS_COUNT; slot++) {
+    preference_tool_offsets[slot] = preferences.getLong64(tool_key(slot), TOOL_OFFSET_UNKNOWN);
+  }
+
+  preference_work_offset_slot = constrain((long)preferences.getLong64("work_slot", 0), 0L, WORK_OFFSETS_COUNT - 1L);
+  for (long slot = 0; slot < WORK_OFFSETS_COUNT; slot++) {
+    preference_work_offsets[slot] = preferences.getFloat(work_key(slot), 0.0);
+  }
+  for (long slot = 0; slot < PRESET_SLOTS_COUNT; slot++) {
+    preference_presets[slot] = preferences.getFloat(preset_key(slot), NAN);
+  }
+
+  preference_pass_step = preferences.getFloat("pass_step", default_pass_step);
+
+  preference_feed_rate = max((long)FEED_RATE_DISTANCE, (long)preferences.getLong64("feed_rate", default_feed_rate));
+
+  preference_backlash            = preferences.getLong64("backlash", default_backlash);
+  preference_approach_from_below = preferences.getBool("approach_below", default_approach_from_below);
+
+  preference_pitch_point = constrain((long)preferences.getLong64("pitch_point", 0), 0L, PITCH_TABLE_POINTS - 1L);
+  for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+    preference_pitch_errors[point] = limit_pitch_error(preferences.getFloat(pitch_key(point), 0.0));
+  }
+
+  preference_resonance_band = constrain((long)preferences.getLong64("res_band", 0), 0L, RESONANCE_BANDS_COUNT - 1L);
+  for (long band = 0; band < RESONANCE_BANDS_COUNT; band++) {
+    preference_resonance_lower[band] = preferences.getLong64(resonance_lower_key(band), 0);
+    preference_resonance_upper[band] = max(preference_resonance_lower[band], (long)preferences.getLong64(resonance_upper_key(band), 0));
+  }
+
+  update_input_inversion();
+  update_sensor_filters();
+}
+
+void reset_settings_to_default() {
+  preferences.clear();
+  read_settings();
+}
+
+int change_setting(long page, long encoder_steps) {
+  // steps per revolution, direction and thread pitch scale everything in mm
+  const int scale = setting_group_backlash | setting_group_pitch_table;
+  int changed = setting_group_none;
+  switch (page) {
+    case 0:
+      preference_motor_speed_maximal += encoder_steps * 10;
+      if (preference_motor_speed_maximal < 0) {
+        preference_motor_speed_maximal = 0;
+      }
+      preferences.putLong64("motor_speed_max", preference_motor_speed_maximal);
+      changed = setting_group_profile;
+      break;
+    case 1:
+      preference_motor_acceleration += encoder_steps * 10;
+      if (preference_motor_acceleration < 0) {
+        preference_motor_acceleration = 0;
+      }
+      preferences.putLong64("motor_acc", preference_motor_acceleration);
+      changed = setting_group_profile;
+      break;
+    case 2:
+      preference_motor_steps_per_revolution += encoder_steps * 100;
+      if (preference_motor_steps_per_revolution < 0) {
+        preference_motor_steps_per_revolution = 0;
+      }
+      preferences.putLong64("steps_per_rev", preference_motor_steps_per_revolution);
+      changed = scale;
+      break;
+    case 3:
+      if (preference_motor_direction == -1) {
+        preference_motor_direction = 1;
+      } else {
+        preference_motor_direction = -1;
+      }
+      preferences.putLong64("motor_dir", preference_motor_direction);
+      changed = scale;
+      break;
+    case 4:
+      preference_sensor_tool_length_height += (float)encoder_steps / 10;
+      preferences.putFloat("tlsensor_height", preference_sensor_tool_length_height);
+      break;
+    case 5:
+      preference_motor_thread_pitch += (float)encoder_steps / 10;
+      if (preference_motor_thread_pitch < 0) {
+        preference_motor_thread_pitch = 0;
+      }
+      preferences.putFloat("thread_pitch", preference_motor_thread_pitch);
+      changed = scale;
+      break;
+    case 6:
+      preference_motor_steps_slow += encoder_steps * round(ENCODER_SLOW_DISTANCE / mm_per_step());
+      if (preference_motor_steps_slow < default_motor_steps_slow) {
+        preference_motor_steps_slow = default_motor_steps_slow;
+      }
+      preferences.putLong64("steps_slow", preference_motor_steps_slow);
+      break;
+    case 7:
+      preference_motor_steps_fast += encoder_steps * round(ENCODER_FAST_DISTANCE / mm_per_step());
+      if (preference_motor_steps_fast < default_motor_steps_fast) {
+        preference_motor_steps_fast = default_motor_steps_fast;
+      }
+      preferences.putLong64("steps_fast", preference_motor_steps_fast);
+      break;
+    case 8:
+      preference_motor_speed_toolchange += encoder_steps * 10;
+      if (preference_motor_speed_toolchange < 0) {
+        preference_motor_speed_toolchange = 0;
+      }
+      preferences.putLong64("speed_toolch", preference_motor_speed_toolchange);
+      break;
+    case 9:
+      preference_auto_zero_speed += encoder_steps * 10;
+      if (preference_auto_zero_speed < 0) {
+        preference_auto_zero_speed = 0;
+      }
+      preferences.putLong64("auto_zero_speed", preference_auto_zero_speed);
+      break;
+    case 10:
+      preference_workspace_height += (float)encoder_steps / 10;
+      if (preference_workspace_height < 0) {
+        preference_workspace_height = 0;
+      }
+      preferences.putFloat("ws_height", preference_workspace_height);
+      break;
+    case 11:
+      preference_power_on_toolchange = !preference_power_on_toolchange;
+      preferences.putBool("pwr_on_toolch", preference_power_on_toolchange);
+      break;
+    case 12:
+      preference_sensor_tool_length_enabled_normally_closed = !preference_sensor_tool_length_enabled_normally_closed;
+      preferences.putBool("tlsensor_en_n_c", preference_sensor_tool_length_enabled_normally_closed);
+      update_input_inversion();
+      break;
+    case 13:
+      preference_sensor_tool_length_normally_closed = !preference_sensor_tool_length_normally_closed;
+      preferences.putBool("tlsensor_n_c", preference_sensor_tool_length_normally_closed);
+      update_input_inversion();
+      break;
+    case 14:
+      preference_sensor_end_stop_normally_closed = !preference_sensor_end_stop_normally_closed;
+      preferences.putBool("end_stop_n_c", preference_sensor_end_stop_normally_closed);
+      update_input_inversion();
+      break;
+    case 15:
+      preference_tool_table_enabled = !preference_tool_table_enabled;
+      preferences.putBool("tool_table", preference_tool_table_enabled);
+      break;
+    case 16:
+      preference_tool_verify_enabled = !preference_tool_verify_enabled;
+      preferences.putBool("tool_verify", preference_tool_verify_enabled);
+      break;
+    case 17:
+      preference_sensor_end_stop_filter = ((preference_sensor_end_stop_filter + encoder_steps) % SENSOR_FILTER_SETTINGS_COUNT + SENSOR_FILTER_SETTINGS_COUNT) % SENSOR_FILTER_SETTINGS_COUNT;
+      preferences.putLong64("end_stop_filter", preference_sensor_end_stop_filter);
+      update_sensor_filters();
+      break;
+    case 18:
+      preference_sensor_tool_length_filter = ((preference_sensor_tool_length_filter + encoder_steps) % SENSOR_FILTER_SETTINGS_COUNT + SENSOR_FILTER_SETTINGS_COUNT) % SENSOR_FILTER_SETTINGS_COUNT;
+      preferences.putLong64("tlsensor_filter", preference_sensor_tool_length_filter);
+      update_sensor_filters();
+      break;
+    case 19:
+      preference_work_offset_slot = ((preference_work_offset_slot + encoder_steps) % WORK_OFFSETS_COUNT + WORK_OFFSETS_COUNT) % WORK_OFFSETS_COUNT;
+      preferences.putLong64("work_slot", preference_work_offset_slot);
+      break;
+    case 20:
+      preference_work_offsets[preference_work_offset_slot] += encoder_steps * ENCODER_SLOW_DISTANCE;
+      preferences.putFloat(work_key(preference_work_offset_slot), preference_work_offsets[preference_work_offset_slot]);
+      break;
+    case 21:
+      change_pass_step(encoder_steps);
+      save_pass_step();
+      break;
+    case 22:
+      preference_backlash += encoder_steps;
+      if (preference_backlash < 0) {
+        preference_backlash = 0;
+      }
+      preferences.putLong64("backlash", preference_backlash);
+      changed = setting_group_backlash;
+      break;
+    case 23:
+      preference_approach_from_below = !preference_approach_from_below;
+      preferences.putBool("approach_below", preference_approach_from_below);
+      changed = setting_group_backlash;
+      break;
+    case 24:
+      preference_pitch_point = ((preference_pitch_point + encoder_steps) % PITCH_TABLE_POINTS + PITCH_TABLE_POINTS) % PITCH_TABLE_POINTS;
+      preferences.putLong64("pitch_point", preference_pitch_point);
+      break;
+    case 25:
+      preference_pitch_errors[preference_pitch_point] = limit_pitch_error(preference_pitch_errors[preference_pitch_point] + encoder_steps * PITCH_ERROR_DISTANCE);
+      preferences.putFloat(pitch_key(preference_pitch_point), preference_pitch_errors[preference_pitch_point]);
+      changed = setting_group_pitch_table;
+      break;
+    case 26:
+      preference_resonance_band = ((preference_resonance_band + encoder_steps) % RESONANCE_BANDS_COUNT + RESONANCE_BANDS_COUNT) % RESONANCE_BANDS_COUNT;
+      preferences.putLong64("res_band", preference_resonance_band);
+      break;
+    case 27: {
+      // the upper speed follows, a band never turns inside out
+      long band = preference_resonance_band;
+      preference_resonance_lower[band] = max(0L, preference_resonance_lower[band] + encoder_steps * 10);
+      preference_resonance_upper[band] = max(preference_resonance_upper[band], preference_resonance_lower[band]);
+      preferences.putLong64(resonance_lower_key(band), preference_resonance_lower[band]);
+      preferences.putLong64(resonance_upper_key(band), preference_resonance_upper[band]);
+      changed = setting_group_profile;
+      break;
+    }
+    case 28: {
+      long band = preference_resonance_band;
+      preference_resonance_upper[band] = max(preference_resonance_lower[band], preference_resonance_upper[band] + encoder_steps * 10);
+      preferences.putLong64(resonance_upper_key(band), preference_resonance_upper[band]);
+      changed = setting_group_profile;
+      break;
+    }
+    case 29:
+      change_feed_rate(encoder_steps);
+      save_feed_rate();
+      break;
+    default:
+      Serial.printf("invalid menu page number: %ld\n", page);
+  }
+  return changed;
+}
+// SETTINGS END
+
+// TOOL TABLE START
+bool is_tool_known(long slot) {
+  return preference_tool_offsets[slot] != TOOL_OFFSET_UNKNOWN;
+}
+
+void store_tool_offset(long slot, long offset) {
+  preference_tool_offsets[slot] = offset;
+  preferences.putLong64(tool_key(slot), offset);
+  Serial.printf("tool %ld offset: %ld\n", slot + 1, offset);
+}
+
+void forget_tool(long slot) {
+  preference_tool_offsets[slot] = TOOL_OFFSET_UNKNOWN;
+  preferences.remove(tool_key(slot));
+}
+// TOOL TABLE END
+
+// PRESETS START
+bool is_preset_stored(long slot) {
+  return !isnan(preference_presets[slot]);
+}
+
+void store_preset(long slot, float height) {
+  preference_presets[slot] = height;
+  preferences.putFloat(preset_key(slot), height);
+  Serial.printf("preset %ld: %.2f mm\n", slot + 1, height);
+}
+// PRESETS END
+
+// DEPTH PASSES START
+// never below one encoder step, a pass has to move the bit
+void change_pass_step(long encoder_steps) {
+  preference_pass_step += encoder_steps * PASS_STEP_DISTANCE;
+  if (preference_pass_step < PASS_STEP_DISTANCE) {
+    preference_pass_step = PASS_STEP_DISTANCE;
+  }
+  Serial.printf("pass step: %.2f mm\n", preference_pass_step);
+}
+
+void save_pass_step() {
+  preferences.putFloat("pass_step", preference_pass_step);
+}
+// DEPTH PASSES END
+
+// FEED PLUNGE START
+// never below one encoder step, the override scales it down further
+void change_feed_rate(long encoder_steps) {
+  preference_feed_rate += encoder_steps * FEED_RATE_DISTANCE;
+  if (preference_feed_rate < FEED_RATE_DISTANCE) {
+    preference_feed_rate = FEED_RATE_DISTANCE;
+  }
+  Serial.printf("feed rate: %ld mm/min\n", preference_feed_rate);
+}
+
+void save_feed_rate() {
+  preferences.putLong64("feed_rate", preference_feed_rate);
+}
+// FEED PLUNGE END
+
+// PITCH TABLE START
+bool is_pitch_table_empty() {
+  for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+    if (preference_pitch_errors[point] != 0.0) {
+      return false;
+    }
+  }
+  return true;
+}
+// PITCH TABLE END
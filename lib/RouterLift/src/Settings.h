@@ -0,0 +1,173 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <limits.h>
+
+// microstepping of the driver the settings start with, -DDEFAULT_STEPS_PER_REVOLUTION=1600 for the prototype
+#ifndef DEFAULT_STEPS_PER_REVOLUTION
+#define DEFAULT_STEPS_PER_REVOLUTION 400 // [steps per revolution]
+#endif
+
+#define ENCODER_SLOW_DISTANCE 0.05 // [mm per encoder step]
+#define ENCODER_FAST_DISTANCE 1.0 // [mm per encoder step]
+
+#define SETTINGS_PAGES_COUNT 30
+
+#define TOOL_SLOTS_COUNT    8
+#define TOOL_OFFSET_UNKNOWN LONG_MIN // slot without a measurement
+
+#define WORK_OFFSETS_COUNT 6 // G54 to G59
+
+#define PRESET_SLOTS_COUNT 4
+
+#define PASS_STEP_DISTANCE 0.1 // [mm per encoder step] of the depth pass increment
+
+#define FEED_RATE_DISTANCE 10 // [mm per minute per encoder step]
+
+#define PITCH_TABLE_POINTS   15   // below the end stop, which references the position and has no error
+#define PITCH_TABLE_SPACING  5.0  // [mm] between two points, the first one is that far below the end stop
+#define PITCH_ERROR_DISTANCE 0.01 // [mm per encoder step]
+#define PITCH_ERROR_MAXIMAL  1.0  // [mm] either way, keeps the compensated travel going the way the motor turns
+
+#define RESONANCE_BANDS_COUNT 2
+
+extern Preferences preferences;
+
+// PREFERENCE VALUES START
+extern long  default_motor_steps_per_revolution; // [steps per revolution]
+extern float default_motor_thread_pitch;         // [mm per revolution]
+extern long  default_motor_steps_slow;           // [steps per encoder step]
+extern long  default_motor_steps_fast;           // [steps per encoder step]
+extern long  default_motor_direction;            // [-1 or 1]
+extern long  default_motor_speed_maximal;        // [steps per second]
+extern long  default_motor_speed_toolchange;     // [steps per second]
+extern long  default_motor_acceleration;         // [steps per second per second]
+
+extern bool  default_sensor_end_stop_normally_closed;
+extern long  default_sensor_end_stop_filter; // index into sensor_filter_settings
+
+extern bool  default_sensor_tool_length_enabled_normally_closed;
+extern bool  default_sensor_tool_length_normally_closed;
+extern float default_sensor_tool_length_height; // mm
+extern long  default_sensor_tool_length_filter; // index into sensor_filter_settings
+
+extern float default_workspace_height; // mm
+
+extern bool  default_power_on_toolchange;
+
+extern long  default_auto_zero_speed; // [steps per second]
+
+extern bool  default_tool_table_enabled;
+extern bool  default_tool_verify_enabled;
+
+extern float default_pass_step; // mm
+
+extern long  default_feed_rate; // [mm per minute]
+
+extern long  default_backlash; // [steps]
+extern bool  default_approach_from_below;
+
+// only written by the control task
+extern long  preference_motor_steps_per_revolution; // [steps per revolution]
+extern float preference_motor_thread_pitch;         // [mm per revolution]
+extern long  preference_motor_steps_slow;           // [steps per encoder step]
+extern long  preference_motor_steps_fast;           // [steps per encoder step]
+extern long  preference_motor_direction;            // [-1 or 1]
+extern long  preference_motor_speed_maximal;        // [steps per second]
+extern long  preference_motor_speed_toolchange;     // [steps per second]
+extern long  preference_motor_acceleration;         // [steps per second per second]
+
+extern bool  preference_sensor_end_stop_normally_closed;
+extern long  preference_sensor_end_stop_filter;
+extern bool  preference_sensor_tool_length_enabled_normally_closed;
+extern bool  preference_sensor_tool_length_normally_closed;
+extern float preference_sensor_tool_length_height; // mm
+extern long  preference_sensor_tool_length_filter;
+
+extern float preference_workspace_height; // mm
+
+extern bool  preference_power_on_toolchange;
+
+extern long  preference_auto_zero_speed; // [steps per second]
+
+extern bool  preference_tool_table_enabled;  // pick a tool after every toolchange
+extern bool  preference_tool_verify_enabled; // probe a known tool anyway and check its offset
+extern long  preference_tool_offsets[TOOL_SLOTS_COUNT]; // [steps] from where the end stop triggered to the zero of the tool
+
+extern long  preference_work_offset_slot; // 0 is G54
+extern float preference_work_offsets[WORK_OFFSETS_COUNT]; // mm of the work zero above the zero of the tool
+
+extern float preference_presets[PRESET_SLOTS_COUNT]; // mm above the work zero, NAN for a slot never stored
+
+extern float preference_pass_step; // mm the bit goes up per depth pass
+
+extern long  preference_feed_rate; // [mm per minute] the bit goes up to the target with in a feed plunge
+
+extern long  preference_backlash; // [steps] of lead screw play, taken up on every reversal
+extern bool  preference_approach_from_below; // every move ends going up
+
+extern long  preference_pitch_point; // shown on the settings page of the pitch error
+extern float preference_pitch_errors[PITCH_TABLE_POINTS]; // mm the carriage is further down than the steps say, (point + 1) * PITCH_TABLE_SPACING below the end stop
+
+extern long  preference_resonance_band; // shown on the settings pages of the band limits
+extern long  preference_resonance_lower[RESONANCE_BANDS_COUNT]; // [steps per second] the motor loses steps in between, never above the upper speed
+extern long  preference_resonance_upper[RESONANCE_BANDS_COUNT]; // [steps per second] a band of equal speeds is off
+// PREFERENCE VALUES END
+
+// COMPUTED VALUES START
+float mm_per_step();
+float position_in_mm(long position);
+long  work_offset_in_steps(); // of the selected slot, from the zero of the tool
+// [steps per second] speed moved out of the resonance bands to the slower edge, or the faster one of a band
+// starting at standstill as long as that is not above the maximal speed, sign kept; constant speeds and the
+// cruise of moves never stay inside a band, ramps still go through one at the acceleration of the profile
+float resonance_free_speed(float speed);
+// COMPUTED VALUES END
+
+// SETTINGS START
+// what the motion task holds of the settings, as bits
+enum setting_groups {
+  setting_group_none        = 0,
+  setting_group_backlash    = 1 << 0, // backlash and approach from below
+  setting_group_pitch_table = 1 << 1,
+  setting_group_profile     = 1 << 2, // maximal speed, acceleration and the resonance bands
+  setting_group_all         = setting_group_backlash | setting_group_pitch_table | setting_group_profile
+};
+
+void read_settings();
+void reset_settings_to_default();
+
+// encoder steps turned on a page of the settings menu, returns the setting_groups it changed
+int change_setting(long page, long encoder_steps);
+// SETTINGS END
+
+// TOOL TABLE START
+bool is_tool_known(long slot);
+void store_tool_offset(long slot, long offset);
+void forget_tool(long slot);
+// TOOL TABLE END
+
+// PRESETS START
+bool is_preset_stored(long slot);
+void store_preset(long slot, float height);
+// PRESETS END
+
+// DEPTH PASSES START
+// in memory only, save_pass_step() keeps it
+void change_pass_step(long encoder_steps);
+void save_pass_step();
+// DEPTH PASSES END
+
+// FEED PLUNGE START
+// in memory only, save_feed_rate() keeps it
+void change_feed_rate(long encoder_steps);
+void save_feed_rate();
+// FEED PLUNGE END
+
+// PITCH TABLE START
+bool is_pitch_table_empty(); // a perfect screw
+// PITCH TABLE END
+
+#endif // SETTINGS_H
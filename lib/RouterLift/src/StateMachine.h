@@ -0,0 +1,176 @@
+#ifndef STATE_MACHINE_H
+#define STATE_MACHINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// STATE MACHINE STUFF START
+enum states {
+  default_start,
+  goto_tool_length_sensor,
+  finish_tool_length_sensor,
+  goto_toolchange,
+  finish_toolchange,
+  select_tool,
+  depth_passes,
+  feed_plunge,
+  settings_menu,
+  reset,
+  error,
+  states_count
+};
+
+enum events {
+  event_none,
+  event_toolchange_press,
+  event_set_zero_press,
+  event_set_zero_hold,
+  event_goto_bottom_press,
+  event_goto_bottom_hold,
+  event_pass_start,
+  event_feed_start,
+  event_end_stop_trigger,
+  event_tool_length_trigger,
+  event_target_reached,
+  event_done,
+  event_fault,
+  events_count
+};
+
+// target of a transition that only runs its action and keeps the state (no exit/entry)
+#define STATE_UNCHANGED states_count
+
+struct state_handlers {
+  enum states state;
+  const char *name;
+  bool (*entry)();       // returning false aborts the transition into the error state
+  void (*exit)();
+  enum events (*tick)(); // called every loop, returns the event to dispatch
+  unsigned long minimum_duration; // [ms] state changes are held back until the state was shown this long
+};
+
+struct transition {
+  enum states from;
+  enum events event;
+  bool (*guard)();       // nullptr always passes
+  void (*action)();      // runs after exit of from and before entry of to
+  enum states to;
+};
+
+// rows of the transition table belonging to one (state, event) cell, tried in order until a guard passes
+struct transition_range {
+  uint8_t first;
+  uint8_t count;
+};
+
+struct transition_index {
+  transition_range cell[states_count][events_count];
+};
+// STATE MACHINE STUFF END
+
+extern enum states current_state;
+extern unsigned long current_state_entered_at; // [ms]
+
+// TRANSITION TABLE CHECKS START
+// all of these run at compile time, see the static_asserts next to the tables
+
+template <size_t N>
+constexpr transition_index index_transitions(const transition (&table)[N]) {
+  transition_index index{};
+  for (size_t row = N; row-- > 0;) {
+    transition_range &range = index.cell[table[row].from][table[row].event];
+    range.first = row;
+    range.count++;
+  }
+  return index;
+}
+
+template <size_t N>
+constexpr bool state_handlers_are_in_order(const state_handlers (&table)[N]) {
+  for (size_t state = 0; state < N; state++) {
+    if (table[state].state != state || table[state].tick == nullptr) {
+      return false;
+    }
+  }
+  return N == states_count;
+}
+
+// rows of one cell have to be adjacent, otherwise index_transitions would skip some
+template <size_t N>
+constexpr bool transitions_are_sorted(const transition (&table)[N]) {
+  for (size_t row = 1; row < N; row++) {
+    if (table[row].from < table[row - 1].from
+        || (table[row].from == table[row - 1].from && table[row].event < table[row - 1].event)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t N>
+constexpr bool transitions_are_valid(const transition (&table)[N]) {
+  for (size_t row = 0; row < N; row++) {
+    if (table[row].from >= states_count
+        || table[row].to > STATE_UNCHANGED
+        || table[row].event == event_none
+        || table[row].event >= events_count
+        || (table[row].to == STATE_UNCHANGED && table[row].action == nullptr)) {
+      return false;
+    }
+  }
+  return N < UINT8_MAX;
+}
+
+// an unguarded row hides every row after it in the same cell
+template <size_t N>
+constexpr bool transitions_are_reachable(const transition (&table)[N]) {
+  for (size_t row = 1; row < N; row++) {
+    if (table[row].from == table[row - 1].from
+        && table[row].event == table[row - 1].event
+        && table[row - 1].guard == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t N>
+constexpr bool has_transition(const transition (&table)[N], enum states from, enum events event, enum states to) {
+  for (size_t row = 0; row < N; row++) {
+    if (table[row].from == from && table[row].event == event && table[row].to == to) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// every state but error has to fall into error on a fault
+template <size_t N>
+constexpr bool faults_lead_to_error(const transition (&table)[N]) {
+  for (size_t state = 0; state < states_count; state++) {
+    if (state != error && !has_transition(table, (enum states)state, event_fault, error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// every state has a way to another state, so the machine cannot get stuck
+template <size_t N>
+constexpr bool states_can_be_left(const transition (&table)[N]) {
+  for (size_t state = 0; state < states_count; state++) {
+    bool can_be_left = false;
+    for (size_t row = 0; row < N; row++) {
+      if (table[row].from == state && table[row].to != state && table[row].to != STATE_UNCHANGED) {
+        can_be_left = true;
+      }
+    }
+    if (!can_be_left) {
+      return false;
+    }
+  }
+  return true;
+}
+// TRANSITION TABLE CHECKS END
+
+#endif // STATE_MACHINE_H
@@ -0,0 +1,100 @@
+#ifndef STEPPER_DRIVER_H
+#define STEPPER_DRIVER_H
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+#include <limits.h>
+
+// STEPPER DRIVER START
+// What the motion task needs from a stepper, resolved at compile time: an engine derives from
+// stepper_driver<engine> and implements the engine_* functions, every call below inlines into
+// the caller, so there is no virtual call between the motion tick and the engine.
+//
+// Positions are in steps, speeds in steps per second, accelerations in steps per second per second.
+// A positive speed steps towards larger positions.
+template <typename engine>
+class stepper_driver {
+  public:
+    __attribute__((always_inline)) inline long  position()       { return self().engine_position(); }
+    __attribute__((always_inline)) inline long  target()         { return self().engine_target(); }
+    __attribute__((always_inline)) inline float speed()          { return self().engine_speed(); }
+    __attribute__((always_inline)) inline long  distance_to_go() { return target() - position(); }
+    // moving or not yet at the target
+    __attribute__((always_inline)) inline bool  is_running()     { return speed() != 0.0 || distance_to_go() != 0; }
+
+    // accelerated moves, relative and absolute
+    __attribute__((always_inline)) inline void move(long distance)  { self().engine_move_to(position() + distance); }
+    __attribute__((always_inline)) inline void move_to(long target) { self().engine_move_to(target); }
+    // constant speed for run_speed_tick(), clamped to the maximal speed
+    __attribute__((always_inline)) inline void set_speed(float speed) { self().engine_set_speed(speed); }
+    // redefines where the motor stands, drops speed and target
+    __attribute__((always_inline)) inline void set_position(long position) { self().engine_set_position(position); }
+    __attribute__((always_inline)) inline void set_profile(float maximal_speed, float acceleration) {
+      self().engine_set_profile(maximal_speed, acceleration);
+    }
+    // stops on the spot, no slowing down
+    __attribute__((always_inline)) inline void halt() {
+      set_speed(0);
+      move(0);
+    }
+
+    // one step chance of the motion task: steps when due and returns whether the move goes on
+    __attribute__((always_inline)) inline bool run_tick()       { return self().engine_run_tick(); }
+    // same at constant speed, returns whether it stepped
+    __attribute__((always_inline)) inline bool run_speed_tick() { return self().engine_run_speed_tick(); }
+
+    // engines stepping on their own between ticks never step out of [lower, upper]
+    __attribute__((always_inline)) inline void set_step_window(long lower, long upper) {
+      self().engine_set_step_window(lower, upper);
+    }
+    // once from setup, on the core of the motion task
+    __attribute__((always_inline)) inline void begin() { self().engine_begin(); }
+
+  protected:
+    // engines stepping only inside run_tick() have nothing to set up or guard
+    void engine_begin() {}
+    void engine_set_step_window(long lower, long upper) {}
+
+  private:
+    __attribute__((always_inline)) inline engine &self() { return static_cast<engine &>(*this); }
+};
+// STEPPER DRIVER END
+
+// ACCELSTEPPER ENGINE START
+// any AccelStepper writing the pins in its own way, board_stepper, digital_write_stepper or simulated_stepper
+template <typename accel_stepper>
+class accel_stepper_engine : public stepper_driver<accel_stepper_engine<accel_stepper>> {
+  friend class stepper_driver<accel_stepper_engine<accel_stepper>>;
+
+  public:
+    accel_stepper &library() { return motor; }
+
+  protected:
+    long  engine_position() { return motor.currentPosition(); }
+    long  engine_target()   { return motor.targetPosition(); }
+    float engine_speed()    { return motor.speed(); }
+    void  engine_move_to(long target)       { motor.moveTo(target); }
+    void  engine_set_speed(float speed)     { motor.setSpeed(speed); }
+    void  engine_set_position(long position) { motor.setCurrentPosition(position); }
+    void  engine_set_profile(float maximal_speed, float acceleration) {
+      motor.setMaxSpeed(maximal_speed);
+      motor.setAcceleration(acceleration);
+    }
+    bool  engine_run_tick()       { return motor.run(); }
+    bool  engine_run_speed_tick() { return motor.runSpeed(); }
+
+  private:
+    accel_stepper motor;
+};
+
+// the AccelStepper profile without pins, for the simulations and the driver benchmark
+class simulated_stepper : public AccelStepper {
+  public:
+    simulated_stepper() : AccelStepper(AccelStepper::DRIVER, 0xff, 0xff, 0xff, 0xff, false) {}
+
+  protected:
+    void step(long step) override {}
+};
+// ACCELSTEPPER ENGINE END
+
+#endif // STEPPER_DRIVER_H
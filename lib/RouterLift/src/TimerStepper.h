@@ -0,0 +1,339 @@
+#ifndef TIMER_STEPPER_H
+#define TIMER_STEPPER_H
+
+#include <Arduino.h>
+#include <soc/soc.h>
+#include <soc/timer_group_reg.h>
+#include "StepperDriver.h"
+
+#define TIMER_STEPPER_TIMER     0
+#define TIMER_STEPPER_DIVIDER   8        // APB clock to 10 MHz, alarms are in [counts]
+#define TIMER_STEPPER_FREQUENCY 10000000 // [counts per second]
+#define TIMER_STEPPER_PULSE     20       // [counts] STEP stays high 2 us, drivers want at least 1.9 us
+#define TIMER_STEPPER_INTERVAL_MAXIMAL (INT32_MAX / 4) // [counts] the integer profile doubles it
+
+#define TIMER_INLINE inline __attribute__((always_inline))
+
+// TIMER ALARM START
+// The alarm of TIMER_STEPPER_TIMER through its registers, like Gpio.h does for pins: the timer
+// functions of the Arduino core are in flash, these inline into the interrupt. The Arduino core
+// enables an autoreload alarm again before it calls the interrupt, so disabling it there sticks.
+struct timer_stepper_alarm {
+  static_assert(TIMER_STEPPER_TIMER == 0, "the registers below are those of timer 0 of group 0");
+
+  // counted from the last alarm, the counter reloads to zero on each
+  static TIMER_INLINE void write(uint32_t counts) {
+    REG_WRITE(TIMG_T0ALARMHI_REG(0), 0);
+    REG_WRITE(TIMG_T0ALARMLO_REG(0), counts);
+  }
+
+  static TIMER_INLINE void enable() {
+    REG_WRITE(TIMG_T0CONFIG_REG(0), REG_READ(TIMG_T0CONFIG_REG(0)) | TIMG_T0_ALARM_EN);
+  }
+
+  static TIMER_INLINE void disable() {
+    REG_WRITE(TIMG_T0CONFIG_REG(0), REG_READ(TIMG_T0CONFIG_REG(0)) & ~TIMG_T0_ALARM_EN);
+  }
+};
+// TIMER ALARM END
+
+// TIMER ENGINE START
+// Steps from a hardware timer interrupt instead of the motion tick, so the step timing does not
+// depend on how long a tick takes. The interrupt runs the AccelStepper profile (D. Austin,
+// "Generate stepper-motor speed profiles in real time") in integers, with the remainder of the
+// division carried from step to step like AVR446 does: on the ESP32 an interrupt must not use
+// the FPU and doubles are emulated in flash. Floats only appear on the task side, where speeds
+// and accelerations come in. The motion task still checks sensors and limits every tick and
+// halts; in between the step window keeps the interrupt inside the workspace.
+//
+// Every step takes two alarms: the first raises STEP, the second lowers it TIMER_STEPPER_PULSE
+// later and waits out the rest of the interval, so the interrupt never busy waits.
+//
+// The state is shared with the interrupt, the task side takes the lock for every access.
+template <typename step_output, typename direction_output>
+class timer_stepper_engine : public stepper_driver<timer_stepper_engine<step_output, direction_output>> {
+  friend class stepper_driver<timer_stepper_engine<step_output, direction_output>>;
+
+  public:
+    // only one engine can own the timer
+    timer_stepper_engine() { instance = this; }
+
+  protected:
+    void engine_begin() {
+      // the interrupt is allocated on the calling core, the alarm reloads and stays off until a move
+      timer = timerBegin(TIMER_STEPPER_TIMER, TIMER_STEPPER_DIVIDER, true);
+      timerAttachInterrupt(timer, on_alarm, true);
+      timerAlarmWrite(timer, TIMER_STEPPER_INTERVAL_MAXIMAL, true);
+    }
+
+    long engine_position() {
+      portENTER_CRITICAL(&lock);
+      long value = current_position;
+      portEXIT_CRITICAL(&lock);
+      return value;
+    }
+
+    long engine_target() {
+      portENTER_CRITICAL(&lock);
+      long value = target_position;
+      portEXIT_CRITICAL(&lock);
+      return value;
+    }
+
+    float engine_speed() {
+      portENTER_CRITICAL(&lock);
+      uint32_t counts = interval;
+      bool upwards    = clockwise;
+      portEXIT_CRITICAL(&lock);
+      return counts == 0 ? 0.0 : (upwards ? 1.0 : -1.0) * TIMER_STEPPER_FREQUENCY / counts;
+    }
+
+    void engine_move_to(long position) {
+      portENTER_CRITICAL(&lock);
+      accelerating = true;
+      if (target_position != position) {
+        target_position = position;
+        compute_new_speed();
+        retime();
+      }
+      portEXIT_CRITICAL(&lock);
+    }
+
+    void engine_set_speed(float value) {
+      value = constrain(value, -maximal_speed, maximal_speed);
+      uint32_t counts = value == 0.0 ? 0 : max(counts_of(fabs(TIMER_STEPPER_FREQUENCY / value)), minimal_interval);
+      portENTER_CRITICAL(&lock);
+      // the interrupt may come before the next tick, it must not fall back to the profile
+      accelerating = false;
+      if (counts != interval || (counts != 0 && clockwise != (value > 0.0))) {
+        interval = counts;
+        if (counts != 0) {
+          clockwise = value > 0.0;
+        }
+        retime();
+      }
+      portEXIT_CRITICAL(&lock);
+    }
+
+    void engine_set_position(long position) {
+      portENTER_CRITICAL(&lock);
+      target_position = current_position = position;
+      n        = 0;
+      interval = 0;
+      rest     = 0;
+      retime();
+      portEXIT_CRITICAL(&lock);
+    }
+
+    void engine_set_profile(float new_maximal_speed, float new_acceleration) {
+      new_maximal_speed = fabs(new_maximal_speed);
+      new_acceleration  = fabs(new_acceleration);
+      float speed = engine_speed();
+      portENTER_CRITICAL(&lock);
+      if (maximal_speed != new_maximal_speed) {
+        maximal_speed    = new_maximal_speed;
+        minimal_interval = max(counts_of(TIMER_STEPPER_FREQUENCY / new_maximal_speed), (uint32_t)(2 * TIMER_STEPPER_PULSE));
+        cruise_steps     = (long)((maximal_speed * maximal_speed) / (2.0 * acceleration));
+        if (n > 0) {
+          // recompute where slowing down starts
+          n = (long)((speed * speed) / (2.0 * acceleration));
+          compute_new_speed();
+        }
+      }
+      if (new_acceleration != 0.0 && acceleration != new_acceleration) {
+        n = n * (acceleration / new_acceleration);
+        // equation 15 with the 0.676 correction of equation 7
+        first_interval = counts_of(0.676 * sqrt(2.0 / new_acceleration) * TIMER_STEPPER_FREQUENCY);
+        acceleration   = new_acceleration;
+        cruise_steps   = (long)((maximal_speed * maximal_speed) / (2.0 * acceleration));
+        compute_new_speed();
+      }
+      retime();
+      portEXIT_CRITICAL(&lock);
+    }
+
+    bool engine_run_tick() {
+      portENTER_CRITICAL(&lock);
+      accelerating = true;
+      arm();
+      bool running = interval != 0 || target_position != current_position;
+      portEXIT_CRITICAL(&lock);
+      return running;
+    }
+
+    bool engine_run_speed_tick() {
+      portENTER_CRITICAL(&lock);
+      accelerating = false;
+      arm();
+      bool stepped = stepped_since_tick;
+      stepped_since_tick = false;
+      portEXIT_CRITICAL(&lock);
+      return stepped;
+    }
+
+    void engine_set_step_window(long lower, long upper) {
+      portENTER_CRITICAL(&lock);
+      window_lower = lower;
+      window_upper = upper;
+      portEXIT_CRITICAL(&lock);
+    }
+
+  private:
+    static IRAM_ATTR void on_alarm() {
+      instance->step_interrupt();
+    }
+
+    // task side, an interval that fits the integer profile
+    static uint32_t counts_of(float interval) {
+      return (uint32_t)constrain(interval, 1.0f, (float)TIMER_STEPPER_INTERVAL_MAXIMAL);
+    }
+
+    void IRAM_ATTR step_interrupt() {
+      portENTER_CRITICAL_ISR(&lock);
+      if (pulsing) {
+        step_output::write(false);
+        pulsing = false;
+      } else {
+        long next = current_position + (clockwise ? 1 : -1);
+        if (interval == 0 || next < window_lower || next > window_upper) {
+          // the motion task sees the motor standing and stops the move
+          interval = 0;
+          n        = 0;
+        } else {
+          direction_output::write(clockwise);
+          step_output::write(true);
+          pulsing = true;
+          current_position = next;
+          stepped_since_tick = true;
+          if (accelerating) {
+            compute_new_speed();
+          }
+        }
+      }
+      if (pulsing) {
+        timer_stepper_alarm::write(TIMER_STEPPER_PULSE);
+      } else if (interval == 0) {
+        timer_stepper_alarm::disable();
+        armed = false;
+      } else {
+        timer_stepper_alarm::write(interval - TIMER_STEPPER_PULSE);
+      }
+      portEXIT_CRITICAL_ISR(&lock);
+    }
+
+    // the counter runs on from the end of the last pulse, so the first step comes one interval
+    // after the last one or right away, like in AccelStepper::runSpeed()
+    void arm() {
+      if (!armed && interval != 0 && timer) {
+        timer_stepper_alarm::write(interval - TIMER_STEPPER_PULSE);
+        timer_stepper_alarm::enable();
+        armed = true;
+      }
+    }
+
+    // the next step comes the new interval after the last one, like in AccelStepper::runSpeed(),
+    // right away when that is already over; during a pulse its end picks the interval up
+    void retime() {
+      if (!armed || pulsing) {
+        return;
+      }
+      if (interval == 0) {
+        timer_stepper_alarm::disable();
+        armed = false;
+      } else {
+        timer_stepper_alarm::write(interval - TIMER_STEPPER_PULSE);
+      }
+    }
+
+    // AccelStepper::computeNewSpeed() without floats: its speed * speed / (2 * acceleration) is one
+    // less than the step number while accelerating, at most that of the cruise, and minus the step
+    // number while slowing down
+    void IRAM_ATTR compute_new_speed() {
+      long distance = target_position - current_position;
+      long steps_to_stop = n > 0 ? min(n - 1, cruise_steps) : -n;
+
+      if (distance == 0 && steps_to_stop <= 1) {
+        // at the target and slow enough to stop
+        interval = 0;
+        n        = 0;
+        return;
+      }
+
+      long ramp_step = n;
+      if (distance > 0) {
+        if (n > 0) {
+          // accelerating, start slowing down when the target comes close or it runs the wrong way
+          if (steps_to_stop >= distance || !clockwise) {
+            n = -steps_to_stop;
+          }
+        } else if (n < 0) {
+          // slowing down, accelerate again when the target moved away
+          if (steps_to_stop < distance && clockwise) {
+            n = -n;
+          }
+        }
+      } else if (distance < 0) {
+        if (n > 0) {
+          if (steps_to_stop >= -distance || clockwise) {
+            n = -steps_to_stop;
+          }
+        } else if (n < 0) {
+          if (steps_to_stop < -distance && !clockwise) {
+            n = -n;
+          }
+        }
+      }
+      if (n != ramp_step) {
+        rest = 0;
+      }
+
+      if (n == 0) {
+        // first step from standstill
+        last_interval = first_interval;
+        rest          = 0;
+        clockwise     = distance > 0;
+      } else {
+        // equation 13, shorter while accelerating and longer while slowing down
+        int32_t divided = 2 * last_interval + rest;
+        int32_t divisor = 4 * n + 1;
+        last_interval -= divided / divisor;
+        rest           = divided % divisor;
+        if (last_interval < (int32_t)minimal_interval) {
+          last_interval = minimal_interval;
+          rest          = 0;
+        }
+      }
+      n++;
+      interval = last_interval;
+    }
+
+    static inline timer_stepper_engine *instance = nullptr;
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    hw_timer_t *timer = nullptr;
+    bool armed        = false;
+    bool pulsing      = false; // STEP is high, the next alarm ends the pulse
+    bool accelerating = false; // moves follow the profile, set_speed() and run_speed_tick() keep the speed
+    bool stepped_since_tick = false;
+
+    long  window_lower = LONG_MIN; // [steps]
+    long  window_upper = LONG_MAX; // [steps]
+
+    long  current_position = 0;    // [steps]
+    long  target_position  = 0;    // [steps]
+    bool  clockwise = false;       // towards larger positions
+    uint32_t interval = 0;         // [counts] between steps, 0 is standing
+    long  n = 0;                   // step number of the profile, negative while slowing down
+    int32_t last_interval = 0;     // [counts] of the profile
+    int32_t rest = 0;              // [counts] remainder of equation 13, carried to the next step
+    long  cruise_steps = 0;        // steps to stop from the maximal speed
+    uint32_t first_interval   = 0.676 * sqrt(2.0) * TIMER_STEPPER_FREQUENCY; // [counts] for an acceleration of 1
+    uint32_t minimal_interval = TIMER_STEPPER_FREQUENCY; // [counts] at maximal speed
+
+    // task side only
+    float maximal_speed = 1.0;     // [steps per second]
+    float acceleration  = 1.0;     // [steps per second per second]
+};
+// TIMER ENGINE END
+
+#endif // TIMER_STEPPER_H
@@ -0,0 +1,146 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+// Shared by the programs in sim/: boots the firmware against the lift plant
+// and drives its inputs. Every run gets its own child process, the firmware
+// keeps its state in globals and its tasks never end.
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "LiftPlant.h"
+#include "PinDefinitions.h"
+
+#define BUTTON_PRESS_DURATION 100   // [ms] shorter than DURATION_BUTTON_HOLD
+#define BUTTON_HOLD_DURATION  1000  // [ms] longer than DURATION_BUTTON_HOLD
+#define BOOT_DURATION         500   // [ms]
+#define SCENARIO_SLICE        10    // [ms] how often conditions are checked
+#define SCENARIO_TIMEOUT      60000 // [ms]
+#define INPUT_LATENCY         50    // [ms] inputs are collected between display frames, sending one takes about 26 ms
+
+// SIMULATION HELPERS START
+std::string serial_log;
+
+void log_serial(char character) {
+  serial_log += character;
+}
+
+float random_between(std::mt19937 &random_numbers, float low, float high) {
+  return std::uniform_real_distribution<float>(low, high)(random_numbers);
+}
+
+void press_button(uint8_t pin, unsigned long duration) {
+  hal_set_input(pin, LOW);
+  hal_run_for(duration * 1000);
+  hal_set_input(pin, HIGH);
+}
+
+// runs until the firmware printed text or the timeout is over
+bool wait_for(const char *text, unsigned long timeout) {
+  for (unsigned long waited = 0; waited < timeout; waited += SCENARIO_SLICE) {
+    if (serial_log.find(text) != std::string::npos) {
+      return true;
+    }
+    hal_run_for(SCENARIO_SLICE * 1000);
+  }
+  return serial_log.find(text) != std::string::npos;
+}
+
+void set_float_preference(const char *key, float value) {
+  Preferences preferences;
+  preferences.begin("settings", false);
+  preferences.putFloat(key, value);
+  preferences.end();
+}
+
+void set_bool_preference(const char *key, bool value) {
+  Preferences preferences;
+  preferences.begin("settings", false);
+  preferences.putBool(key, value);
+  preferences.end();
+}
+
+void set_long_preference(const char *key, int64_t value) {
+  Preferences preferences;
+  preferences.begin("settings", false);
+  preferences.putLong64(key, value);
+  preferences.end();
+}
+
+// plant with its defaults wired like the PCB
+plant_config lift_plant_config(uint32_t seed) {
+  plant_config plant = plant_default_config();
+  plant.seed          = seed;
+  plant.pin_step      = PIN_STEP;
+  plant.pin_direction = PIN_DIRECTION;
+  plant.pin_tool_length_enabled = PIN_SENSOR_TOOL_LENGTH_ENABLED;
+  plant.end_stop.pin            = PIN_SENSOR_END_STOP_TRIGGER;
+  plant.tool_length.pin         = PIN_SENSOR_TOOL_LENGTH_TRIGGER;
+  return plant;
+}
+
+// set preferences before, the firmware reads them while booting
+void boot_firmware(const plant_config &plant, uint32_t clock_read_cost, uint32_t gpio_cost = 0, uint32_t register_cost = 0) {
+  hal_set_serial_echo(getenv("SIM_ECHO") != NULL);
+  hal_on_serial_write(log_serial);
+  hal_set_clock_read_cost(clock_read_cost);
+  hal_set_gpio_cost(gpio_cost);
+  hal_set_register_cost(register_cost);
+  plant_begin(plant);
+  hal_begin();
+  hal_run_for(BOOT_DURATION * 1000);
+}
+// SIMULATION HELPERS END
+
+// CHILD RUNS START
+// results go back through a pipe, so they have to be plain structs
+template <typename result_type>
+struct child_run {
+  pid_t child;
+  int   channel;
+};
+
+template <typename result_type, typename run_function>
+child_run<result_type> start_child(run_function run) {
+  int channel[2];
+  if (pipe(channel)) {
+    return { -1, -1 };
+  }
+  fflush(stdout);
+  pid_t child = fork();
+  if (child == 0) {
+    close(channel[0]);
+    result_type found = {};
+    run(found);
+    fflush(stdout);
+    ssize_t written = write(channel[1], &found, sizeof(found));
+    _exit(written == sizeof(found) ? 0 : 1);
+  }
+  close(channel[1]);
+  return { child, channel[0] };
+}
+
+// returns false when the child crashed before it sent its result
+template <typename result_type>
+bool finish_child(const child_run<result_type> &run, result_type &result) {
+  result = {};
+  bool received = run.child > 0 && read(run.channel, &result, sizeof(result)) == sizeof(result);
+  if (run.channel >= 0) {
+    close(run.channel);
+  }
+  if (run.child > 0) {
+    waitpid(run.child, NULL, 0);
+  }
+  return received;
+}
+
+// as many runs at once as there are cores
+int parallel_children() {
+  return max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+}
+// CHILD RUNS END
+
+#endif // SIMULATION_H
@@ -0,0 +1,125 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Writes the framebuffer of the display as a black and white PNG, the same
+// buffer always gives the same bytes, so snapshots compare byte by byte.
+// The image data goes into stored deflate blocks, no compression library needed.
+
+#include <U8g2lib.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define SNAPSHOT_SCALE 2 // [pixels] per display pixel, easier to look at
+
+// CHECKSUMS START
+uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+uint32_t adler32(const std::vector<uint8_t> &data) {
+  uint32_t low = 1, high = 0;
+  for (uint8_t byte : data) {
+    low  = (low + byte) % 65521;
+    high = (high + low) % 65521;
+  }
+  return (high << 16) | low;
+}
+// CHECKSUMS END
+
+// PNG START
+void append_big_endian(std::vector<uint8_t> &bytes, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    bytes.push_back(value >> shift);
+  }
+}
+
+void append_chunk(std::vector<uint8_t> &png, const char *type, const std::vector<uint8_t> &data) {
+  append_big_endian(png, data.size());
+  size_t start = png.size();
+  png.insert(png.end(), type, type + 4);
+  png.insert(png.end(), data.begin(), data.end());
+  append_big_endian(png, crc32(&png[start], png.size() - start));
+}
+
+// lit pixels white on black like the OLED, one bit per pixel
+std::vector<uint8_t> encode_snapshot(U8G2 &display) {
+  uint32_t width  = display.getDisplayWidth() * SNAPSHOT_SCALE;
+  uint32_t height = display.getDisplayHeight() * SNAPSHOT_SCALE;
+  uint32_t row_bytes = (width + 7) / 8;
+
+  std::vector<uint8_t> rows;
+  for (uint32_t y = 0; y < height; y++) {
+    rows.push_back(0); // no filter
+    for (uint32_t byte = 0; byte < row_bytes; byte++) {
+      uint8_t packed = 0;
+      for (uint32_t bit = 0; bit < 8; bit++) {
+        uint32_t x = byte * 8 + bit;
+        if (x < width && display.getPixel(x / SNAPSHOT_SCALE, y / SNAPSHOT_SCALE)) {
+          packed |= 0x80 >> bit;
+        }
+      }
+      rows.push_back(packed);
+    }
+  }
+
+  // zlib stream of stored blocks
+  std::vector<uint8_t> image = { 0x78, 0x01 };
+  for (size_t start = 0; start < rows.size(); start += 65535) {
+    size_t length = min<size_t>(rows.size() - start, 65535);
+    image.push_back(start + length == rows.size());
+    image.push_back(length & 0xff);
+    image.push_back(length >> 8);
+    image.push_back(~length & 0xff);
+    image.push_back((~length >> 8) & 0xff);
+    image.insert(image.end(), rows.begin() + start, rows.begin() + start + length);
+  }
+  append_big_endian(image, adler32(rows));
+
+  std::vector<uint8_t> header;
+  append_big_endian(header, width);
+  append_big_endian(header, height);
+  header.insert(header.end(), { 1, 0, 0, 0, 0 }); // bit depth 1, grayscale, deflate, no filter, no interlace
+
+  std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  append_chunk(png, "IHDR", header);
+  append_chunk(png, "IDAT", image);
+  append_chunk(png, "IEND", {});
+  return png;
+}
+// PNG END
+
+// SNAPSHOT FILES START
+bool write_snapshot(const std::string &path, const std::vector<uint8_t> &png) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  fwrite(png.data(), 1, png.size(), file);
+  return fclose(file) == 0;
+}
+
+bool read_snapshot(const std::string &path, std::vector<uint8_t> &png) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  png.clear();
+  uint8_t chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    png.insert(png.end(), chunk, chunk + length);
+  }
+  fclose(file);
+  return true;
+}
+// SNAPSHOT FILES END
+
+#endif // SNAPSHOT_H
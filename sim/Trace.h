@@ -0,0 +1,226 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Records the STEP and DIR outputs of the firmware and the switches of the
+// lift plant as timestamped edges, compares them against golden traces and
+// writes them as VCD for GTKWave. Include after Simulation.h.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TRACE_TOLERANCE       20    // [us] an edge may move this much against the golden trace
+#define TRACE_TOLERANCE_DRIFT 0.001 // plus this share of the time since the trace started
+
+// TRACE VALUES START
+enum trace_signals {
+  trace_step,
+  trace_direction,
+  trace_end_stop,
+  trace_tool_length,
+  trace_signals_count
+};
+
+const char *trace_signal_names[trace_signals_count] = {
+  "step",
+  "dir",
+  "end_stop",
+  "tool_length",
+};
+
+struct trace_edge {
+  uint64_t at; // [ns] since the trace started
+  enum trace_signals signal;
+  uint8_t level;
+};
+
+struct trace_recording {
+  uint64_t started_at; // [ns] virtual time
+  uint8_t  levels[trace_signals_count];
+  uint8_t  initial_levels[trace_signals_count];
+  std::vector<trace_edge> edges;
+};
+
+trace_recording recording;
+// TRACE VALUES END
+
+// RECORDER START
+void record_edge(enum trace_signals signal, uint8_t level, uint64_t at) {
+  if (recording.levels[signal] == level) {
+    return;
+  }
+  recording.levels[signal] = level;
+  recording.edges.push_back({ at - recording.started_at, signal, level });
+}
+
+void record_pin_write(uint8_t pin, uint8_t level, uint64_t at) {
+  if (pin == PIN_STEP) {
+    record_edge(trace_step, level, at);
+  } else if (pin == PIN_DIRECTION) {
+    record_edge(trace_direction, level, at);
+  }
+}
+
+void record_switch(uint8_t pin, bool triggered, uint64_t at) {
+  if (pin == PIN_SENSOR_END_STOP_TRIGGER) {
+    record_edge(trace_end_stop, triggered, at);
+  } else if (pin == PIN_SENSOR_TOOL_LENGTH_TRIGGER) {
+    record_edge(trace_tool_length, triggered, at);
+  }
+}
+
+// starts at the current virtual time, call after the firmware booted
+void begin_trace() {
+  recording.started_at = hal_now_nano();
+  recording.levels[trace_step]        = hal_pin_level(PIN_STEP);
+  recording.levels[trace_direction]   = hal_pin_level(PIN_DIRECTION);
+  recording.levels[trace_end_stop]    = plant_status().end_stop_triggered;
+  recording.levels[trace_tool_length] = plant_status().tool_length_triggered;
+  memcpy(recording.initial_levels, recording.levels, sizeof(recording.levels));
+  recording.edges.clear();
+  hal_on_pin_write(record_pin_write);
+  plant_on_switch(record_switch);
+}
+// RECORDER END
+
+// TRACE FILES START
+// one edge per line: time in [us] since the start, signal name and level; # starts a comment
+bool write_trace(const char *path, const char *comment) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+  fprintf(file, "# %s\n", comment);
+  for (int signal = 0; signal < trace_signals_count; signal++) {
+    fprintf(file, "0 %s %u\n", trace_signal_names[signal], recording.initial_levels[signal]);
+  }
+  for (const trace_edge &edge : recording.edges) {
+    fprintf(file, "%llu %s %u\n", (unsigned long long)((edge.at + 500) / 1000), trace_signal_names[edge.signal], edge.level);
+  }
+  return fclose(file) == 0;
+}
+
+// initial levels come first at time 0, like write_trace() puts them
+bool read_trace(const char *path, std::vector<trace_edge> &edges, uint8_t (&initial_levels)[trace_signals_count]) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  edges.clear();
+  int initial = 0;
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    unsigned long long at;
+    char name[32];
+    unsigned level;
+    if (line[0] == '#' || sscanf(line, "%llu %31s %u", &at, name, &level) != 3) {
+      continue;
+    }
+    for (int signal = 0; signal < trace_signals_count; signal++) {
+      if (strcmp(name, trace_signal_names[signal]) != 0) {
+        continue;
+      }
+      if (initial < trace_signals_count) {
+        initial_levels[signal] = level;
+        initial++;
+      } else {
+        edges.push_back({ at * 1000, (enum trace_signals)signal, (uint8_t)level });
+      }
+    }
+  }
+  fclose(file);
+  return initial == trace_signals_count;
+}
+
+// GTKWave shows the real valued speed as an analog wave with Data Format > Analog
+bool write_vcd(const char *path, const char *comment) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+  const char identifiers[trace_signals_count] = { '!', '"', '#', '$' };
+  const char speed_identifier = '%';
+  fprintf(file, "$comment %s $end\n$timescale 1ns $end\n$scope module lift $end\n", comment);
+  for (int signal = 0; signal < trace_signals_count; signal++) {
+    fprintf(file, "$var wire 1 %c %s $end\n", identifiers[signal], trace_signal_names[signal]);
+  }
+  fprintf(file, "$var real 64 %c speed $end\n", speed_identifier);
+  fprintf(file, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+  for (int signal = 0; signal < trace_signals_count; signal++) {
+    fprintf(file, "%u%c\n", recording.initial_levels[signal], identifiers[signal]);
+  }
+  fprintf(file, "r0 %c\n$end\n", speed_identifier);
+
+  uint64_t last_at = UINT64_MAX;
+  uint64_t last_step_at = UINT64_MAX;
+  uint8_t direction = recording.initial_levels[trace_direction];
+  for (const trace_edge &edge : recording.edges) {
+    if (edge.at != last_at) {
+      fprintf(file, "#%llu\n", (unsigned long long)edge.at);
+      last_at = edge.at;
+    }
+    fprintf(file, "%u%c\n", edge.level, identifiers[edge.signal]);
+    if (edge.signal == trace_direction) {
+      direction = edge.level;
+    }
+    if (edge.signal == trace_step && edge.level) {
+      // steps per second from the interval to the previous step, signed by DIR
+      double speed = last_step_at != UINT64_MAX && edge.at > last_step_at ? 1e9 / (edge.at - last_step_at) : 0.0;
+      speed = speed && !direction ? -speed : speed;
+      fprintf(file, "r%.3f %c\n", speed, speed_identifier);
+      last_step_at = edge.at;
+    }
+  }
+  return fclose(file) == 0;
+}
+// TRACE FILES END
+
+// COMPARISON START
+// every signal needs the same edges as in the golden trace, each within the tolerance;
+// message tells about the first difference
+bool compare_trace(const std::vector<trace_edge> &golden, const uint8_t (&golden_levels)[trace_signals_count],
+                   std::string &message) {
+  char text[160];
+  for (int signal = 0; signal < trace_signals_count; signal++) {
+    if (golden_levels[signal] != recording.initial_levels[signal]) {
+      snprintf(text, sizeof(text), "%s starts %u instead of %u",
+               trace_signal_names[signal], recording.initial_levels[signal], golden_levels[signal]);
+      message = text;
+      return false;
+    }
+    std::vector<const trace_edge *> expected, recorded;
+    for (const trace_edge &edge : golden) {
+      if (edge.signal == signal) {
+        expected.push_back(&edge);
+      }
+    }
+    for (const trace_edge &edge : recording.edges) {
+      if (edge.signal == signal) {
+        recorded.push_back(&edge);
+      }
+    }
+    for (size_t index = 0; index < min(expected.size(), recorded.size()); index++) {
+      double expected_at = expected[index]->at / 1000.0; // [us]
+      double recorded_at = recorded[index]->at / 1000.0; // [us]
+      double tolerance = TRACE_TOLERANCE + expected_at * TRACE_TOLERANCE_DRIFT;
+      if (fabs(recorded_at - expected_at) > tolerance) {
+        snprintf(text, sizeof(text), "%s edge %zu at %.0f us instead of %.0f us (tolerance %.0f us)",
+                 trace_signal_names[signal], index + 1, recorded_at, expected_at, tolerance);
+        message = text;
+        return false;
+      }
+    }
+    if (expected.size() != recorded.size()) {
+      snprintf(text, sizeof(text), "%s has %zu edges instead of %zu",
+               trace_signal_names[signal], recorded.size(), expected.size());
+      message = text;
+      return false;
+    }
+  }
+  return true;
+}
+// COMPARISON END
+
+#endif // TRACE_H
@@ -0,0 +1,472 @@
+/*
+    Step timing of the firmware in virtual time, printed as JSON:
+     - periods of the motion tick while moving
+     - lateness of every STEP pulse against the interval AccelStepper asked for
+     - the highest jog speed the motion task still keeps up with
+     - the step rate of a feed plunge against the feed rate it was set to
+     - host time of a step chance through the stepper driver against AccelStepper called directly
+
+    pio run -e benchmark && .pio/build/benchmark/program [clock read cost] [GPIO cost] > step_timing.json
+
+    Virtual time only passes on clock reads, GPIO calls, GPIO register
+    accesses and delays, so the numbers scale with those costs in [ns],
+    compare runs made with the same. They are host figures, not step
+    latencies of the ESP32: flash cache misses, interrupts and bus waits
+    are not modeled, those take a logic analyzer on the STEP pin.
+    Built with -DMOTION_TASK_CORE=0 -DMOTION_TASK_PRIORITY=1 motion shares
+    core 0 below the display task, the way stepping shared loop() with the
+    display before it got a task of its own.
+    Reads the task state of the firmware through the RouterLift headers.
+*/
+
+#include <RouterLift.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "Simulation.h"
+
+#define BENCHMARK_CLOCK_READ_COST 250     // [ns]
+#define BENCHMARK_GPIO_COST       150     // [ns] rough cost of digitalRead() and digitalWrite() on the ESP32 core
+#define BENCHMARK_REGISTER_COST   50      // [ns] rough cost of a GPIO register access, see lib/RouterLift/src/Gpio.h
+#define JOG_DURATION              2000    // [ms]
+#define FEED_PLUNGE_DEPTH         5       // [mm] in fast mode, below the target the feed starts from
+#define SWEEP_JOG_DURATION        250     // [ms]
+#define SWEEP_SPEED_START         1000    // [steps per second]
+#define SWEEP_SPEED_MAXIMAL       1000000 // [steps per second]
+#define SWEEP_REFINEMENTS         6       // bisections between the last sustained and the first missed speed
+#define DEADLINE_SLACK            0.1     // a step is late once it comes this share of its interval after it was due
+#define LATE_STEPS_ALLOWED        0.001   // share of late steps a sustained speed may have
+#define SEGMENT_PAUSE             1000    // [us] a step this much later than due starts a new move instead
+#define DRIVER_CALLS              1000000 // step chances per measurement
+#define DRIVER_REPEATS            15      // the fastest measurement counts, the others had the host in between
+
+// BENCHMARK VALUES START
+struct benchmark_result {
+  bool  completed;
+  char  message[96];
+  uint64_t virtual_time; // [us]
+  long  steps;
+  long  steps_measured;  // steps with a previous step of the same move
+  long  steps_late;
+  long  segments;        // moves started from standstill or after a direction change
+  float rate;            // [steps per second] of the measured steps
+  float lateness_mean;   // [us] after the interval AccelStepper asked for
+  float lateness_deviation; // [us]
+  float lateness_median;    // [us]
+  float lateness_slowest_percent; // [us] 99th percentile
+  float lateness_maximal;   // [us]
+  uint32_t tick_periods[TICK_PERIOD_BUCKETS];
+  unsigned long tick_period_maximal; // [us]
+  uint8_t  cpu_share[diagnostics_tasks_count]; // [%]
+};
+
+// [ns] host time per step chance
+struct driver_overhead {
+  double direct;
+  double driver;
+};
+
+struct benchmark {
+  const char *name;
+  void (*run)(benchmark_result &result);
+};
+
+// only touched by the child
+uint64_t step_last_at = 0; // [ns]
+int      step_last_direction = 0;
+double   step_measured_time = 0.0; // [us]
+std::vector<float> step_lateness;  // [us]
+long     steps_seen = 0;
+long     steps_late = 0;
+long     step_segments = 0;
+// BENCHMARK VALUES END
+
+// HELPERS START
+bool fail(benchmark_result &result, const char *message) {
+  result.completed = false;
+  snprintf(result.message, sizeof(result.message), "%s", message);
+  return false;
+}
+
+// runs until the condition holds or the timeout is over
+bool wait_until(const std::function<bool()> &condition, unsigned long timeout) {
+  for (unsigned long waited = 0; waited < timeout; waited += SCENARIO_SLICE) {
+    if (condition()) {
+      return true;
+    }
+    hal_run_for(SCENARIO_SLICE * 1000);
+  }
+  return condition();
+}
+
+bool wait_until_idle(benchmark_result &result) {
+  // the input may not be collected yet or the command still be in the channel
+  hal_run_for(INPUT_LATENCY * 1000);
+  if (!wait_until([] { return motion_mode == motion_idle; }, SCENARIO_TIMEOUT)) {
+    return fail(result, "motion did not finish");
+  }
+  return true;
+}
+
+// called from the motion task inside AccelStepper::step(), before the next interval is computed
+void measure_step(uint64_t at, int direction, bool followed) {
+  steps_seen++;
+  // the interval runSpeed() waited for, truncated like AccelStepper does
+  float due = stepper.speed() != 0.0 ? floorf(1000000.0 / fabsf(stepper.speed()) + 0.001) : 0.0;
+  float interval = (at - step_last_at) / 1000.0;
+  bool same_move = step_last_at && direction == step_last_direction && due > 0.0 && interval <= due + SEGMENT_PAUSE;
+  step_last_at        = at;
+  step_last_direction = direction;
+  if (!same_move) {
+    step_segments++;
+    return;
+  }
+  float lateness = interval - due;
+  step_lateness.push_back(lateness);
+  step_measured_time += interval;
+  if (lateness > due * DEADLINE_SLACK) {
+    steps_late++;
+  }
+}
+
+// only what comes after counts, for a benchmark that has to get somewhere first
+void forget_steps() {
+  step_last_at = 0;
+  step_measured_time = 0.0;
+  step_lateness.clear();
+  steps_seen    = 0;
+  steps_late    = 0;
+  step_segments = 0;
+}
+
+float percentile(std::vector<float> &values, float percent) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  size_t index = min(values.size() - 1, (size_t)(values.size() * percent / 100.0));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+void summarize_steps(benchmark_result &result) {
+  result.steps          = steps_seen;
+  result.steps_measured = step_lateness.size();
+  result.steps_late     = steps_late;
+  result.segments       = step_segments;
+  result.rate           = step_measured_time > 0.0 ? step_lateness.size() * 1000000.0 / step_measured_time : 0.0;
+
+  double sum = 0.0, square_sum = 0.0;
+  for (float lateness : step_lateness) {
+    sum        += lateness;
+    square_sum += lateness * lateness;
+    result.lateness_maximal = max(result.lateness_maximal, lateness);
+  }
+  if (!step_lateness.empty()) {
+    result.lateness_mean      = sum / step_lateness.size();
+    result.lateness_deviation = sqrt(max(0.0, square_sum / step_lateness.size() - result.lateness_mean * result.lateness_mean));
+  }
+  result.lateness_median          = percentile(step_lateness, 50);
+  result.lateness_slowest_percent = percentile(step_lateness, 99);
+}
+
+void run_benchmark_here(void (*run)(benchmark_result &result), const plant_config &plant,
+                        uint32_t clock_read_cost, uint32_t gpio_cost, benchmark_result &result) {
+  boot_firmware(plant, clock_read_cost, gpio_cost, BENCHMARK_REGISTER_COST);
+  plant_on_step(measure_step);
+
+  uint32_t delayed_before[diagnostics_tasks_count];
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    delayed_before[task] = task_loads[task].delayed.load();
+  }
+  uint64_t started = hal_now();
+
+  result.completed = true;
+  run(result);
+
+  uint64_t elapsed = hal_now() - started;
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    uint64_t delayed = task_loads[task].delayed.load() - delayed_before[task];
+    result.cpu_share[task] = elapsed ? 100 - min<uint64_t>(100, delayed * 100 / elapsed) : 0;
+  }
+  if (result.completed && serial_log.find("ERR") != std::string::npos) {
+    fail(result, serial_log.substr(serial_log.find("Error:")).c_str());
+  }
+  sample_tick_periods(result.tick_periods);
+  result.tick_period_maximal = motion_published.tick_period_maximal;
+  result.virtual_time        = hal_now();
+  summarize_steps(result);
+}
+// HELPERS END
+
+// BENCHMARKS START
+// encoder in fast mode, ten millimeters up and back down with the acceleration profile
+void run_fast_move(benchmark_result &result) {
+  hal_encoder_turn(0, 10);
+  if (!wait_until_idle(result)) {
+    return;
+  }
+  hal_encoder_turn(0, -10);
+  wait_until_idle(result);
+}
+
+// holds the up button, runs at the maximal speed without a profile
+void run_jog(benchmark_result &result) {
+  hal_set_input(PIN_BUTTON_UP, LOW);
+  hal_run_for(JOG_DURATION * 1000);
+  hal_set_input(PIN_BUTTON_UP, HIGH);
+  wait_until_idle(result);
+}
+
+void run_sweep_jog(benchmark_result &result) {
+  hal_set_input(PIN_BUTTON_UP, LOW);
+  hal_run_for(SWEEP_JOG_DURATION * 1000);
+  hal_set_input(PIN_BUTTON_UP, HIGH);
+  wait_until_idle(result);
+}
+
+void run_goto_toolchange(benchmark_result &result) {
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for("finish_toolchange -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "toolchange did not finish");
+  }
+}
+
+void run_auto_zero(benchmark_result &result) {
+  plant_place_tool_length_sensor(true);
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for("finish_tool_length_sensor -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "auto zero did not finish");
+  }
+}
+
+// sets the target where the carriage stands, goes down below it and feeds back up, toolchange pressed while
+// set zero is down; the feed has no ramp, so every step of it has to come at the feed rate
+void run_feed_plunge(benchmark_result &result) {
+  press_button(PIN_BUTTON_SET_SPEED, BUTTON_HOLD_DURATION);
+  hal_encoder_turn(0, -FEED_PLUNGE_DEPTH);
+  if (!wait_until_idle(result)) {
+    return;
+  }
+  forget_steps();
+  hal_set_input(PIN_BUTTON_SET_ZERO, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  hal_set_input(PIN_BUTTON_SET_ZERO, HIGH);
+  if (!wait_for("feed_plunge -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "feed plunge did not finish");
+    return;
+  }
+  float feed_rate = preference_feed_rate / 60.0 / mm_per_step(); // [steps per second]
+  float rate = step_measured_time > 0.0 ? step_lateness.size() * 1000000.0 / step_measured_time : 0.0;
+  if (fabsf(rate - feed_rate) > feed_rate * DEADLINE_SLACK) {
+    fail(result, "steps off the feed rate");
+  }
+}
+
+// opens the settings menu, changes the maximal speed and the acceleration, closes it again
+void run_settings_edit(benchmark_result &result) {
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_HOLD_DURATION);
+  hal_run_for(SCENARIO_SLICE * 1000);
+  for (int page = 0; page < 2; page++) {
+    for (int count = 0; count < 5; count++) {
+      hal_encoder_turn(0, 1);
+      hal_run_for(100000);
+    }
+    press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  }
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_HOLD_DURATION);
+  if (!wait_for("settings_menu -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "settings menu did not close");
+  }
+}
+
+const benchmark benchmarks[] = {
+  { "fast_move",       run_fast_move },
+  { "jog",             run_jog },
+  { "goto_toolchange", run_goto_toolchange },
+  { "auto_zero",       run_auto_zero },
+  { "settings_edit",   run_settings_edit },
+  { "feed_plunge",     run_feed_plunge },
+};
+// BENCHMARKS END
+
+// DRIVER OVERHEAD START
+// stepper_driver resolves at compile time, so a step chance through it costs what AccelStepper costs;
+// no step is due here, the clock stands still outside the simulation
+template <typename run_function>
+double time_step_chances(run_function run) {
+  double fastest = 1e30;
+  for (int repeat = 0; repeat < DRIVER_REPEATS; repeat++) {
+    auto started = std::chrono::steady_clock::now();
+    bool stepped = false;
+    for (long call = 0; call < DRIVER_CALLS; call++) {
+      stepped |= run();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    if (stepped) {
+      return -1.0;
+    }
+    fastest = std::min(fastest, elapsed.count() / DRIVER_CALLS);
+  }
+  return fastest;
+}
+
+void measure_driver_overhead(driver_overhead &result) {
+  static_assert(sizeof(accel_stepper_engine<simulated_stepper>) == sizeof(simulated_stepper),
+                "the driver adds no state and no vtable to the engine");
+  simulated_stepper direct;
+  accel_stepper_engine<simulated_stepper> driven;
+  direct.setMaxSpeed(1000);
+  direct.setSpeed(1000);
+  driven.set_profile(1000, 1000);
+  driven.set_speed(1000);
+  result.direct = time_step_chances([&direct]() { return direct.runSpeed(); });
+  result.driver = time_step_chances([&driven]() { return driven.run_speed_tick(); });
+}
+// DRIVER OVERHEAD END
+
+// OUTPUT START
+void print_result(const char *name, const benchmark_result &result) {
+  printf("    {\n");
+  printf("      \"name\": \"%s\",\n", name);
+  printf("      \"completed\": %s,\n", result.completed ? "true" : "false");
+  if (!result.completed) {
+    printf("      \"message\": \"%s\",\n", result.message);
+  }
+  printf("      \"virtual_time_s\": %.3f,\n", result.virtual_time / 1e6);
+  printf("      \"steps\": %ld,\n", result.steps);
+  printf("      \"steps_measured\": %ld,\n", result.steps_measured);
+  printf("      \"steps_late\": %ld,\n", result.steps_late);
+  printf("      \"segments\": %ld,\n", result.segments);
+  printf("      \"step_rate\": %.1f,\n", result.rate);
+  printf("      \"step_lateness_us\": { \"mean\": %.2f, \"deviation\": %.2f, \"median\": %.2f, \"p99\": %.2f, \"max\": %.2f },\n",
+         result.lateness_mean, result.lateness_deviation, result.lateness_median,
+         result.lateness_slowest_percent, result.lateness_maximal);
+
+  // upper bounds of the buckets, null when beyond the last one
+  printf("      \"tick_period_us\": {");
+  const uint8_t percents[] = { 50, 90, 99 };
+  for (uint8_t percent : percents) {
+    uint32_t period = tick_period_percentile(result.tick_periods, percent);
+    if (period == UINT32_MAX) {
+      printf(" \"p%u\": null,", percent);
+    } else {
+      printf(" \"p%u\": %u,", percent, period);
+    }
+  }
+  printf(" \"max\": %lu, \"bucket_width\": %d, \"histogram\": [", result.tick_period_maximal, TICK_PERIOD_BUCKET_WIDTH);
+  for (int bucket = 0; bucket < TICK_PERIOD_BUCKETS; bucket++) {
+    printf("%s%u", bucket ? ", " : "", result.tick_periods[bucket]);
+  }
+  printf("] },\n");
+
+  printf("      \"cpu_share_percent\": {");
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    printf("%s \"%s\": %u", task ? "," : "", task_loads[task].name, result.cpu_share[task]);
+  }
+  printf(" }\n");
+  printf("    }");
+}
+
+bool is_sustained(const benchmark_result &result, long speed) {
+  return result.completed && result.steps_measured > 0
+         && result.steps_late <= result.steps_measured * LATE_STEPS_ALLOWED
+         && result.rate >= speed * (1.0 - DEADLINE_SLACK);
+}
+// OUTPUT END
+
+int main(int argc, char **argv) {
+  uint32_t clock_read_cost = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCHMARK_CLOCK_READ_COST;
+  uint32_t gpio_cost       = argc > 2 ? strtoul(argv[2], NULL, 10) : BENCHMARK_GPIO_COST;
+  int jobs = parallel_children();
+  const int benchmarks_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+  printf("{\n");
+  printf("  \"clock_read_cost_ns\": %u,\n", clock_read_cost);
+  printf("  \"gpio_cost_ns\": %u,\n", gpio_cost);
+  printf("  \"register_cost_ns\": %u,\n", BENCHMARK_REGISTER_COST);
+  printf("  \"deadline_slack\": %.3f,\n", DEADLINE_SLACK);
+
+  driver_overhead overhead;
+  if (!finish_child(start_child<driver_overhead>(measure_driver_overhead), overhead)) {
+    overhead = { -1.0, -1.0 };
+  }
+  printf("  \"driver_overhead_ns\": { \"direct\": %.3f, \"driver\": %.3f, \"difference\": %.3f },\n",
+         overhead.direct, overhead.driver, overhead.driver - overhead.direct);
+  printf("  \"scenarios\": [\n");
+  benchmark_result results[benchmarks_count];
+  for (int first = 0; first < benchmarks_count; first += jobs) {
+    std::vector<child_run<benchmark_result>> running;
+    for (int index = first; index < min(benchmarks_count, first + jobs); index++) {
+      running.push_back(start_child<benchmark_result>([index, clock_read_cost, gpio_cost](benchmark_result &result) {
+        plant_config plant = lift_plant_config(1);
+        plant.tool_length_height = 30.0;
+        plant.height             = 10.0;
+        set_float_preference("tlsensor_height", plant.tool_length_height);
+        run_benchmark_here(benchmarks[index].run, plant, clock_read_cost, gpio_cost, result);
+      }));
+    }
+    for (int index = 0; index < (int)running.size(); index++) {
+      if (!finish_child(running[index], results[first + index])) {
+        fail(results[first + index], "simulation crashed");
+      }
+    }
+  }
+  bool all_completed = true;
+  for (int index = 0; index < benchmarks_count; index++) {
+    print_result(benchmarks[index].name, results[index]);
+    printf(index < benchmarks_count - 1 ? ",\n" : "\n");
+    all_completed &= results[index].completed;
+  }
+  printf("  ],\n");
+
+  // doubles the jog speed until steps come late, then bisects; the plant never stalls here
+  auto sweep = [clock_read_cost, gpio_cost](long speed, benchmark_result &result) {
+    child_run<benchmark_result> run = start_child<benchmark_result>([speed, clock_read_cost, gpio_cost](benchmark_result &found) {
+      plant_config plant = lift_plant_config(1);
+      plant.pull_out_speed       = SWEEP_SPEED_MAXIMAL * 2;
+      plant.acceleration_maximal = 1e12;
+      plant.height_maximal       = 1e9;
+      plant.end_stop_height      = 1e9;
+      set_long_preference("motor_speed_max", speed);
+      run_benchmark_here(run_sweep_jog, plant, clock_read_cost, gpio_cost, found);
+    });
+    if (!finish_child(run, result)) {
+      fail(result, "simulation crashed");
+    }
+    return is_sustained(result, speed);
+  };
+
+  struct sweep_point {
+    long  speed;
+    float rate;
+    long  steps_late;
+    bool  sustained;
+  };
+  std::vector<sweep_point> points;
+  long sustained = 0, missed = 0;
+  benchmark_result result;
+  for (long speed = SWEEP_SPEED_START; speed <= SWEEP_SPEED_MAXIMAL && !missed; speed *= 2) {
+    bool kept_up = sweep(speed, result);
+    points.push_back({ speed, result.rate, result.steps_late, kept_up });
+    (kept_up ? sustained : missed) = speed;
+  }
+  for (int refinement = 0; missed && refinement < SWEEP_REFINEMENTS; refinement++) {
+    long speed = (sustained + missed) / 2;
+    bool kept_up = sweep(speed, result);
+    points.push_back({ speed, result.rate, result.steps_late, kept_up });
+    (kept_up ? sustained : missed) = speed;
+  }
+
+  printf("  \"step_rate_sweep\": [\n");
+  for (size_t index = 0; index < points.size(); index++) {
+    printf("    { \"speed\": %ld, \"step_rate\": %.1f, \"steps_late\": %ld, \"sustained\": %s }%s\n",
+           points[index].speed, points[index].rate, points[index].steps_late,
+           points[index].sustained ? "true" : "false", index < points.size() - 1 ? "," : "");
+  }
+  printf("  ],\n");
+  printf("  \"step_rate_sustained\": %ld\n", sustained);
+  printf("}\n");
+  return all_completed ? 0 : 1;
+}
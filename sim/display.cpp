@@ -0,0 +1,280 @@
+/*
+    Renders every screen of the firmware into the framebuffer of the display,
+    prints what a frame costs and keeps PNG snapshots of the screens.
+
+    pio run -e display && .pio/build/display/program [compare|record] [directory]
+
+     - compare checks every screen against sim/screens/<screen>.png (the default),
+       a screen that differs is written next to it as <screen>.actual.png
+     - record writes the snapshots again after an intended change
+
+    Render time is host time of draw() without sendBuffer(), only good for
+    comparing two versions of the drawing code on the same machine. The I2C
+    bytes and bus time follow the transfers u8x8 makes for the SSD1306.
+    Fonts are stand-ins of the same size, see lib/NativeHal/src/U8g2lib.h.
+*/
+
+#include <RouterLift.h>
+#include <chrono>
+#include <vector>
+#include "Snapshot.h"
+
+#define RENDER_REPEATS     2000
+#define SNAPSHOT_DIRECTORY "sim/screens"
+
+// SCREENS START
+struct screen {
+  const char *name;
+  void (*configure)(control_status &control, motion_status &motion);
+};
+
+long steps_for_mm(float height) {
+  return lround(height / mm_per_step()) * preference_motor_direction;
+}
+
+void configure_position(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(12.35);
+}
+
+void configure_position_negative(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(-23.5);
+  control.slow_speed = true;
+}
+
+void configure_target(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(4.2);
+  control.target_active = true;
+  control.target_height = 18.75;
+}
+
+void configure_preset(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(9.5);
+  control.overlay        = overlay_preset;
+  control.preset_slot    = 1;
+  preference_presets[1]  = 9.5;
+}
+
+void configure_pass_step(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(9.5);
+  control.overlay = overlay_pass_step;
+  preference_pass_step = 2.5;
+}
+
+void configure_depth_passes(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(7.5);
+  control.state         = depth_passes;
+  control.target_active = true;
+  control.target_height = 12.0;
+  control.pass       = 3;
+  control.pass_count = 5;
+}
+
+void configure_feed_rate(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(9.5);
+  control.overlay = overlay_feed_rate;
+}
+
+void configure_feed_plunge(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(8.25);
+  control.state         = feed_plunge;
+  control.target_active = true;
+  control.target_height = 12.0;
+  control.feed_rate     = 240;
+}
+
+// a resonance band moved the feed to its lower edge
+void configure_feed_plunge_limited(control_status &control, motion_status &motion) {
+  configure_feed_plunge(control, motion);
+  control.feed_rate    = 216;
+  control.feed_limited = true;
+}
+
+void configure_workspace(control_status &control, motion_status &motion) {
+  motion.position = steps_for_mm(40.0);
+  control.workspace_active      = true;
+  control.workspace_lower_limit = motion.position;
+  control.workspace_upper_limit = steps_for_mm(0.0);
+  hal_set_input(PIN_SENSOR_TOOL_LENGTH_ENABLED, preference_sensor_tool_length_enabled_normally_closed ? HIGH : LOW);
+}
+
+template <long page>
+void configure_settings_page(control_status &control, motion_status &motion) {
+  control.state = settings_menu;
+  control.settings_menu_active_page = page;
+}
+
+void configure_diagnostics(control_status &control, motion_status &motion) {
+  control.state = settings_menu;
+  control.diagnostics_visible = true;
+  diagnostics_report report = {};
+  const char *names[diagnostics_tasks_count] = { "MotionTask", "ControlTask", "DisplayTask" };
+  const uint8_t shares[diagnostics_tasks_count] = { 12, 3, 96 };
+  for (int task = 0; task < diagnostics_tasks_count; task++) {
+    report.tasks[task] = { names[task], shares[task], 1200 };
+  }
+  report.heap_free          = 254000;
+  report.heap_free_minimal  = 251000;
+  report.heap_largest_block = 110580;
+  report.heap_blocks        = 342;
+  diagnostics_for_display.write(report);
+}
+
+void configure_tool(control_status &control, motion_status &motion) {
+  configure_workspace(control, motion);
+  control.tool_selected = true;
+  control.tool_slot     = 2;
+}
+
+template <bool known>
+void configure_select_tool(control_status &control, motion_status &motion) {
+  control.state     = select_tool;
+  control.tool_slot = 2;
+  preference_tool_offsets[2] = known ? steps_for_mm(-56.25) : TOOL_OFFSET_UNKNOWN;
+}
+
+// stays selected for the work offset pages after it
+void configure_work_offset(control_status &control, motion_status &motion) {
+  preference_work_offset_slot = 1;
+  preference_work_offsets[1]  = 19.05;
+  control.work_zero = steps_for_mm(19.05);
+  motion.position   = steps_for_mm(25.0);
+}
+
+void configure_error(control_status &control, motion_status &motion) {
+  control.state = error;
+  control.error_message = "Endstop not free";
+}
+
+void configure_reset(control_status &control, motion_status &motion) {
+  control.state = reset;
+}
+
+const screen screens[] = {
+  { "position",            configure_position },
+  { "position_negative",   configure_position_negative },
+  { "target",              configure_target },
+  { "preset",              configure_preset },
+  { "pass_step",           configure_pass_step },
+  { "depth_passes",        configure_depth_passes },
+  { "feed_rate",           configure_feed_rate },
+  { "feed_plunge",         configure_feed_plunge },
+  { "feed_plunge_limited", configure_feed_plunge_limited },
+  { "workspace",           configure_workspace },
+  { "tool",                configure_tool },
+  { "select_tool",         configure_select_tool<true> },
+  { "select_tool_new",     configure_select_tool<false> },
+  { "settings_00",         configure_settings_page<0> },
+  { "settings_01",         configure_settings_page<1> },
+  { "settings_02",         configure_settings_page<2> },
+  { "settings_03",         configure_settings_page<3> },
+  { "settings_04",         configure_settings_page<4> },
+  { "settings_05",         configure_settings_page<5> },
+  { "settings_06",         configure_settings_page<6> },
+  { "settings_07",         configure_settings_page<7> },
+  { "settings_08",         configure_settings_page<8> },
+  { "settings_09",         configure_settings_page<9> },
+  { "settings_10",         configure_settings_page<10> },
+  { "settings_11",         configure_settings_page<11> },
+  { "settings_12",         configure_settings_page<12> },
+  { "settings_13",         configure_settings_page<13> },
+  { "settings_14",         configure_settings_page<14> },
+  { "settings_15",         configure_settings_page<15> },
+  { "settings_16",         configure_settings_page<16> },
+  { "settings_17",         configure_settings_page<17> },
+  { "settings_18",         configure_settings_page<18> },
+  { "work_offset",         configure_work_offset },
+  { "settings_19",         configure_settings_page<19> },
+  { "settings_20",         configure_settings_page<20> },
+  { "settings_21",         configure_settings_page<21> },
+  { "settings_22",         configure_settings_page<22> },
+  { "settings_23",         configure_settings_page<23> },
+  { "settings_24",         configure_settings_page<24> },
+  { "settings_25",         configure_settings_page<25> },
+  { "settings_26",         configure_settings_page<26> },
+  { "settings_27",         configure_settings_page<27> },
+  { "settings_28",         configure_settings_page<28> },
+  { "settings_29",         configure_settings_page<29> },
+  { "diagnostics",         configure_diagnostics },
+  { "error",               configure_error },
+  { "reset",               configure_reset },
+};
+// SCREENS END
+
+// RUNNER START
+struct frame_cost {
+  double render_time; // [us] host time
+  unsigned long primitives;
+  unsigned long characters;
+  unsigned long pixels;
+  unsigned long long i2c_bytes;
+  unsigned long long i2c_time; // [us]
+};
+
+frame_cost counted() {
+  return { 0.0, display_I2C.primitives, display_I2C.characters, display_I2C.pixels,
+           display_I2C.i2c_bytes, display_I2C.i2c_time };
+}
+
+// draw() outside the tasks, so sendBuffer() counts the bus but spends no virtual time
+frame_cost render(const screen &screen) {
+  control_status control = { default_start };
+  motion_status motion = {};
+  hal_set_input(PIN_SENSOR_TOOL_LENGTH_ENABLED, preference_sensor_tool_length_enabled_normally_closed ? LOW : HIGH);
+  screen.configure(control, motion);
+  display_inputs = sample_inputs();
+
+  frame_cost before = counted();
+  std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+  for (int repeat = 0; repeat < RENDER_REPEATS; repeat++) {
+    control_status_for_display.write(control);
+    motion_status_for_display.write(motion);
+    draw();
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - started;
+
+  frame_cost after = counted();
+  frame_cost cost;
+  cost.render_time = elapsed.count() / RENDER_REPEATS;
+  cost.primitives  = (after.primitives - before.primitives) / RENDER_REPEATS;
+  cost.characters  = (after.characters - before.characters) / RENDER_REPEATS;
+  cost.pixels      = (after.pixels - before.pixels) / RENDER_REPEATS;
+  cost.i2c_bytes   = (after.i2c_bytes - before.i2c_bytes) / RENDER_REPEATS;
+  cost.i2c_time    = (after.i2c_time - before.i2c_time) / RENDER_REPEATS;
+  return cost;
+}
+
+int main(int argc, char **argv) {
+  std::string mode = argc > 1 ? argv[1] : "compare";
+  bool record = mode == "record";
+  std::string directory = argc > 2 ? argv[2] : SNAPSHOT_DIRECTORY;
+  bool all_passed = true;
+
+  hal_set_serial_echo(false);
+  read_settings();
+
+  printf("%-18s %9s %5s %5s %6s %6s %7s  %s\n", "screen", "render", "prims", "chars", "pixels", "i2c", "bus", "snapshot");
+  for (const screen &screen : screens) {
+    frame_cost cost = render(screen);
+    std::vector<uint8_t> png = encode_snapshot(display_I2C);
+    std::string path = directory + "/" + screen.name + ".png";
+    const char *verdict = "ok";
+    if (record) {
+      verdict = write_snapshot(path, png) ? "recorded" : "cannot write";
+    } else {
+      std::vector<uint8_t> golden;
+      if (!read_snapshot(path, golden)) {
+        verdict = "cannot read";
+      } else if (golden != png) {
+        verdict = write_snapshot(directory + "/" + screen.name + ".actual.png", png) ? "DIFFERS" : "DIFFERS, cannot write";
+      }
+    }
+    all_passed &= strcmp(verdict, "ok") == 0 || strcmp(verdict, "recorded") == 0;
+    printf("%-18s %6.2f us %5lu %5lu %6lu %5lluB %4.1f ms  %s\n", screen.name, cost.render_time, cost.primitives,
+           cost.characters, cost.pixels, cost.i2c_bytes, cost.i2c_time / 1000.0, verdict);
+  }
+  if (!all_passed && !record) {
+    printf("look at the .actual.png files, and record again if the change was intended\n");
+  }
+  return all_passed ? 0 : 1;
+}
+// RUNNER END
@@ -0,0 +1,357 @@
+/*
+    Drives random timelines of buttons, encoder and tool length sensor
+    through the firmware and checks motion safety after every step:
+     - the carriage never steps past the end stop
+     - never below the target lower limit while the target is active
+     - never out of the workspace while it is active
+     - no state but default_start, select_tool, depth_passes, feed_plunge, settings_menu and error lasts longer than STUCK_TIMEOUT
+    Failing sequences are minimized and printed.
+
+    pio run -e fuzz && .pio/build/fuzz/program [sequences] [seed] [events per sequence]
+    pio run -e fuzz && SIM_ECHO=1 .pio/build/fuzz/program replay <seed> [events per sequence]
+
+    Reads the limits of the firmware through the RouterLift headers.
+
+    Every event runs the whole firmware for its pause in virtual time, so
+    this is some 40000 events per minute per host core, 19000 with the
+    timer engine, not millions; sequences run in parallel across cores.
+*/
+
+#include <RouterLift.h>
+#include <chrono>
+#include <vector>
+#include "Simulation.h"
+
+#define FUZZ_CLOCK_READ_COST 20000 // [ns] coarser than the scenarios, the invariants need no fine step timing
+#define FUZZ_EVENTS          200   // per sequence
+#define STUCK_TIMEOUT        30000 // [ms] longer than a toolchange from the bottom
+#define SETTLE_TIMEOUT       STUCK_TIMEOUT + 1000 // [ms] after the last event
+#define END_STOP_OVERTRAVEL  2     // [steps] bounce may hide the end stop for a step
+#define PAUSE_SHORT          30    // [ms] mean of most pauses between events
+#define PAUSE_LONG_MAXIMAL   5000  // [ms] some pauses let moves finish
+
+// FUZZ VALUES START
+enum fuzz_event_types {
+  fuzz_encoder,     // value is the counts
+  fuzz_button,      // pin goes down for value 1, up for 0
+  fuzz_tool_length, // sensor placed for value 1, taken away for 0
+};
+
+struct fuzz_event {
+  enum fuzz_event_types type;
+  uint8_t  pin;
+  long     value;
+  uint32_t pause; // [ms] after the event
+};
+
+enum invariants {
+  invariant_none,
+  invariant_end_stop,
+  invariant_target,
+  invariant_workspace,
+  invariant_stuck,
+  invariant_crashed
+};
+
+const char *invariant_names[] = {
+  "none",
+  "stepped past the end stop",
+  "stepped below the target",
+  "stepped out of the workspace",
+  "stuck in a state",
+  "crashed",
+};
+
+struct fuzz_result {
+  enum invariants violated;
+  long  event;  // index of the event after which it happened
+  char  message[160];
+  long  events; // events run
+  uint64_t virtual_time; // [us]
+};
+
+const uint8_t fuzz_buttons[] = {
+  PIN_BUTTON_UP,
+  PIN_BUTTON_DOWN,
+  PIN_BUTTON_TOOLCHANGE,
+  PIN_BUTTON_SET_ZERO,
+  PIN_BUTTON_SET_SPEED,
+  PIN_BUTTON_GOTO_BOTTOM,
+};
+
+const char *fuzz_button_names[] = {
+  "up",
+  "down",
+  "toolchange",
+  "set_zero",
+  "set_speed",
+  "goto_bottom",
+};
+
+// only touched by the child
+plant_config fuzz_plant;
+fuzz_result *fuzz_found = nullptr;
+long fuzz_event_index = 0;
+// FUZZ VALUES END
+
+// GENERATOR START
+// the plant and the sequence only depend on the seed, so a seed replays a run
+plant_config fuzz_plant_config(uint32_t seed) {
+  std::mt19937 random_numbers(seed);
+  plant_config plant = lift_plant_config(seed);
+  plant.end_stop_height    = random_between(random_numbers, 60.0, 80.0);
+  plant.height             = random_between(random_numbers, -40.0, plant.end_stop_height - 1.0);
+  plant.tool_length_height = random_between(random_numbers, 10.0, 40.0);
+  return plant;
+}
+
+std::vector<fuzz_event> generate_sequence(uint32_t seed, long events) {
+  std::mt19937 random_numbers(seed ^ 0x9e3779b9);
+  std::vector<fuzz_event> sequence;
+  bool down[sizeof(fuzz_buttons)] = {};
+  bool placed = false;
+  for (long index = 0; index < events; index++) {
+    fuzz_event event = {};
+    int kind = std::uniform_int_distribution<int>(0, 9)(random_numbers);
+    if (kind < 3) {
+      event.type  = fuzz_encoder;
+      event.value = std::uniform_int_distribution<long>(-5, 5)(random_numbers);
+    } else if (kind < 9) {
+      uint8_t button = std::uniform_int_distribution<int>(0, sizeof(fuzz_buttons) - 1)(random_numbers);
+      down[button] = !down[button];
+      event.type  = fuzz_button;
+      event.pin   = button;
+      event.value = down[button];
+    } else {
+      placed = !placed;
+      event.type  = fuzz_tool_length;
+      event.value = placed;
+    }
+    if (random_between(random_numbers, 0.0, 1.0) < 0.2) {
+      event.pause = random_between(random_numbers, 500, PAUSE_LONG_MAXIMAL);
+    } else {
+      event.pause = std::exponential_distribution<float>(1.0 / PAUSE_SHORT)(random_numbers);
+    }
+    sequence.push_back(event);
+  }
+  return sequence;
+}
+
+void print_event(const fuzz_event &event) {
+  switch (event.type) {
+    case fuzz_encoder:
+      printf("  encoder %+ld", event.value);
+      break;
+    case fuzz_button:
+      printf("  button %s %s", fuzz_button_names[event.pin], event.value ? "down" : "up");
+      break;
+    case fuzz_tool_length:
+      printf("  tool length sensor %s", event.value ? "placed" : "taken away");
+      break;
+  }
+  printf(", wait %u ms\n", event.pause);
+}
+// GENERATOR END
+
+// INVARIANTS START
+void violate(enum invariants invariant, const char *format, ...) {
+  if (fuzz_found->violated != invariant_none) {
+    return;
+  }
+  fuzz_found->violated = invariant;
+  fuzz_found->event    = fuzz_event_index;
+  va_list arguments;
+  va_start(arguments, format);
+  vsnprintf(fuzz_found->message, sizeof(fuzz_found->message), format, arguments);
+  va_end(arguments);
+}
+
+// called from the motion task inside AccelStepper::step(), the position already counts this step
+void check_step(uint64_t at, int direction, bool followed) {
+  const plant_state &plant = plant_status();
+  float height = plant.height + (followed ? direction * fuzz_plant.mm_per_step : 0.0);
+  if (height > fuzz_plant.end_stop_height + END_STOP_OVERTRAVEL * fuzz_plant.mm_per_step) {
+    violate(invariant_end_stop, "height %.2f mm, end stop at %.2f mm, motion mode %d",
+            height, fuzz_plant.end_stop_height, motion_mode);
+  }
+
+  // the motion task's own copies of the limits are the ones it has to keep
+  long position = stepper.position();
+  int  step_direction = stepper.speed() > 0 ? 1 : -1;
+  if (motion_target_active && step_direction < 0 && position < motion_target_lower_limit) {
+    violate(invariant_target, "position %ld, target lower limit %ld, motion mode %d",
+            position, motion_target_lower_limit, motion_mode);
+  }
+  if (motion_workspace_active && ((step_direction < 0 && position < motion_workspace_lower_limit)
+                                  || (step_direction > 0 && position > motion_workspace_upper_limit))) {
+    violate(invariant_workspace, "position %ld, workspace %ld to %ld, motion mode %d",
+            position, motion_workspace_lower_limit, motion_workspace_upper_limit, motion_mode);
+  }
+}
+
+bool is_resting_state(enum states state) {
+  return state == default_start || state == select_tool || state == depth_passes || state == feed_plunge || state == settings_menu || state == error;
+}
+
+void check_stuck() {
+  unsigned long stayed = hal_now() / 1000 - current_state_entered_at;
+  if (!is_resting_state(current_state) && stayed > STUCK_TIMEOUT) {
+    violate(invariant_stuck, "%s for %lu ms", state_table[current_state].name, stayed);
+  }
+}
+// INVARIANTS END
+
+// RUNNER START
+// settings are not fuzzed, a wrong motor direction or thread pitch breaks every invariant by design
+void apply_event(const fuzz_event &event) {
+  switch (event.type) {
+    case fuzz_encoder:
+      if (current_state != settings_menu) {
+        hal_encoder_turn(0, event.value);
+      }
+      break;
+    case fuzz_button:
+      hal_set_input(fuzz_buttons[event.pin], event.value ? LOW : HIGH);
+      break;
+    case fuzz_tool_length:
+      plant_place_tool_length_sensor(event.value);
+      break;
+  }
+}
+
+// runs in slices so a violation stops the run soon after it happened
+void run_checked(uint32_t duration) {
+  for (uint32_t ran = 0; ran < duration && fuzz_found->violated == invariant_none; ran += SCENARIO_SLICE) {
+    hal_run_for(min<uint32_t>(SCENARIO_SLICE, duration - ran) * 1000);
+    check_stuck();
+  }
+}
+
+void run_sequence_here(uint32_t seed, const std::vector<fuzz_event> &sequence, fuzz_result &result) {
+  fuzz_found = &result;
+  fuzz_plant = fuzz_plant_config(seed);
+  set_float_preference("tlsensor_height", fuzz_plant.tool_length_height);
+  boot_firmware(fuzz_plant, FUZZ_CLOCK_READ_COST);
+  plant_on_step(check_step);
+
+  for (fuzz_event_index = 0; fuzz_event_index < (long)sequence.size() && result.violated == invariant_none; fuzz_event_index++) {
+    apply_event(sequence[fuzz_event_index]);
+    run_checked(sequence[fuzz_event_index].pause);
+    result.events++;
+  }
+
+  // let go of everything, whatever runs has to come to rest
+  for (uint8_t pin : fuzz_buttons) {
+    hal_set_input(pin, HIGH);
+  }
+  for (uint32_t waited = 0; waited < SETTLE_TIMEOUT && result.violated == invariant_none; waited += SCENARIO_SLICE) {
+    if (is_resting_state(current_state) && motion_mode == motion_idle) {
+      break;
+    }
+    run_checked(SCENARIO_SLICE);
+  }
+  result.virtual_time = hal_now();
+}
+
+fuzz_result run_sequence(uint32_t seed, const std::vector<fuzz_event> &sequence) {
+  child_run<fuzz_result> run = start_child<fuzz_result>([seed, &sequence](fuzz_result &result) {
+    run_sequence_here(seed, sequence, result);
+  });
+  fuzz_result result;
+  if (!finish_child(run, result)) {
+    result.violated = invariant_crashed;
+    snprintf(result.message, sizeof(result.message), "the simulation crashed");
+  }
+  return result;
+}
+
+// drops chunks of events as long as the same invariant still breaks (delta debugging)
+std::vector<fuzz_event> minimize(uint32_t seed, std::vector<fuzz_event> sequence, enum invariants violated) {
+  size_t chunks = 2;
+  while (sequence.size() >= 2) {
+    size_t chunk = (sequence.size() + chunks - 1) / chunks;
+    bool reduced = false;
+    for (size_t start = 0; start < sequence.size(); start += chunk) {
+      std::vector<fuzz_event> candidate(sequence.begin(), sequence.begin() + start);
+      candidate.insert(candidate.end(), sequence.begin() + min(sequence.size(), start + chunk), sequence.end());
+      if (run_sequence(seed, candidate).violated == violated) {
+        sequence = candidate;
+        chunks = max<size_t>(chunks - 1, 2);
+        reduced = true;
+        break;
+      }
+    }
+    if (!reduced) {
+      if (chunk == 1) {
+        break;
+      }
+      chunks = min(chunks * 2, sequence.size());
+    }
+  }
+  return sequence;
+}
+
+void report_failure(uint32_t seed, const std::vector<fuzz_event> &sequence, const fuzz_result &result) {
+  printf("seed %u: %s after event %ld: %s\n", seed, invariant_names[result.violated], result.event, result.message);
+  std::vector<fuzz_event> minimal = minimize(seed, sequence, result.violated);
+  fuzz_result replayed = run_sequence(seed, minimal);
+  printf("minimized to %zu events: %s\n", minimal.size(), replayed.message);
+  for (const fuzz_event &event : minimal) {
+    print_event(event);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2 && strcmp(argv[1], "replay") == 0) {
+    uint32_t seed = strtoul(argv[2], NULL, 10);
+    long events = argc > 3 ? atol(argv[3]) : FUZZ_EVENTS;
+    std::vector<fuzz_event> sequence = generate_sequence(seed, events);
+    fuzz_result result = {};
+    run_sequence_here(seed, sequence, result);
+    printf("seed %u: %s %s\n", seed, invariant_names[result.violated], result.message);
+    return result.violated == invariant_none ? 0 : 1;
+  }
+
+  long sequences = argc > 1 ? atol(argv[1]) : 100;
+  uint32_t seed  = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+  long events    = argc > 3 ? atol(argv[3]) : FUZZ_EVENTS;
+  int jobs = parallel_children();
+  long failures = 0, events_run = 0;
+  uint64_t virtual_time = 0;
+  auto started = std::chrono::steady_clock::now();
+
+  for (long first = 0; first < sequences; first += jobs) {
+    std::vector<std::vector<fuzz_event>> generated;
+    std::vector<child_run<fuzz_result>> running;
+    for (long index = first; index < min(sequences, first + jobs); index++) {
+      generated.push_back(generate_sequence(seed + index, events));
+    }
+    for (long index = 0; index < (long)generated.size(); index++) {
+      const std::vector<fuzz_event> &sequence = generated[index];
+      uint32_t sequence_seed = seed + first + index;
+      running.push_back(start_child<fuzz_result>([sequence_seed, &sequence](fuzz_result &result) {
+        run_sequence_here(sequence_seed, sequence, result);
+      }));
+    }
+    for (long index = 0; index < (long)running.size(); index++) {
+      fuzz_result result;
+      if (!finish_child(running[index], result)) {
+        result.violated = invariant_crashed;
+        snprintf(result.message, sizeof(result.message), "the simulation crashed");
+      }
+      events_run   += result.events;
+      virtual_time += result.virtual_time;
+      if (result.violated != invariant_none) {
+        failures++;
+        report_failure(seed + first + index, generated[index], result);
+      }
+    }
+  }
+
+  double real_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  printf("%ld sequences, %ld failed, %ld events in %.1f s (%.0f per minute), %.0f s virtual (x%.0f)\n",
+         sequences, failures, events_run, real_time, events_run / real_time * 60,
+         virtual_time / 1e6, virtual_time / 1e6 / real_time);
+  return failures ? 1 : 0;
+}
+// RUNNER END
@@ -0,0 +1,883 @@
+/*
+    Runs toolchange, auto zero and jog sequences of the firmware against the
+    lift plant in virtual time, many times with randomized plants.
+
+    pio run -e simulate && .pio/build/simulate/program [runs] [seed] [glitches per second]
+
+    Every run gets its own process, the firmware keeps its state in globals.
+
+    The summary shows how much faster than real time a scenario ran, some
+    x50 to x160 per host core, x15 to x60 with the timer engine, never the
+    thousands asked for: the motion task ticks on every clock read while it
+    moves, SIMULATION_CLOCK_READ_COST apart, and each tick samples the plant.
+*/
+
+#include <RouterLift.h>
+#include <chrono>
+#include <vector>
+#include "Simulation.h"
+
+#define JOG_COUNT_PAUSE       1500  // [ms] a millimeter takes a bit more than a second with the default profile
+#define SIMULATION_CLOCK_READ_COST 5000 // [ns] also the resolution of step timing, 1 % at 2000 steps per second
+
+// SCENARIO VALUES START
+struct scenario_result {
+  bool  passed;
+  char  message[96];
+  float error;           // [mm] distance to where the carriage should be
+  uint64_t virtual_time; // [us]
+  long  steps;
+  long  steps_lost;
+  long  stalls;
+  long  bounces;
+};
+
+struct scenario {
+  const char *name;
+  void (*configure)(plant_config &plant, std::mt19937 &random_numbers);
+  void (*run)(scenario_result &result);
+  float tolerance; // [mm] allowed error
+};
+
+float glitch_rate = 0.0; // [per second]
+// SCENARIO VALUES END
+
+// HELPERS START
+bool fail(scenario_result &result, const char *message) {
+  result.passed = false;
+  snprintf(result.message, sizeof(result.message), "%s", message);
+  return false;
+}
+
+// like wait_for(), only counting what the firmware printed after mark
+bool wait_for_since(size_t mark, const char *text, unsigned long timeout) {
+  for (unsigned long waited = 0; waited < timeout; waited += SCENARIO_SLICE) {
+    if (serial_log.find(text, mark) != std::string::npos) {
+      return true;
+    }
+    hal_run_for(SCENARIO_SLICE * 1000);
+  }
+  return serial_log.find(text, mark) != std::string::npos;
+}
+
+// [mm] from the zero of the firmware to the tip of the bit
+float zero_error() {
+  return plant_status().height - position_in_mm(work_position(stepper.position()));
+}
+// HELPERS END
+
+// SCENARIOS START
+// goes up to the end stop and backs off until it is free again
+void configure_toolchange(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.end_stop_height = random_between(random_numbers, 60.0, 80.0);
+  plant.height          = random_between(random_numbers, -20.0, plant.end_stop_height - 10.0);
+}
+
+void run_toolchange(scenario_result &result) {
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for("goto_toolchange -> finish_toolchange", SCENARIO_TIMEOUT)) {
+    fail(result, "end stop not reached");
+    return;
+  }
+  if (!wait_for("finish_toolchange -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "end stop not freed");
+    return;
+  }
+  const plant_state &plant = plant_status();
+  if (plant.end_stop_triggered) {
+    fail(result, "end stop still triggered");
+  }
+}
+
+// probes the tool length sensor and zeroes at the table top
+float tool_length_height = 0.0; // [mm]
+
+void configure_auto_zero(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.tool_length_placed = true;
+  plant.tool_length_height = random_between(random_numbers, 15.0, 40.0);
+  plant.height             = random_between(random_numbers, -20.0, plant.tool_length_height - 5.0);
+  tool_length_height = plant.tool_length_height;
+  set_float_preference("tlsensor_height", tool_length_height);
+}
+
+void run_auto_zero(scenario_result &result) {
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for("goto_tool_length_sensor -> finish_tool_length_sensor", SCENARIO_TIMEOUT)) {
+    fail(result, "tool length sensor not reached");
+    return;
+  }
+  if (!wait_for("finish_tool_length_sensor -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "table top not reached");
+    return;
+  }
+  // the firmware zeroed where the tip should touch the table
+  result.error = plant_status().height;
+}
+
+// turns the encoder in fast mode, every count is a millimeter;
+// counts arriving while the carriage still moves only go to the next millimeter from where it is
+long jog_counts = 0;
+float jog_start_height = 0.0; // [mm]
+
+void configure_jog(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.height     = random_between(random_numbers, -20.0, 40.0);
+  jog_counts       = std::uniform_int_distribution<long>(-15, 15)(random_numbers);
+  jog_start_height = plant.height;
+}
+
+void run_jog(scenario_result &result) {
+  for (long count = 0; count < labs(jog_counts); count++) {
+    hal_encoder_turn(0, jog_counts > 0 ? 1 : -1);
+    hal_run_for(JOG_COUNT_PAUSE * 1000);
+  }
+  result.error = plant_status().height - (jog_start_height + jog_counts);
+}
+
+// measures two tools into the tool table, then changes back to the first one without probing;
+// its zero has to land where the probe put it, the verifying auto zero after it must agree
+float tool_length_change = 0.0; // [mm] second bit against the first
+
+void configure_tool_table(plant_config &plant, std::mt19937 &random_numbers) {
+  configure_auto_zero(plant, random_numbers);
+  // the workspace below the end stop has to reach under the sensor with either bit
+  plant.end_stop_height = random_between(random_numbers, 55.0, 65.0);
+  tool_length_change    = random_between(random_numbers, -5.0, 10.0);
+  set_bool_preference("tool_table", true);
+  set_bool_preference("tool_verify", true);
+}
+
+// toolchange, turns the encoder to the slot and picks it
+bool change_tool(scenario_result &result, long slot_turns) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "finish_toolchange -> select_tool", SCENARIO_TIMEOUT)) {
+    return fail(result, "tool selection not reached");
+  }
+  for (long turn = 0; turn < labs(slot_turns); turn++) {
+    hal_encoder_turn(0, slot_turns > 0 ? 1 : -1);
+    hal_run_for(SCENARIO_SLICE * 1000);
+  }
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "select_tool -> default_start", SCENARIO_TIMEOUT)) {
+    return fail(result, "tool not picked");
+  }
+  return true;
+}
+
+// runs until the carriage stands, after the firmware printed text
+void wait_for_standing(size_t mark, const char *text) {
+  wait_for_since(mark, text, SCENARIO_TIMEOUT);
+  hal_run_for(SCENARIO_SLICE * 1000);
+  for (unsigned long waited = 0; stepper.is_running() && waited < SCENARIO_TIMEOUT; waited += SCENARIO_SLICE) {
+    hal_run_for(SCENARIO_SLICE * 1000);
+  }
+}
+
+// down to the bottom of the workspace, under the sensor, and auto zero from there
+bool measure_tool(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_GOTO_BOTTOM, BUTTON_PRESS_DURATION);
+  wait_for_standing(mark, "input_goto_bottom_press");
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "finish_tool_length_sensor -> default_start", SCENARIO_TIMEOUT)) {
+    return fail(result, "tool not measured");
+  }
+  hal_run_for(SCENARIO_SLICE * 1000);
+  return true;
+}
+
+void run_tool_table(scenario_result &result) {
+  if (!change_tool(result, 0) || !measure_tool(result)) {
+    return;
+  }
+  float probed_error = zero_error();
+
+  plant_change_tool(tool_length_change);
+  if (!change_tool(result, 1) || !measure_tool(result)) {
+    return;
+  }
+
+  plant_change_tool(-tool_length_change);
+  if (!change_tool(result, -1)) {
+    return;
+  }
+  result.error = zero_error() - probed_error;
+  measure_tool(result);
+}
+
+// auto zeros twice from the same height with a crawling probe speed: the second knows where the sensor
+// triggers and has to get there sooner, touch it at probe speed only and zero at the same height
+#define FAST_PROBE_SPEED 100 // [steps per second] 2 mm/s, a quarter of the maximal speed
+
+float fast_probe_start_height = 0.0; // [mm]
+float tool_length_trigger_speed = 0.0; // [steps per second] of the step that triggered the sensor last
+
+void record_trigger_speed(uint8_t pin, bool triggered, uint64_t at) {
+  if (pin == PIN_SENSOR_TOOL_LENGTH_TRIGGER && triggered) {
+    tool_length_trigger_speed = plant_status().speed;
+  }
+}
+
+void configure_fast_probe(plant_config &plant, std::mt19937 &random_numbers) {
+  configure_auto_zero(plant, random_numbers);
+  // far enough below the sensor for the approach to pay off
+  plant.height = random_between(random_numbers, tool_length_height - 40.0, tool_length_height - 15.0);
+  fast_probe_start_height = plant.height;
+  set_long_preference("auto_zero_speed", FAST_PROBE_SPEED);
+}
+
+// returns how long the probe took to trigger the sensor [us]
+uint64_t probe_duration(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "default_start -> goto_tool_length_sensor", SCENARIO_TIMEOUT)) {
+    fail(result, "auto zero not started");
+    return 0;
+  }
+  uint64_t started = hal_now();
+  if (!wait_for_since(mark, "goto_tool_length_sensor -> finish_tool_length_sensor", SCENARIO_TIMEOUT)) {
+    fail(result, "tool length sensor not reached");
+    return 0;
+  }
+  uint64_t duration = hal_now() - started;
+  if (!wait_for_since(mark, "finish_tool_length_sensor -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "table top not reached");
+    return 0;
+  }
+  hal_run_for(SCENARIO_SLICE * 1000);
+  return duration;
+}
+
+void run_fast_probe(scenario_result &result) {
+  plant_on_switch(record_trigger_speed);
+  uint64_t crawl_duration = probe_duration(result);
+  if (!result.passed) {
+    return;
+  }
+  float probed_error = zero_error();
+
+  // back down in fast mode, a millimeter per count
+  size_t mark = serial_log.size();
+  hal_encoder_turn(0, lroundf(fast_probe_start_height - position_in_mm(work_position(stepper.position()))));
+  wait_for_standing(mark, "targetPosition()");
+
+  mark = serial_log.size();
+  uint64_t approach_duration = probe_duration(result);
+  if (!result.passed) {
+    return;
+  }
+  if (serial_log.find("probe approach", mark) == std::string::npos) {
+    fail(result, "no approach");
+  } else if (approach_duration >= crawl_duration) {
+    fail(result, "approach not faster than crawling");
+  } else if (fabsf(tool_length_trigger_speed) > FAST_PROBE_SPEED * 1.01) {
+    fail(result, "sensor hit faster than the probe speed");
+  }
+  result.error = zero_error() - probed_error;
+}
+
+// auto zero with both sensors picking up noise, debounced by the sampler
+#define NOISY_GLITCH_RATE  10 // [per second] each glitch alone stops a move or trips the probe when read raw
+#define NOISY_FILTER       5  // INT 8, 0.8 ms on a clean edge
+
+void configure_noisy_auto_zero(plant_config &plant, std::mt19937 &random_numbers) {
+  configure_auto_zero(plant, random_numbers);
+  plant.end_stop.glitch_rate    = NOISY_GLITCH_RATE;
+  plant.tool_length.glitch_rate = NOISY_GLITCH_RATE;
+  set_long_preference("end_stop_filter", NOISY_FILTER);
+  set_long_preference("tlsensor_filter", NOISY_FILTER);
+}
+
+void run_noisy_auto_zero(scenario_result &result) {
+  run_auto_zero(result);
+  // the filter lets a trigger through once the bounce is over and its samples agree
+  uint32_t latency_maximal = plant_default_config().tool_length.bounce_duration * 1000
+                             + (sensor_filter_settings[NOISY_FILTER].samples + 1) * SENSOR_SAMPLE_INTERVAL;
+  if (result.passed && sensor_filter_latency_maximal[filtered_tool_length] > latency_maximal) {
+    fail(result, "filter latency too long");
+  }
+}
+
+// measures a tool with G55 selected, changes to it again from the tool table; the display counts from the work
+// zero the offset puts above the table, and the end stop references the machine frame again at the second toolchange
+#define WORK_OFFSET_SLOT 1 // G55
+
+float work_offset_height = 0.0; // [mm]
+
+void configure_work_offset(plant_config &plant, std::mt19937 &random_numbers) {
+  configure_tool_table(plant, random_numbers);
+  work_offset_height = random_between(random_numbers, 5.0, 30.0);
+  set_long_preference("work_slot", WORK_OFFSET_SLOT);
+  set_float_preference("work_1", work_offset_height);
+}
+
+// [mm] from where the work zero of the firmware is to the offset above the tip of the bit
+float work_zero_error() {
+  return zero_error() - work_offset_height;
+}
+
+void run_work_offset(scenario_result &result) {
+  if (!change_tool(result, 0) || !measure_tool(result)) {
+    return;
+  }
+  float probed_error = work_zero_error();
+  // like auto zero
+  if (fabsf(probed_error) > 0.7) {
+    fail(result, "work zero not above the table by the offset");
+    return;
+  }
+
+  if (!change_tool(result, 0)) {
+    return;
+  }
+  result.error = work_zero_error() - probed_error;
+}
+
+// zeroes, jogs up to a height and stores it as the first preset by holding goto bottom, jogs away and recalls
+// it with the chord: goto bottom held while the encoder turns to the next slot and back, then released
+long  preset_counts = 0;      // [mm] in fast mode, from the zero to the preset
+long  preset_away_counts = 0; // [mm] from the preset to where the recall starts
+float preset_zero_height = 0.0; // [mm]
+
+void configure_presets(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.height       = random_between(random_numbers, -20.0, 10.0);
+  preset_counts      = std::uniform_int_distribution<long>(3, 20)(random_numbers);
+  preset_away_counts = std::uniform_int_distribution<long>(-15, 15)(random_numbers);
+  preset_zero_height = plant.height;
+}
+
+void turn_encoder(long counts, unsigned long pause) {
+  for (long count = 0; count < labs(counts); count++) {
+    hal_encoder_turn(0, counts > 0 ? 1 : -1);
+    hal_run_for(pause * 1000);
+  }
+}
+
+void run_presets(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  turn_encoder(preset_counts, JOG_COUNT_PAUSE);
+
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_GOTO_BOTTOM, BUTTON_HOLD_DURATION);
+  if (!wait_for_since(mark, "preset 1:", SCENARIO_TIMEOUT)) {
+    fail(result, "preset not stored");
+    return;
+  }
+  turn_encoder(preset_away_counts, JOG_COUNT_PAUSE);
+  // the display task has to see the button released in between
+  hal_run_for(INPUT_LATENCY * 1000);
+
+  mark = serial_log.size();
+  hal_set_input(PIN_BUTTON_GOTO_BOTTOM, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  turn_encoder(1, INPUT_LATENCY);
+  turn_encoder(-1, INPUT_LATENCY);
+  hal_set_input(PIN_BUTTON_GOTO_BOTTOM, HIGH);
+  if (!wait_for_since(mark, "preset 1 to", SCENARIO_TIMEOUT)) {
+    fail(result, "preset not recalled");
+    return;
+  }
+  wait_for_standing(mark, "preset 1 to");
+  result.error = plant_status().height - (preset_zero_height + preset_counts);
+}
+
+// zeroes, jogs up to a target, holds set speed to set it and jogs down below it; the pass step is dialed with
+// the chord, set speed held while the encoder turns, releasing it starts the passes and goto bottom steps through them
+long  passes_target_counts = 0; // [mm] in fast mode, from the zero to the target
+long  passes_depth_counts  = 0; // [mm] from the target down to where the passes start
+long  passes_step_counts   = 0; // encoder steps on top of the default pass step
+float passes_zero_height   = 0.0; // [mm]
+
+void configure_depth_passes(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.height         = random_between(random_numbers, -20.0, 10.0);
+  passes_target_counts = std::uniform_int_distribution<long>(5, 20)(random_numbers);
+  passes_depth_counts  = std::uniform_int_distribution<long>(3, 12)(random_numbers);
+  passes_step_counts   = std::uniform_int_distribution<long>(-10, 19)(random_numbers);
+  // without a turn releasing set speed only toggles the speed
+  passes_step_counts  += passes_step_counts >= 0;
+  passes_zero_height   = plant.height;
+}
+
+void run_depth_passes(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  turn_encoder(passes_target_counts, JOG_COUNT_PAUSE);
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_SPEED, BUTTON_HOLD_DURATION);
+  if (!wait_for_since(mark, "input_set_speed_hold", SCENARIO_TIMEOUT)) {
+    fail(result, "target not set");
+    return;
+  }
+  turn_encoder(-passes_depth_counts, JOG_COUNT_PAUSE);
+  hal_run_for(INPUT_LATENCY * 1000);
+
+  // set speed held while turning changes the step, releasing it keeps the step and starts nothing
+  mark = serial_log.size();
+  hal_set_input(PIN_BUTTON_SET_SPEED, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  turn_encoder(passes_step_counts, INPUT_LATENCY);
+  hal_set_input(PIN_BUTTON_SET_SPEED, HIGH);
+  if (!wait_for_since(mark, "input_pass_step_set", SCENARIO_TIMEOUT)) {
+    fail(result, "pass step not set");
+    return;
+  }
+  hal_run_for(INPUT_LATENCY * 1000);
+  if (current_state != default_start) {
+    fail(result, "passes started by setting the step");
+    return;
+  }
+
+  // toolchange pressed while set speed is down starts them
+  mark = serial_log.size();
+  hal_set_input(PIN_BUTTON_SET_SPEED, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  hal_set_input(PIN_BUTTON_SET_SPEED, HIGH);
+  if (!wait_for_since(mark, "default_start -> depth_passes", SCENARIO_TIMEOUT)) {
+    fail(result, "passes not started");
+    return;
+  }
+
+  float start_height = plant_status().height;
+  float step = default_pass_step + passes_step_counts * PASS_STEP_DISTANCE; // [mm]
+  long  count = passes_for(lround(passes_depth_counts / mm_per_step()), lroundf(step / mm_per_step()));
+  for (long pass = 1; pass <= count; pass++) {
+    char text[64];
+    snprintf(text, sizeof(text), "pass %ld/%ld to", pass, count);
+    mark = serial_log.size();
+    press_button(PIN_BUTTON_GOTO_BOTTOM, BUTTON_PRESS_DURATION);
+    if (!wait_for_since(mark, text, SCENARIO_TIMEOUT)) {
+      fail(result, "pass not started");
+      return;
+    }
+    wait_for_standing(mark, text);
+    if (fabsf(plant_status().height - (start_height + min(pass * step, (float)passes_depth_counts))) > 0.04) {
+      fail(result, "pass off its height");
+      return;
+    }
+  }
+
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "depth_passes -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "passes not left");
+    return;
+  }
+  result.error = plant_status().height - (passes_zero_height + passes_target_counts);
+}
+
+// references at the end stop, zeroes there and jogs down and up again through a lead screw with play; the
+// firmware takes the backlash up on every reversal, so the shown height stays the height of the carriage,
+// and approaching from below every move has to end going up
+#define BACKLASH_MOVES 6
+#define BACKLASH_COUNT_PAUSE 2000 // [ms] a millimeter and taking up the backlash; approaching from below takes longer, the counts add up
+
+long  backlash_counts[BACKLASH_MOVES]; // [mm] in fast mode, never above the zero at the top of the workspace
+bool  backlash_from_below = false;
+int   backlash_last_step = 0; // [-1 or 1] up is positive
+
+void record_backlash_step(uint64_t at, int direction, bool followed) {
+  backlash_last_step = direction;
+}
+
+void configure_backlash(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.end_stop_height = random_between(random_numbers, 60.0, 80.0);
+  plant.height          = random_between(random_numbers, -20.0, plant.end_stop_height - 10.0);
+  plant.backlash        = random_between(random_numbers, 0.05, 0.5);
+  backlash_from_below   = std::uniform_int_distribution<int>(0, 1)(random_numbers);
+  long height = 0; // [mm] below the zero
+  for (long move = 0; move < BACKLASH_MOVES; move++) {
+    long counts = std::uniform_int_distribution<long>(1, 8)(random_numbers);
+    // down first, then back and forth
+    if (move % 2 == 0 || height + counts > 0) {
+      counts = -counts;
+    }
+    backlash_counts[move] = counts;
+    height += counts;
+  }
+  set_long_preference("backlash", lround(plant.backlash / plant.mm_per_step));
+  set_bool_preference("approach_below", backlash_from_below);
+}
+
+void run_backlash(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "finish_toolchange -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "not referenced");
+    return;
+  }
+  // a bounce of the end stop may free it once more
+  hal_run_for(INPUT_LATENCY * 1000);
+  wait_for_standing(mark, "finish_toolchange -> default_start");
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  float zero_height = plant_status().height;
+  long height = 0; // [mm]
+  plant_on_step(record_backlash_step);
+  for (long move = 0; move < BACKLASH_MOVES; move++) {
+    mark = serial_log.size();
+    turn_encoder(backlash_counts[move], BACKLASH_COUNT_PAUSE);
+    wait_for_standing(mark, "targetPosition");
+    height += backlash_counts[move];
+    const plant_state &plant = plant_status();
+    if (fabsf(plant.height - zero_height - position_in_mm(work_position(motion_published.position))) > 0.02) {
+      fail(result, "shown height off the carriage");
+      return;
+    }
+    if (backlash_from_below && backlash_last_step < 0) {
+      fail(result, "not approached from below");
+      return;
+    }
+    result.error = plant.height - (zero_height + height);
+  }
+}
+
+// references at the end stop, zeroes there and jogs far down and back up a lead screw that travels more or
+// less than its pitch; with the measured errors in the pitch table the shown height stays the height of the
+// carriage all the way, and the table maps every step back and forth within a step
+#define PITCH_MOVES 4
+#define PITCH_SWEEP 100.0 // [mm] either way of the end stop, past both ends of the table
+
+long  pitch_counts[PITCH_MOVES]; // [mm] in fast mode, never above the zero at the top of the workspace
+
+void configure_pitch_error(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.end_stop_height = random_between(random_numbers, 60.0, 80.0);
+  plant.height          = random_between(random_numbers, -20.0, plant.end_stop_height - 10.0);
+  plant.pitch_error     = random_between(random_numbers, 0.002, 0.004) * (std::uniform_int_distribution<int>(0, 1)(random_numbers) ? 1 : -1);
+  // down far, then partly back up
+  for (long move = 0; move < PITCH_MOVES; move++) {
+    pitch_counts[move] = move % 2 == 0 ? -std::uniform_int_distribution<long>(10, 25)(random_numbers)
+                                       : std::uniform_int_distribution<long>(1, 8)(random_numbers);
+  }
+  for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+    char key[12];
+    snprintf(key, sizeof(key), "pitch_%ld", point);
+    set_float_preference(key, plant.pitch_error * (point + 1) * PITCH_TABLE_SPACING);
+  }
+}
+
+// every step of the screw maps to a carriage position no further back than the step before, and back to itself
+bool is_pitch_table_consistent() {
+  long sweep = lround(PITCH_SWEEP / mm_per_step());
+  for (long screw = -sweep; screw < sweep; screw++) {
+    if (true_position(screw + 1) < true_position(screw)
+        || labs(screw_position(true_position(screw)) - screw) > 1
+        || labs(true_position(screw_position(screw)) - screw) > 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void run_pitch_error(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "finish_toolchange -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "not referenced");
+    return;
+  }
+  if (motion_pitch.count != PITCH_TABLE_POINTS + 1) {
+    fail(result, "pitch table not in the motion task");
+    return;
+  }
+  if (!is_pitch_table_consistent()) {
+    fail(result, "pitch table not monotonic or not round trip");
+    return;
+  }
+  // a bounce of the end stop may free it once more
+  hal_run_for(INPUT_LATENCY * 1000);
+  wait_for_standing(mark, "finish_toolchange -> default_start");
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  float zero_height = plant_status().height;
+  long height = 0; // [mm]
+  for (long move = 0; move < PITCH_MOVES; move++) {
+    mark = serial_log.size();
+    turn_encoder(pitch_counts[move], JOG_COUNT_PAUSE);
+    wait_for_standing(mark, "targetPosition");
+    height += pitch_counts[move];
+    const plant_state &plant = plant_status();
+    if (fabsf(plant.height - zero_height - position_in_mm(work_position(motion_published.position))) > 0.03) {
+      fail(result, "shown height off the carriage");
+      return;
+    }
+    result.error = plant.height - (zero_height + height);
+  }
+}
+
+// the motor resonates around the maximal speed; with the band set the toolchange, a held down button and the
+// cruise of encoder moves all run below it, so no step gets lost
+#define RESONANCE_JOG_DURATION 2000 // [ms] down button held
+
+long  resonance_counts = 0; // [mm] in fast mode, down
+
+void configure_resonance(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.end_stop_height = random_between(random_numbers, 60.0, 80.0);
+  plant.height          = random_between(random_numbers, -20.0, plant.end_stop_height - 10.0);
+  plant.resonance_lower = DEFAULT_STEPS_PER_REVOLUTION - random_between(random_numbers, 10.0, 100.0);
+  plant.resonance_upper = DEFAULT_STEPS_PER_REVOLUTION + random_between(random_numbers, 10.0, 100.0);
+  resonance_counts      = std::uniform_int_distribution<long>(1, 10)(random_numbers);
+  // the band as found by trying speeds in steps of ten
+  set_long_preference("res_low_0", (long)floorf(plant.resonance_lower / 10) * 10);
+  set_long_preference("res_up_0", (long)ceilf(plant.resonance_upper / 10) * 10);
+}
+
+void run_resonance(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "finish_toolchange -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "not referenced");
+    return;
+  }
+  hal_run_for(INPUT_LATENCY * 1000);
+  wait_for_standing(mark, "finish_toolchange -> default_start");
+  press_button(PIN_BUTTON_DOWN, RESONANCE_JOG_DURATION);
+  wait_for_standing(mark, "finish_toolchange -> default_start");
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  float zero_height = plant_status().height;
+  mark = serial_log.size();
+  turn_encoder(-resonance_counts, JOG_COUNT_PAUSE);
+  wait_for_standing(mark, "targetPosition");
+  result.error = plant_status().height - (zero_height - resonance_counts);
+}
+
+// zeroes, jogs up to a target, sets it and jogs down below it; the feed rate is dialed with the chord, set zero
+// held while the encoder turns, toolchange pressed with set zero down feeds up to the target, and turning the
+// encoder on the way overrides the feed; the maximal speed caps the feed, half of it in slow speed must not,
+// and with a resonance band around the feed it runs at the lower edge
+#define FEED_MEASURE_DURATION 500 // [ms] of the speed check
+#define FEED_TOLERANCE        0.1 // share of the feed the bit may be off, the window rounds to steps
+#define FEED_BAND_WIDTH       0.2 // share of the feed the band reaches to either side
+
+long  feed_target_counts   = 0; // [mm] in fast mode, from the zero to the target
+long  feed_depth_counts    = 0; // [mm] from the target down to where the feed starts
+long  feed_rate_counts     = 0; // encoder steps on top of the default feed rate
+long  feed_override_counts = 0; // encoder steps turned during the feed
+bool  feed_slow            = false; // slow speed on while the feed starts
+long  feed_band_lower      = 0; // [steps per second] of the resonance band, 0 without
+float feed_zero_height     = 0.0; // [mm]
+
+// [steps per second] dialed, overridden and capped, default pitch, steps per revolution and maximal speed
+float requested_feed_speed() {
+  float feed = (default_feed_rate + feed_rate_counts * FEED_RATE_DISTANCE) * (100 + feed_override_counts * FEED_OVERRIDE_STEP) / 100.0;
+  return min(feed / 60.0f / (default_motor_thread_pitch / default_motor_steps_per_revolution), (float)default_motor_speed_maximal);
+}
+
+// [mm per minute] the bit should go up at, the band lies around the requested feed
+float expected_feed() {
+  float speed = feed_band_lower ? feed_band_lower : requested_feed_speed();
+  return speed * 60.0 * (default_motor_thread_pitch / default_motor_steps_per_revolution);
+}
+
+void configure_feed_plunge(plant_config &plant, std::mt19937 &random_numbers) {
+  plant.height         = random_between(random_numbers, -20.0, 10.0);
+  feed_target_counts   = std::uniform_int_distribution<long>(5, 20)(random_numbers);
+  feed_depth_counts    = std::uniform_int_distribution<long>(10, 20)(random_numbers);
+  // without a turn releasing set zero zeroes
+  feed_rate_counts     = std::uniform_int_distribution<long>(-20, 9)(random_numbers);
+  feed_rate_counts    += feed_rate_counts >= 0;
+  feed_override_counts = std::uniform_int_distribution<long>(-5, 5)(random_numbers);
+  feed_slow            = std::bernoulli_distribution(0.5)(random_numbers);
+  feed_band_lower      = 0;
+  feed_zero_height     = plant.height;
+  if (std::bernoulli_distribution(0.5)(random_numbers)) {
+    float speed = requested_feed_speed();
+    feed_band_lower = (long)floorf(speed * (1.0 - FEED_BAND_WIDTH));
+    set_long_preference("res_low_0", feed_band_lower);
+    set_long_preference("res_up_0", (long)ceilf(speed * (1.0 + FEED_BAND_WIDTH)));
+  }
+}
+
+void run_feed_plunge(scenario_result &result) {
+  size_t mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  if (!wait_for_since(mark, "tool zero", SCENARIO_TIMEOUT)) {
+    fail(result, "not zeroed");
+    return;
+  }
+  turn_encoder(feed_target_counts, JOG_COUNT_PAUSE);
+  mark = serial_log.size();
+  press_button(PIN_BUTTON_SET_SPEED, BUTTON_HOLD_DURATION);
+  if (!wait_for_since(mark, "input_set_speed_hold", SCENARIO_TIMEOUT)) {
+    fail(result, "target not set");
+    return;
+  }
+  turn_encoder(-feed_depth_counts, JOG_COUNT_PAUSE);
+  hal_run_for(INPUT_LATENCY * 1000);
+
+  // releasing set zero after turning keeps the rate and starts nothing
+  mark = serial_log.size();
+  hal_set_input(PIN_BUTTON_SET_ZERO, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  turn_encoder(feed_rate_counts, INPUT_LATENCY);
+  hal_set_input(PIN_BUTTON_SET_ZERO, HIGH);
+  if (!wait_for_since(mark, "input_feed_rate_set", SCENARIO_TIMEOUT)) {
+    fail(result, "feed rate not set");
+    return;
+  }
+  hal_run_for(INPUT_LATENCY * 1000);
+  if (current_state != default_start) {
+    fail(result, "feed started by setting the rate");
+    return;
+  }
+
+  if (feed_slow) {
+    press_button(PIN_BUTTON_SET_SPEED, BUTTON_PRESS_DURATION);
+    hal_run_for(INPUT_LATENCY * 1000);
+  }
+
+  mark = serial_log.size();
+  hal_set_input(PIN_BUTTON_SET_ZERO, LOW);
+  hal_run_for(INPUT_LATENCY * 1000);
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  hal_set_input(PIN_BUTTON_SET_ZERO, HIGH);
+  if (!wait_for_since(mark, "default_start -> feed_plunge", SCENARIO_TIMEOUT)) {
+    fail(result, "feed not started");
+    return;
+  }
+
+  hal_encoder_turn(0, feed_override_counts);
+  hal_run_for(INPUT_LATENCY * 1000);
+  float start_height = plant_status().height;
+  hal_run_for(FEED_MEASURE_DURATION * 1000);
+  float speed = (plant_status().height - start_height) * 60000.0 / FEED_MEASURE_DURATION; // [mm per minute]
+  float feed  = expected_feed();
+  if (fabsf(speed - feed) > feed * FEED_TOLERANCE) {
+    fail(result, "bit off the feed rate");
+    return;
+  }
+
+  if (!wait_for_since(mark, "feed_plunge -> default_start", SCENARIO_TIMEOUT)) {
+    fail(result, "feed not finished");
+    return;
+  }
+  wait_for_standing(mark, "feed_plunge -> default_start");
+  result.error = plant_status().height - (feed_zero_height + feed_target_counts);
+}
+
+const scenario scenarios[] = {
+  { "toolchange", configure_toolchange, run_toolchange, 0.0 },
+  // zero lands below the table by what freeing the sensor backed off, FREE_SENSOR_TOLERANCE and a step or two
+  { "auto_zero",  configure_auto_zero,  run_auto_zero,  0.7 },
+  { "jog",        configure_jog,        run_jog,        0.04 },
+  // both end stop triggers spread by the hysteresis and a step
+  { "tool_table", configure_tool_table, run_tool_table, 0.1 },
+  // the sensor repeats within 0.02 mm, freeing it adds a step or two
+  { "fast_probe", configure_fast_probe, run_fast_probe, 0.06 },
+  { "noisy_zero", configure_noisy_auto_zero, run_noisy_auto_zero, 0.7 },
+  { "work_offset", configure_work_offset, run_work_offset, 0.1 },
+  { "presets",    configure_presets,    run_presets,    0.04 },
+  { "depth_passes", configure_depth_passes, run_depth_passes, 0.04 },
+  // the backlash in steps is off by up to half a step
+  { "backlash",   configure_backlash,   run_backlash,   0.02 },
+  // every point of the table rounds to a step, the jog grid to another one
+  { "pitch_error", configure_pitch_error, run_pitch_error, 0.04 },
+  { "resonance",  configure_resonance,  run_resonance,  0.04 },
+  { "feed_plunge", configure_feed_plunge, run_feed_plunge, 0.04 },
+};
+// SCENARIOS END
+
+// RUNNER START
+void run_scenario_here(const scenario &tried, uint32_t seed, scenario_result &result) {
+  std::mt19937 random_numbers(seed);
+  plant_config plant = lift_plant_config(seed);
+  plant.end_stop.glitch_rate    = glitch_rate;
+  plant.tool_length.glitch_rate = glitch_rate;
+  tried.configure(plant, random_numbers);
+
+  boot_firmware(plant, SIMULATION_CLOCK_READ_COST);
+
+  result.passed = true;
+  tried.run(result);
+  // the firmware must not get lost afterwards either
+  hal_run_for(1000000);
+
+  const plant_state &state = plant_status();
+  if (result.passed && serial_log.find("ERR") != std::string::npos) {
+    fail(result, serial_log.substr(serial_log.find("Error:")).c_str());
+  }
+  if (result.passed && state.steps_lost) {
+    fail(result, "steps lost");
+  }
+  if (result.passed && fabs(result.error) > tried.tolerance) {
+    fail(result, "off target");
+  }
+  result.virtual_time = hal_now();
+  result.steps        = state.steps;
+  result.steps_lost   = state.steps_lost;
+  result.stalls       = state.stalls;
+  result.bounces      = state.bounces;
+}
+
+int main(int argc, char **argv) {
+  int runs      = argc > 1 ? atoi(argv[1]) : 100;
+  uint32_t seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+  glitch_rate   = argc > 3 ? atof(argv[3]) : 0.0;
+  int jobs      = parallel_children();
+  bool all_passed = true;
+
+  for (const scenario &tried : scenarios) {
+    int passed = 0;
+    uint64_t virtual_time = 0; // [us]
+    long steps = 0, steps_lost = 0, stalls = 0, bounces = 0;
+    float error_maximal = 0.0;
+    auto started = std::chrono::steady_clock::now();
+
+    for (int first = 0; first < runs; first += jobs) {
+      std::vector<child_run<scenario_result>> running;
+      for (int run = first; run < min(runs, first + jobs); run++) {
+        running.push_back(start_child<scenario_result>([&tried, run, seed](scenario_result &result) {
+          run_scenario_here(tried, seed + run, result);
+        }));
+      }
+      for (int run = 0; run < (int)running.size(); run++) {
+        scenario_result result;
+        if (!finish_child(running[run], result)) {
+          fail(result, "simulation crashed");
+        }
+        passed       += result.passed;
+        virtual_time += result.virtual_time;
+        steps        += result.steps;
+        steps_lost   += result.steps_lost;
+        stalls       += result.stalls;
+        bounces      += result.bounces;
+        error_maximal = max(error_maximal, fabsf(result.error));
+        if (!result.passed) {
+          printf("%s seed %u: %s\n", tried.name, seed + first + run, result.message);
+        }
+      }
+    }
+
+    double real_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    printf("%-10s %4d/%-4d passed  error max %.3f mm  steps %ld lost %ld  stalls %ld  bounces %ld  "
+           "%.0f s virtual in %.1f s (x%.0f)\n",
+           tried.name, passed, runs, error_maximal, steps, steps_lost, stalls, bounces,
+           virtual_time / 1e6, real_time, virtual_time / 1e6 / real_time);
+    all_passed &= passed == runs;
+  }
+  return all_passed ? 0 : 1;
+}
+// RUNNER END
@@ -0,0 +1,154 @@
+/*
+    Golden traces of STEP, DIR and the switches for scripted scenarios, any
+    change to the motion code that moves a step shows up here.
+
+    pio run -e traces && .pio/build/traces/program [compare|record|vcd] [directory]
+
+     - compare checks against sim/golden/<scenario>.trace (the default)
+     - record writes the golden traces again after an intended change
+     - vcd writes <scenario>.vcd for GTKWave, to look at ramp shapes
+
+    Every scenario runs for a fixed virtual time, so the traces end the same.
+*/
+
+#include <vector>
+#include "Simulation.h"
+#include "Trace.h"
+
+#define TRACE_CLOCK_READ_COST 1000 // [ns]
+#define TRACE_SEED            1
+#define GOLDEN_DIRECTORY      "sim/golden"
+
+// TRACE SCENARIOS START
+struct trace_result {
+  bool passed;
+  char message[160];
+  long edges;
+};
+
+struct trace_scenario {
+  const char *name;
+  void (*configure)(plant_config &plant);
+  void (*run)();
+};
+
+// encoder in fast mode, two millimeters up and back down with the acceleration profile
+void configure_fast_move(plant_config &plant) {
+  plant.height = 20.0;
+}
+
+void run_fast_move() {
+  hal_encoder_turn(0, 2);
+  hal_run_for(3000000);
+  hal_encoder_turn(0, -2);
+  hal_run_for(3000000);
+}
+
+// up button held for a quarter second, constant speed without a profile
+void configure_jog(plant_config &plant) {
+  plant.height = 20.0;
+}
+
+void run_jog() {
+  hal_set_input(PIN_BUTTON_UP, LOW);
+  hal_run_for(250000);
+  hal_set_input(PIN_BUTTON_UP, HIGH);
+  hal_run_for(500000);
+}
+
+// end stop two millimeters above, runs into it and frees it again
+void configure_toolchange(plant_config &plant) {
+  plant.end_stop_height = 80.0;
+  plant.height          = 78.0;
+}
+
+void run_toolchange() {
+  press_button(PIN_BUTTON_TOOLCHANGE, BUTTON_PRESS_DURATION);
+  hal_run_for(3000000);
+}
+
+// probes a five millimeter high sensor two millimeters above and goes down to the table
+void configure_auto_zero(plant_config &plant) {
+  plant.tool_length_placed = true;
+  plant.tool_length_height = 5.0;
+  plant.height             = 3.0;
+  set_float_preference("tlsensor_height", plant.tool_length_height);
+}
+
+void run_auto_zero() {
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  hal_run_for(6000000);
+}
+
+const trace_scenario trace_scenarios[] = {
+  { "fast_move",  configure_fast_move,  run_fast_move },
+  { "jog",        configure_jog,        run_jog },
+  { "toolchange", configure_toolchange, run_toolchange },
+  { "auto_zero",  configure_auto_zero,  run_auto_zero },
+};
+// TRACE SCENARIOS END
+
+// RUNNER START
+enum trace_modes {
+  trace_compare,
+  trace_record,
+  trace_vcd
+};
+
+void run_trace_here(const trace_scenario &scenario, enum trace_modes mode, const std::string &directory,
+                    trace_result &result) {
+  plant_config plant = lift_plant_config(TRACE_SEED);
+  scenario.configure(plant);
+  boot_firmware(plant, TRACE_CLOCK_READ_COST);
+  begin_trace();
+  scenario.run();
+
+  result.passed = true;
+  result.edges  = recording.edges.size();
+  char comment[128];
+  snprintf(comment, sizeof(comment), "%s, clock read cost %d ns, seed %d", scenario.name, TRACE_CLOCK_READ_COST, TRACE_SEED);
+  std::string path = directory + "/" + scenario.name + (mode == trace_vcd ? ".vcd" : ".trace");
+  std::string message;
+
+  if (mode == trace_record && !write_trace(path.c_str(), comment)) {
+    message = "cannot write " + path;
+  } else if (mode == trace_vcd && !write_vcd(path.c_str(), comment)) {
+    message = "cannot write " + path;
+  } else if (mode == trace_compare) {
+    std::vector<trace_edge> golden;
+    uint8_t golden_levels[trace_signals_count];
+    if (!read_trace(path.c_str(), golden, golden_levels)) {
+      message = "cannot read " + path;
+    } else {
+      compare_trace(golden, golden_levels, message);
+    }
+  }
+  if (!message.empty()) {
+    result.passed = false;
+    snprintf(result.message, sizeof(result.message), "%s", message.c_str());
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string mode_name = argc > 1 ? argv[1] : "compare";
+  enum trace_modes mode = mode_name == "record" ? trace_record : mode_name == "vcd" ? trace_vcd : trace_compare;
+  std::string directory = argc > 2 ? argv[2] : mode == trace_vcd ? "." : GOLDEN_DIRECTORY;
+  bool all_passed = true;
+
+  for (const trace_scenario &scenario : trace_scenarios) {
+    child_run<trace_result> run = start_child<trace_result>([&scenario, mode, &directory](trace_result &result) {
+      run_trace_here(scenario, mode, directory, result);
+    });
+    trace_result result;
+    if (!finish_child(run, result)) {
+      snprintf(result.message, sizeof(result.message), "simulation crashed");
+    }
+    printf("%-10s %6ld edges  %s %s\n", scenario.name, result.edges, result.passed ? "ok" : "FAILED", result.message);
+    all_passed &= result.passed;
+  }
+  if (!all_passed && mode == trace_compare) {
+    printf("write VCD files with: program vcd [directory], and record again if the change was intended\n");
+  }
+  return all_passed ? 0 : 1;
+}
+// RUNNER END
@@ -0,0 +1,38 @@
+/*
+    Router Lift Control with ESP32
+    Version 1.0
+    Copyright (C) 2021  https://github.com/SilvanCodes
+
+    The suggestion for this project is based on the work of:
+    Frohnix Bastelbude -> https://www.youtube.com/user/Frohnix
+    The display part (OLED I2C) was imported from this code:
+    Frohnix Bastelbude  ->  https://drive.google.com/file/d/1x_Z-x_cdAlwg_KYfx1PN03zCVg7Hu3KM/view
+
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The firmware is the RouterLift library in lib/RouterLift, build flags pick
+// the board and the backends, see platformio.ini and lib/RouterLift/src/Backends.h.
+
+#include <RouterLift.h>
+
+void setup() {
+  router_lift_setup();
+}
+
+void loop() {
+  // everything runs in its own task
+  vTaskDelete(NULL);
+}
@@ -0,0 +1,140 @@
+/*
+    Hammers channel and mailbox from two host threads, a producer and a
+    consumer, like the tasks on the two cores of the ESP32 use them.
+
+    pio test -e native -f test_channel
+    pio test -e native-tsan     same under the thread sanitizer
+
+    Every item carries its sequence number in all of its fields, a torn copy
+    shows up as fields that disagree. Unity must not be called from the
+    threads, they only count what went wrong and the test asserts afterwards.
+*/
+
+#include <Channel.h>
+#include <atomic>
+#include <thread>
+#include <unity.h>
+
+#define CHANNEL_ITEMS  2000000
+#define MAILBOX_WRITES 2000000
+#define ITEM_FIELDS    8 // wider than one atomic store
+
+// HELPERS START
+struct item {
+  uint32_t fields[ITEM_FIELDS];
+};
+
+item make_item(uint32_t sequence) {
+  item made;
+  for (int field = 0; field < ITEM_FIELDS; field++) {
+    made.fields[field] = sequence;
+  }
+  return made;
+}
+
+bool is_whole(const item &checked) {
+  for (int field = 1; field < ITEM_FIELDS; field++) {
+    if (checked.fields[field] != checked.fields[0]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+// HELPERS END
+
+// TESTS START
+// every item arrives once, whole and in the order it was pushed
+void test_channel_keeps_items_in_order() {
+  static channel<item, 16> items;
+  long torn = 0;
+  long out_of_order = 0;
+  uint32_t expected = 0;
+  std::atomic<bool> pushed{false};
+
+  std::thread producer([&] {
+    for (uint32_t sequence = 0; sequence < CHANNEL_ITEMS; sequence++) {
+      while (!items.push(make_item(sequence))) {
+        std::this_thread::yield();
+      }
+    }
+    pushed = true;
+  });
+  std::thread consumer([&] {
+    item received;
+    while (expected < CHANNEL_ITEMS) {
+      // empty after the producer finished, what got lost stays lost
+      bool finished = pushed;
+      if (!items.pop(received)) {
+        if (finished) {
+          break;
+        }
+        std::this_thread::yield();
+        continue;
+      }
+      torn += !is_whole(received);
+      out_of_order += received.fields[0] != expected;
+      // resynchronizes, so one lost item counts once
+      expected = received.fields[0] + 1;
+    }
+  });
+  producer.join();
+  consumer.join();
+
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, out_of_order);
+  TEST_ASSERT_EQUAL(CHANNEL_ITEMS, expected);
+  TEST_ASSERT_TRUE(items.is_empty());
+}
+
+// the reader only ever sees whole snapshots that never go back in time
+void test_mailbox_hands_out_whole_snapshots() {
+  static mailbox<item> snapshots;
+  long torn = 0;
+  long went_back = 0;
+  long fresh_reads = 0;
+  uint32_t newest = 0;
+  std::atomic<bool> written{false};
+
+  std::thread producer([&] {
+    for (uint32_t sequence = 1; sequence <= MAILBOX_WRITES; sequence++) {
+      snapshots.write(make_item(sequence));
+    }
+    written = true;
+  });
+  std::thread consumer([&] {
+    item received;
+    bool finished = false;
+    // the first read after the producer finished has to see its last write
+    while (newest < MAILBOX_WRITES && !finished) {
+      finished = written;
+      bool fresh = snapshots.read(received);
+      torn += !is_whole(received);
+      went_back += received.fields[0] < newest;
+      // a fresh snapshot is newer than the one before, an old one is the same again
+      went_back += fresh ? received.fields[0] == newest : received.fields[0] != newest;
+      fresh_reads += fresh;
+      newest = received.fields[0];
+    }
+  });
+  producer.join();
+  consumer.join();
+
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_EQUAL(0, went_back);
+  TEST_ASSERT_EQUAL(MAILBOX_WRITES, newest);
+  TEST_ASSERT_TRUE(fresh_reads > 0);
+}
+// TESTS END
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_channel_keeps_items_in_order);
+  RUN_TEST(test_mailbox_hands_out_whole_snapshots);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+/*
+    Runs the firmware in virtual time and checks that the control loop keeps
+    ticking through transient screens and settings writes, no state may hold
+    it up longer than TICK_PERIOD_BOUND.
+
+    pio test -e native -f test_control_loop
+
+    Every Preferences write costs PREFERENCES_WRITE_COST like NVS does on the
+    ESP32, so a state writing settings in a burst shows up as well.
+
+    The firmware keeps its state in globals and its tasks never end, so every
+    test boots it in a child process of its own, like the programs in sim/ do:
+    each test starts in default_start at virtual time zero, alone or in any order.
+*/
+
+#include <RouterLift.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+#define TICK_PERIOD_BOUND       10000 // [us] a tick, a display frame in between and a couple of settings writes
+#define PREFERENCES_WRITE_COST  1000  // [us]
+#define BOOT_DURATION           500   // [ms]
+#define BUTTON_PRESS_DURATION   100   // [ms] shorter than DURATION_BUTTON_HOLD
+#define BUTTON_HOLD_DURATION    1000  // [ms] longer than DURATION_BUTTON_HOLD
+#define INPUT_LATENCY           50    // [ms] inputs are collected between display frames
+#define SETTINGS_TURNS          20    // encoder steps per settings page
+
+// HELPERS START
+void press_button(uint8_t pin, unsigned long duration) {
+  hal_set_input(pin, LOW);
+  hal_run_for(duration * 1000);
+  hal_set_input(pin, HIGH);
+  hal_run_for(INPUT_LATENCY * 1000);
+}
+
+void turn_encoder(long counts) {
+  for (long count = 0; count < labs(counts); count++) {
+    hal_encoder_turn(0, counts > 0 ? 1 : -1);
+    hal_run_for(INPUT_LATENCY * 1000);
+  }
+}
+
+void boot_firmware() {
+  hal_set_serial_echo(false);
+  hal_set_preferences_write_cost(PREFERENCES_WRITE_COST);
+  // the normally closed end stop is closed, the carriage stands below it
+  hal_set_input(PIN_SENSOR_END_STOP_TRIGGER, LOW);
+  hal_begin();
+  hal_run_for(BOOT_DURATION * 1000);
+}
+
+// Unity in the child prints what failed, the parent only learns whether it did
+void run_booted(void (*test)()) {
+  fflush(stdout);
+  pid_t child = fork();
+  if (child == 0) {
+    volatile bool passed = false;
+    if (TEST_PROTECT()) {
+      boot_firmware();
+      TEST_ASSERT_EQUAL(default_start, current_state);
+      test();
+      passed = true;
+    }
+    fflush(stdout);
+    _exit(passed ? 0 : 1);
+  }
+  int status = 0;
+  TEST_ASSERT_TRUE_MESSAGE(child > 0, "no child process");
+  waitpid(child, &status, 0);
+  TEST_ASSERT_TRUE_MESSAGE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "failed in its child");
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+// HELPERS END
+
+// TESTS START
+void settings_menu_does_not_stall() {
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_HOLD_DURATION);
+  TEST_ASSERT_EQUAL(settings_menu, current_state);
+  for (long page = 0; page < SETTINGS_PAGES_COUNT; page++) {
+    turn_encoder(page % 2 ? -SETTINGS_TURNS : SETTINGS_TURNS);
+    press_button(PIN_BUTTON_SET_ZERO, BUTTON_PRESS_DURATION);
+  }
+  TEST_ASSERT_LESS_THAN(TICK_PERIOD_BOUND + 1, status_tick_period_maximal);
+}
+
+// the reset screen is shown for DURATION_SHOW_MESSAGE while the loop goes on
+void reset_screen_does_not_stall() {
+  press_button(PIN_BUTTON_SET_ZERO, BUTTON_HOLD_DURATION);
+  TEST_ASSERT_EQUAL(settings_menu, current_state);
+  press_button(PIN_BUTTON_GOTO_BOTTOM, BUTTON_HOLD_DURATION);
+  TEST_ASSERT_EQUAL(reset, current_state);
+  hal_run_for(DURATION_SHOW_MESSAGE * 1000);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+  TEST_ASSERT_LESS_THAN(TICK_PERIOD_BOUND + 1, status_tick_period_maximal);
+}
+
+// jogging with the encoder while the motion task steps on the other core
+void moving_does_not_stall() {
+  turn_encoder(5);
+  hal_run_for(DURATION_SHOW_MESSAGE * 1000);
+  TEST_ASSERT_LESS_THAN(TICK_PERIOD_BOUND + 1, status_tick_period_maximal);
+}
+
+void test_settings_menu_does_not_stall() {
+  run_booted(settings_menu_does_not_stall);
+}
+
+void test_reset_screen_does_not_stall() {
+  run_booted(reset_screen_does_not_stall);
+}
+
+void test_moving_does_not_stall() {
+  run_booted(moving_does_not_stall);
+}
+// TESTS END
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_settings_menu_does_not_stall);
+  RUN_TEST(test_reset_screen_does_not_stall);
+  RUN_TEST(test_moving_does_not_stall);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+/*
+    Checks the pitch error table both ways on the host: interpolate_pitch()
+    from the screw to the carriage and back, and the table update_pitch_table()
+    sends from the settings.
+
+    pio test -e native -f test_pitch_table
+
+    No task runs here, the commands update_pitch_table() sends are dropped and
+    the table is taken from motion_pitch_tables like the motion task would.
+*/
+
+#include <RouterLift.h>
+#include <unity.h>
+
+#define SWEEP_BEYOND 3 // [points] past both ends of the table
+
+// HELPERS START
+void drop_motion_commands() {
+  motion_command command;
+  while (motion_commands.pop(command)) {
+  }
+}
+
+// sets every error of the settings menu, the pages clamp them like a user turning the encoder does
+void set_pitch_errors(float (*error_of)(long point)) {
+  for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+    preference_pitch_point = point;
+    preference_pitch_errors[point] = 0.0;
+    change_setting(25, lround(error_of(point) / PITCH_ERROR_DISTANCE));
+  }
+}
+
+float alternating_beyond_maximal(long point) {
+  return point % 2 ? 2 * PITCH_ERROR_MAXIMAL : -2 * PITCH_ERROR_MAXIMAL;
+}
+
+float growing(long point) {
+  return 0.05 * (point + 1);
+}
+
+motion_pitch_table sent_pitch_table() {
+  motion_pitch_table table = {};
+  update_pitch_table();
+  drop_motion_commands();
+  motion_pitch_tables.read(table);
+  return table;
+}
+
+long to_carriage(const motion_pitch_table &table, long screw) {
+  return interpolate_pitch(screw, table.screw, table.carriage, table.count);
+}
+
+long to_screw(const motion_pitch_table &table, long carriage) {
+  return interpolate_pitch(carriage, table.carriage, table.screw, table.count);
+}
+
+long spacing() {
+  return lround(PITCH_TABLE_SPACING / mm_per_step());
+}
+
+// [steps] one down the screw from the end stop
+long down() {
+  return -preference_motor_direction;
+}
+
+void setUp() {
+  hal_preferences_reset();
+  read_settings();
+  status_machine_referenced = true;
+  drop_motion_commands();
+}
+
+void tearDown() {
+}
+// HELPERS END
+
+// TESTS START
+void test_unreferenced_machine_gets_perfect_screw() {
+  set_pitch_errors(growing);
+  status_machine_referenced = false;
+  TEST_ASSERT_EQUAL(0, sent_pitch_table().count);
+  status_machine_referenced = true;
+  TEST_ASSERT_EQUAL(PITCH_TABLE_POINTS + 1, sent_pitch_table().count);
+}
+
+void test_empty_table_is_perfect_screw() {
+  motion_pitch_table table = sent_pitch_table();
+  TEST_ASSERT_EQUAL(0, table.count);
+  for (long screw = -1000; screw <= 1000; screw += 7) {
+    TEST_ASSERT_EQUAL(screw, to_carriage(table, screw));
+    TEST_ASSERT_EQUAL(screw, to_screw(table, screw));
+  }
+}
+
+// the carriage never goes back while the motor turns one way, even between errors of opposite sign
+void test_carriage_is_monotonic_along_screw() {
+  set_pitch_errors(alternating_beyond_maximal);
+  motion_pitch_table table = sent_pitch_table();
+  long sweep = (PITCH_TABLE_POINTS + SWEEP_BEYOND) * spacing();
+  long last  = to_carriage(table, -sweep * down());
+  for (long steps = -sweep + 1; steps <= sweep; steps++) {
+    long carriage = to_carriage(table, steps * down());
+    TEST_ASSERT_TRUE_MESSAGE((carriage - last) * down() >= 0, "carriage went back");
+    last = carriage;
+  }
+}
+
+void test_round_trip_within_a_step() {
+  set_pitch_errors(alternating_beyond_maximal);
+  motion_pitch_table table = sent_pitch_table();
+  long sweep = (PITCH_TABLE_POINTS + SWEEP_BEYOND) * spacing();
+  for (long position = -sweep; position <= sweep; position++) {
+    TEST_ASSERT_INT_WITHIN(1, position, to_screw(table, to_carriage(table, position)));
+    TEST_ASSERT_INT_WITHIN(1, position, to_carriage(table, to_screw(table, position)));
+  }
+}
+
+void test_errors_clamp_at_maximal() {
+  set_pitch_errors(alternating_beyond_maximal);
+  motion_pitch_table table = sent_pitch_table();
+  long maximal = lround(PITCH_ERROR_MAXIMAL / mm_per_step());
+  for (long point = 0; point < PITCH_TABLE_POINTS; point++) {
+    float expected = point % 2 ? PITCH_ERROR_MAXIMAL : -PITCH_ERROR_MAXIMAL;
+    TEST_ASSERT_EQUAL_FLOAT(expected, preference_pitch_errors[point]);
+    TEST_ASSERT_EQUAL(point % 2 ? maximal : -maximal, (table.carriage[point + 1] - table.screw[point + 1]) * down());
+  }
+}
+
+// at the points the table holds exactly, between them the error goes linearly
+void test_points_and_midpoints() {
+  set_pitch_errors(growing);
+  motion_pitch_table table = sent_pitch_table();
+  TEST_ASSERT_EQUAL(0, to_carriage(table, 0));
+  for (long point = 1; point < table.count; point++) {
+    TEST_ASSERT_EQUAL(table.carriage[point], to_carriage(table, table.screw[point]));
+    TEST_ASSERT_EQUAL(table.screw[point], to_screw(table, table.carriage[point]));
+    long middle = (table.screw[point - 1] + table.screw[point]) / 2;
+    TEST_ASSERT_INT_WITHIN(1, (table.carriage[point - 1] + table.carriage[point]) / 2, to_carriage(table, middle));
+  }
+}
+
+// above the end stop the screw is perfect, beyond the last point the error stays that of the last point
+void test_beyond_the_ends() {
+  set_pitch_errors(growing);
+  motion_pitch_table table = sent_pitch_table();
+  long last  = table.count - 1;
+  long error = table.carriage[last] - table.screw[last];
+  for (long beyond = 1; beyond <= SWEEP_BEYOND * spacing(); beyond += 13) {
+    TEST_ASSERT_EQUAL(-beyond * down(), to_carriage(table, -beyond * down()));
+    TEST_ASSERT_EQUAL(-beyond * down(), to_screw(table, -beyond * down()));
+    long screw = table.screw[last] + beyond * down();
+    TEST_ASSERT_EQUAL(screw + error, to_carriage(table, screw));
+    TEST_ASSERT_EQUAL(screw, to_screw(table, screw + error));
+  }
+}
+// TESTS END
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_unreferenced_machine_gets_perfect_screw);
+  RUN_TEST(test_empty_table_is_perfect_screw);
+  RUN_TEST(test_carriage_is_monotonic_along_screw);
+  RUN_TEST(test_round_trip_within_a_step);
+  RUN_TEST(test_errors_clamp_at_maximal);
+  RUN_TEST(test_points_and_midpoints);
+  RUN_TEST(test_beyond_the_ends);
+  return UNITY_END();
+}
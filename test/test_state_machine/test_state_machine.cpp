@@ -0,0 +1,144 @@
+/*
+    Drives dispatch() through event sequences on the host and checks the
+    states it ends up in, the tables of Control.cpp as they are.
+
+    pio test -e native -f test_state_machine
+
+    No task runs here: millis() is the virtual time hal_run_for() advanced
+    to, and the motion commands the entries send are dropped after every
+    event, nobody would take them otherwise.
+*/
+
+#include <RouterLift.h>
+#include <unity.h>
+
+// HELPERS START
+void drop_motion_commands() {
+  motion_command command;
+  while (motion_commands.pop(command)) {
+  }
+}
+
+void inject(enum events event) {
+  dispatch(event);
+  drop_motion_commands();
+}
+
+// lets the minimum duration of the state pass
+void wait(unsigned long duration) {
+  hal_run_for(duration * 1000);
+}
+
+void start_in(enum states state) {
+  current_state = state;
+  current_state_entered_at = millis();
+}
+
+void setUp() {
+  hal_preferences_reset();
+  read_settings();
+  drop_motion_commands();
+  start_in(default_start);
+}
+
+void tearDown() {
+}
+// HELPERS END
+
+// TESTS START
+void test_settings_menu_round_trip() {
+  inject(event_set_zero_hold);
+  TEST_ASSERT_EQUAL(settings_menu, current_state);
+  inject(event_set_zero_press); // next page, the state stays
+  TEST_ASSERT_EQUAL(settings_menu, current_state);
+  inject(event_set_zero_hold);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+}
+
+void test_minimum_duration_holds_state_changes() {
+  inject(event_set_zero_hold);
+  inject(event_goto_bottom_hold);
+  TEST_ASSERT_EQUAL(reset, current_state);
+  inject(event_done);
+  TEST_ASSERT_EQUAL(reset, current_state);
+  wait(DURATION_SHOW_MESSAGE - 1);
+  inject(event_done);
+  TEST_ASSERT_EQUAL(reset, current_state);
+  wait(1);
+  inject(event_done);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+}
+
+void test_fault_is_not_held() {
+  inject(event_set_zero_hold);
+  inject(event_goto_bottom_hold);
+  TEST_ASSERT_EQUAL(reset, current_state);
+  inject(event_fault);
+  TEST_ASSERT_EQUAL(error, current_state);
+}
+
+void test_every_state_faults_into_error() {
+  for (int state = 0; state < states_count; state++) {
+    start_in((enum states)state);
+    inject(event_fault);
+    TEST_ASSERT_EQUAL_MESSAGE(error, current_state, state_table[state].name);
+  }
+}
+
+void test_events_without_transition_are_ignored() {
+  const enum events ignored[] = { event_none, event_goto_bottom_hold, event_end_stop_trigger,
+                                  event_tool_length_trigger, event_target_reached, event_done };
+  for (enum events event : ignored) {
+    inject(event);
+    TEST_ASSERT_EQUAL(default_start, current_state);
+  }
+  start_in(error);
+  inject(event_toolchange_press);
+  inject(event_set_zero_press);
+  TEST_ASSERT_EQUAL(error, current_state);
+  inject(event_set_zero_hold);
+  TEST_ASSERT_EQUAL(settings_menu, current_state);
+}
+
+// depth passes and the feed plunge need an active target above the bit
+void test_guards_reject_without_target() {
+  inject(event_pass_start);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+  inject(event_feed_start);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+}
+
+// the first row of a cell whose guard passes wins
+void test_guarded_rows_are_tried_in_order() {
+  const bool tool_table[] = { true, false };
+  const enum states after[] = { select_tool, default_start };
+  for (int run = 0; run < 2; run++) {
+    start_in(default_start);
+    preference_tool_table_enabled = tool_table[run];
+    inject(event_toolchange_press);
+    TEST_ASSERT_EQUAL(goto_toolchange, current_state);
+    inject(event_end_stop_trigger);
+    TEST_ASSERT_EQUAL(finish_toolchange, current_state);
+    inject(event_done);
+    TEST_ASSERT_EQUAL(after[run], current_state);
+  }
+  inject(event_toolchange_press);
+  TEST_ASSERT_EQUAL(goto_toolchange, current_state);
+  inject(event_toolchange_press);
+  TEST_ASSERT_EQUAL(default_start, current_state);
+}
+// TESTS END
+
+int main(int argc, char **argv) {
+  hal_set_serial_echo(false);
+  preferences.begin("settings", false);
+  UNITY_BEGIN();
+  RUN_TEST(test_settings_menu_round_trip);
+  RUN_TEST(test_minimum_duration_holds_state_changes);
+  RUN_TEST(test_fault_is_not_held);
+  RUN_TEST(test_every_state_faults_into_error);
+  RUN_TEST(test_events_without_transition_are_ignored);
+  RUN_TEST(test_guards_reject_without_target);
+  RUN_TEST(test_guarded_rows_are_tried_in_order);
+  return UNITY_END();
+}